@@ -2,12 +2,20 @@
 /// \author Paolo Mazzon
 #include <stdio.h>
 #include <stdarg.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <limits.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define JU_X86_SIMD // Batch collision kernels can use SSE2/AVX, which one is picked at runtime
+#endif
+#ifndef JU_HEADLESS
 #include <VK2D/stb_image.h>
 #include <SDL2/SDL_syswm.h>
-#include <pthread.h>
 
 
 #include "cute_sound.h"
+#endif // JU_HEADLESS
 #include "JamUtil.h"
 
 /********************** Constants **********************/
@@ -17,12 +25,33 @@ const uint32_t JU_STRING_BUFFER = 1024;         // Maximum amount of text that c
 const uint32_t JU_SAVE_MAX_SIZE = 2000;         // Maximum pieces of data that can be loaded from a save, anything more than this is probably a corrupt file
 const uint32_t JU_SAVE_MAX_KEY_SIZE = 20;       // Maximum size a save key can be
 const int JU_LIST_EXTENSION = 5;                // How many elements to extend lists by
+const int JU_SPARSE_PAGE_SIZE = 1024;           // Number of entities covered by each page of a sparse component's lookup
+const int JU_ECS_CHUNK_SIZE = 1024;             // Number of components/entities in each ECS chunk, chunks never move once allocated
+const int JU_SPATIAL_GRID_BUCKETS = 1024;       // Starting number of buckets in a spatial grid, must be a power of 2
+const int JU_SWEEP_PAIR_SLOTS = 256;            // Starting number of slots in a sweep and prune's pair set, must be a power of 2
+const int JU_SWEEP_REBUILD_RATIO = 4;           // A sweep sorts from scratch if at least 1 in this many proxies are new
+const uint64_t JU_SWEEP_EMPTY_PAIR = UINT64_MAX; // Empty slot in a sweep and prune's pair set
+const double JU_TILE_EPSILON = 1e-6;            // Overlaps smaller than this fraction of a tile don't count, so rectangles moved flush against a tile don't catch on it
+const double JU_TRIG_ROUND = 6755399441055744.0; // 1.5 * 2^52, adding and subtracting it rounds a double to the nearest integer
+const float JU_PATH_DIAGONAL_COST = 1.41421356f;  // Cost of a diagonal step in a path, straight steps cost 1
+const uint8_t JU_FLOW_NONE = 4;                 // Flow field direction of tiles with nowhere to go, the middle of the 3x3 block around a tile
+const int JU_FLOW_JOB_SIZE = 16384;             // Minimum number of tiles in a flow field before its directions are split into jobs
+const double JU_FLOW_DIRECTIONS[9][2] = {       // Unit vector of each flow field direction
+		{-0.70710678118654752, -0.70710678118654752}, {0, -1}, {0.70710678118654752, -0.70710678118654752},
+		{-1, 0}, {0, 0}, {1, 0},
+		{-0.70710678118654752, 0.70710678118654752}, {0, 1}, {0.70710678118654752, 0.70710678118654752},
+};
+const int JU_TRANSFORM_JOB_SIZE = 4096;         // Minimum number of transforms in a level before its propagation is split into jobs
+const size_t JU_RESOURCE_ALIGNMENT = 16;        // Alignment of each ECS resource
 const JUEntityID JU_INVALID_ENTITY = -1;
 const JUComponentID JU_NO_COMPONENT = -1;
 const int JU_JOB_CHANNEL_SYSTEMS = 0;
 const int JU_JOB_CHANNEL_COPY = 1;
 const int32_t JU_DISABLED_LOCK = -1;
 const JUEntityType JU_INVALID_TYPE = 0;
+const JURegion JU_NO_REGION = -1;
+const JUProxy JU_NO_PROXY = -1;
+const uint32_t JU_REGION_VERSION = 1;           // Version of region files, bump it whenever their layout changes
 
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 uint32_t RMASK = 0xff000000;
@@ -58,31 +87,245 @@ typedef struct JUJobSystem {
 	pthread_t *threads;          ///< Thread vector
 	int queueListSize;           ///< Actual size of the queue vector
 	int queueSize;               ///< Number of elements waiting in the queue
+	int queueStart;              ///< Index of the front of the queue (its a ring buffer)
 	JUJob *queue;                ///< Queue (vector)
 	pthread_mutex_t queueAccess; ///< Mutex that protects access to the queue
 	_Atomic int *channels;       ///< Variable number of channels
 	int channelCount;            ///< Number of available channels
 	_Atomic bool kill;           ///< For shutting down all jobs
+	_Atomic uint64_t waitTicks;  ///< Performance counter ticks spent waiting on channels since the ECS last read it
 } JUJobSystem;
 
+/// \brief A fixed-size block of a component list, it never moves once allocated so pointers into it stay valid
+typedef struct JUComponentChunk {
+	uint8_t *current;         ///< This frame's components, each one followed by its active byte
+	uint8_t *previous;        ///< Previous frame's components, same layout as current
+	JUEntityID *owners;       ///< Which entity owns each component
+	uint32_t *versions;       ///< Frame + 1 each component was last written through `juECSGetComponent` (0 for never)
+	_Atomic uint32_t version; ///< Newest version of any component in the chunk, lives with the chunk so growing the directory never loses a bump
+} JUComponentChunk;
+
+/// \brief A growable list of entities
+typedef struct JUEntityList {
+	JUEntityID *entities; ///< Entities in the list
+	int count;            ///< Number of entities in the list
+	int listSize;         ///< Actual size of the list
+} JUEntityList;
+
+/// \brief Entities that had a component added, removed or changed over a frame
+typedef struct JUECSEvents {
+	JUEntityList added;   ///< Entities that got the component
+	JUEntityList removed; ///< Entities that were destroyed with the component
+	JUEntityList changed; ///< Entities whose component was written to
+} JUECSEvents;
+
+/// \brief Storage information for a sparse component, whose components are packed at the front of its list
+typedef struct JUSparseSet {
+	_Atomic(_Atomic(JUComponentID*)*) pages; ///< Pages of entity -> packed index lookups, only allocated once an entity in that range needs one
+	_Atomic int pageCount;                   ///< Number of page pointers
+	int count;                      ///< Number of packed components
+} JUSparseSet;
+
+/// \brief A single frame in the ECS history ring
+typedef struct JUECSHistoryFrame {
+	JUFrame frame;        ///< Frame this state belongs to
+	uint32_t *sizes;      ///< Size in bytes of each stream on this frame
+	uint8_t **deltas;     ///< Encoded XOR between each stream on this frame and the next frame (NULL for the newest frame)
+	uint32_t *deltaSizes; ///< Size in bytes of each encoded delta
+} JUECSHistoryFrame;
+
+/// \brief Ring of previous ECS states, each stream is a component list and the last stream is the entity table
+typedef struct JUECSHistory {
+	int capacity;               ///< Maximum number of frames kept, 0 if the history is disabled
+	int start;                  ///< Index of the oldest frame in the ring
+	int count;                  ///< Number of frames currently in the ring
+	int streamCount;            ///< Number of streams recorded each frame
+	JUECSHistoryFrame *frames;  ///< Ring of frames
+	uint8_t **latest;           ///< Full state of each stream on the newest frame
+	uint32_t *latestSizes;      ///< Size in bytes of each latest stream
+	uint8_t *scratch;           ///< Scratch buffer for encoding deltas
+	uint32_t scratchSize;       ///< Size of the scratch buffer
+	uint8_t *gather;            ///< Buffer chunked streams are gathered into so they can be diffed
+	uint32_t gatherSize;        ///< Size of the gather buffer
+	_Atomic bool resimulating;  ///< True while `juECSHistoryResimulate` is running frames
+} JUECSHistory;
+
+/// \brief One cell a proxy in a spatial grid covers
+typedef struct JUSpatialGridEntry {
+	int32_t cellX;     ///< x of the cell this entry is in
+	int32_t cellY;     ///< y of the cell this entry is in
+	int32_t proxy;     ///< Proxy this entry belongs to
+	int32_t next;      ///< Next entry in the same bucket, -1 for none
+	int32_t prev;      ///< Previous entry in the same bucket, -1 for none
+	int32_t proxyNext; ///< Next entry that belongs to the same proxy (or the next free entry)
+} JUSpatialGridEntry;
+
+/// \brief Something stored in a spatial grid
+typedef struct JUSpatialGridProxy {
+	JURectangle bounds; ///< Bounds of the proxy
+	JUCircle circle;    ///< Circle the proxy is if `isCircle` is true
+	bool isCircle;      ///< Whether the proxy is a circle or just its bounds
+	int32_t minX;       ///< Left-most cell the proxy covers
+	int32_t minY;       ///< Top-most cell the proxy covers
+	int32_t maxX;       ///< Right-most cell the proxy covers
+	int32_t maxY;       ///< Bottom-most cell the proxy covers
+	int32_t entries;    ///< First entry that belongs to this proxy, -1 if it isn't in the grid
+	int32_t nextFree;   ///< Next proxy in the free list (only meaningful for removed proxies)
+} JUSpatialGridProxy;
+
+/// \brief Instruction sets the batch collision kernels can use
+typedef enum {
+	JU_SIMD_UNKNOWN = 0, ///< Not checked yet
+	JU_SIMD_NONE = 1,    ///< Plain C
+	JU_SIMD_SSE2 = 2,    ///< 2 doubles at a time
+	JU_SIMD_AVX = 3,     ///< 4 doubles at a time
+} JUSIMDLevel;
+
+/// \brief Checks up to 64 shapes in a batch starting at start against one shape, bit i of the result is for shape start + i
+typedef uint64_t (*JUBatchKernel)(const void *shape, const void *batch, int start, int n);
+
+/// \brief A node in an AABB tree, leaves are proxies
+typedef struct JUAABBTreeNode {
+	double minX;        ///< Left of the fat box (leaves) or the box around both children
+	double minY;        ///< Top of the box
+	double maxX;        ///< Right of the box
+	double maxY;        ///< Bottom of the box
+	JURectangle bounds; ///< Exact bounds of a leaf
+	int32_t parent;     ///< Parent node, -1 for the root (or the next free node for nodes in the pool)
+	int32_t child1;     ///< First child, -1 for leaves
+	int32_t child2;     ///< Second child, -1 for leaves
+	int32_t height;     ///< 0 for leaves, -1 for nodes in the pool
+} JUAABBTreeNode;
+
+/// \brief A proxy in a sweep and prune
+typedef struct JUSweepProxy {
+	JURectangle rect; ///< Current bounds
+	int32_t nextFree; ///< Next proxy in the free list (only meaningful for freed proxies)
+	int32_t pairs;    ///< Number of pairs this proxy is in, so edges passing proxies with no pairs skip the pair set
+	bool alive;       ///< False once removed
+} JUSweepProxy;
+
+/// \brief One edge of a proxy along one axis
+typedef struct JUSweepEndpoint {
+	double value; ///< Position of the edge
+	int32_t data; ///< Proxy << 1, with the low bit set for the max edge
+} JUSweepEndpoint;
+
+/// \brief An open tile in a pathfinder's heap
+typedef struct JUPathNode {
+	float priority; ///< Cost so far plus the estimate to the goal
+	int32_t tile;   ///< Tile index
+} JUPathNode;
+
+/// \brief A band of rows in a flow field to work out the directions of
+typedef struct JUFlowFieldJob {
+	JUFlowField field; ///< Field the rows are in
+	int start;         ///< First row
+	int end;           ///< One past the last row
+} JUFlowFieldJob;
+
+/// \brief A child's transform and its parent's transform, stored by depth for propagation
+typedef struct JUTransformLink {
+	JUComponentID child;  ///< Child's transform component
+	JUComponentID parent; ///< Parent's transform component, JU_NO_COMPONENT for roots
+} JUTransformLink;
+
+/// \brief A range of a hierarchy level being propagated by a job
+typedef struct JUTransformJob {
+	int start; ///< First link to propagate
+	int end;   ///< One past the last link to propagate
+} JUTransformJob;
+
+/// \brief A single batch of a parallel query walk
+typedef struct JUECSQueryJob {
+	JUECSQuery query; ///< Query being walked
+	int batch;        ///< Batch this job collects
+} JUECSQueryJob;
+
+/// \brief A group of entities that can be streamed to and from disk
+typedef struct JUStreamRegion {
+	const char *filename;        ///< File the region is saved to and loaded from
+	_Atomic JURegionState state; ///< Where the region's entities are, I/O jobs set this when they finish
+	JUEntityList members;        ///< Entities added to the region, including ones that have since been destroyed or moved
+	int cursor;                  ///< Next member to save while unloading
+	bool writing;                ///< True once every member is saved and the file is being written
+	_Atomic bool ready;          ///< True once a loading region's data has been read and checked
+	uint8_t *data;               ///< Region file being built or spawned from
+	uint32_t size;               ///< Size of the region file in bytes
+	uint32_t dataListSize;       ///< Actual size of the data buffer
+	uint32_t position;           ///< Next byte to spawn from while loading
+	uint32_t remaining;          ///< Entities saved so far while unloading, or left to spawn while loading
+} JUStreamRegion;
+
 /// \brief Information for ECS
 typedef struct JUECS {
-	JUEntity *entities;                    ///< Vector of all entities
-	int entityCount;                       ///< Number of entities
+	_Atomic(JUEntity**) entityChunks;      ///< Directory of entity chunks, each holding JU_ECS_CHUNK_SIZE entities
+	int entityDirectorySize;               ///< Number of chunk pointers the entity directory has room for
+	int entityCount;                       ///< Number of entities (always a multiple of the chunk size)
 	JUSystem *systems;               ///< List of all systems
 	int systemCount;                       ///< Amount of systems
 	_Atomic bool *systemFinished;          ///< Whether or not each system is done executing this frame
-	JUComponentVector* previousComponents; ///< Previous frame's components
-	JUComponentVector *components;         ///< This frame's components
+	_Atomic(JUComponentChunk**) *componentChunks; ///< Directory of chunk pointers for each component list
+	int *componentDirectorySizes;          ///< Number of chunks each component's directory has room for
 	const int componentCount;              ///< Amount of components
 	const size_t *componentSizes;          ///< Size of each component in bytes
-	int *componentListSizes;               ///< Actual size of component list
+	_Atomic int *componentListSizes;       ///< Actual size of component list (always a multiple of the chunk size)
+	int *componentFreeHints;               ///< Every component before this index is known to be in use
+	int *denseIndices;                     ///< Where each component is in an entity's component list, -1 for sparse components
+	int denseCount;                        ///< Number of components that are in each entity's component list
+	JUSparseSet *sparseSets;               ///< Sparse storage for each component (only used by sparse components)
+	bool *trackedComponents;               ///< Whether or not events are recorded for each component
+	uint8_t *resources;                    ///< This frame's resources, one after another
+	uint8_t *previousResources;            ///< Previous frame's resources, same layout
+	size_t *resourceOffsets;               ///< Where each resource is in the resource blocks
+	int resourceCount;                     ///< Number of resources
+	size_t resourcesSize;                  ///< Size of each resource block in bytes
+	int compactionBudget;                  ///< Maximum number of components moved to fill holes during each copy
+	JUECSEvents *pendingEvents;            ///< Events for each component being recorded this frame
+	JUECSEvents *events;                   ///< Events for each component from the last frame that finished copying
+	int entityFreeHint;                    ///< Every entity before this index is known to exist
 	pthread_mutex_t createEntityAccess;    ///< Lock so only 1 entity may be created at a time
 	int entityIterator;                    ///< Basically the i value for the entity iterating functions
+	JUFrame frame;                         ///< Number of times state has been copied
+	JUSystemStats *systemStats;            ///< Stats for each system being recorded this frame
+	JUECSStats stats[2];                   ///< Last two frames of published stats
+	JUPipelineMode pipelineMode;           ///< How simulation overlaps with the main thread
+	bool framePipelined;                   ///< Whether or not this frame's copy is queued by whichever system finishes last
+	_Atomic int systemsRemaining;          ///< Systems still running this frame plus one for `juECSCopyState`, only used when pipelined
+	bool renderFirst;                      ///< Whether or not render systems are queued before simulation systems
+	_Atomic int statsIndex;                ///< Which stats are the newest
+	JUECSHistory history;                  ///< Previous states for rollback/interpolation
+	bool spatialEnabled;                   ///< Whether or not the ECS keeps a spatial hash
+	JUComponent spatialComponent;          ///< Component entities are put in the spatial hash by
+	void (*spatialBounds)(const void *component, JURectangle *bounds); ///< Gets bounds from the spatial component, NULL if it starts with a JURectangle
+	JUSpatialGrid spatial;                 ///< Spatial grid of every entity with the spatial component, as of the last copy
+	JUEntityList spatialAdded;             ///< Entities that got the spatial component since the last copy
+	bool transformEnabled;                 ///< Whether or not transforms are propagated during the copy
+	JUComponent transformComponent;        ///< Component that starts with a JUTransform
+	_Atomic bool hierarchyDirty;           ///< True if the levels need to be rebuilt before the next propagation
+	JUTransformLink *links;                ///< Every transform sorted by depth in the hierarchy
+	int linkListSize;                      ///< Actual size of the link list
+	int *levels;                           ///< Where each level starts in the link list, with one extra for the end of the last level
+	int levelCount;                        ///< Number of levels in the hierarchy
+	int levelListSize;                     ///< Actual size of the level list
+	JUTransformJob *transformJobs;         ///< Job data for propagating the widest level in parallel
+	int transformJobListSize;              ///< Actual size of the transform job list
+	void **retired;                        ///< Outgrown directories that running systems may still be reading, freed during the copy
+	int retiredCount;                      ///< Number of retired directories
+	int retiredListSize;                   ///< Actual size of the retired list
+	bool streamingEnabled;                 ///< Whether or not regions can be streamed
+	int streamChannel;                     ///< Job channel region files are read and written on
+	int spawnBudget;                       ///< Maximum entities spawned from regions per copy, 0 for no limit
+	int despawnBudget;                     ///< Maximum entities saved to regions per copy, 0 for no limit
+	JUStreamRegion **regions;              ///< Every region, pointers so jobs can hold onto them while the list grows
+	int regionCount;                       ///< Number of regions
+	int regionListSize;                    ///< Actual size of the region list
 } JUECS;
 
 /********************** Globals **********************/
+#ifndef JU_HEADLESS
 static cs_context_t *gSoundContext = NULL;               // For the audio player
+#endif // JU_HEADLESS
 static int gKeyboardSize = 0;                            // For keeping track of keys through SDL
 static uint8_t *gKeyboardState, *gKeyboardPreviousState; // Arrays for key states through SDL
 static double gDelta = 0;                                // Delta time
@@ -90,6 +333,8 @@ static uint64_t gLastTime = 0;                           // For keeping track of
 static uint64_t gProgramStartTime = 0;                   // Time when the program started
 static JUJobSystem gJobSystem;                           // Information for the job system
 static JUECS gECS;                                       // Entity component system
+static _Thread_local int gCurrentSystem = -1;            // System running on this thread, if any
+static _Atomic JUSIMDLevel gSIMDLevel = JU_SIMD_UNKNOWN; // Batch collision kernels this CPU can run
 
 /********************** Static Functions **********************/
 
@@ -139,6 +384,12 @@ static void juFree(void *ptr) {
 	free(ptr);
 }
 
+// How many elements to extend a list of a given size by, lists double so filling them isn't quadratic
+static int juListGrowth(int size) {
+	return size > JU_LIST_EXTENSION ? size : JU_LIST_EXTENSION;
+}
+
+#ifndef JU_HEADLESS
 // Hashes a string into a 32 bit number between 0 and JU_BUCKET_SIZE
 static uint32_t juHash(const char *string) {
 	uint32_t hash = 5381;
@@ -163,6 +414,7 @@ static uint32_t juLastDot(const char *string) {
 
 	return dot;
 }
+#endif // JU_HEADLESS
 
 // Copies a string
 static const char *juCopyString(const char *string) {
@@ -171,6 +423,7 @@ static const char *juCopyString(const char *string) {
 	return out;
 }
 
+#ifndef JU_HEADLESS
 // Swaps bytes between little and big endian
 static void juSwapEndian(void *bytes, uint32_t size) {
 	uint8_t new[size];
@@ -185,6 +438,7 @@ static void juCopyFromBigEndian(void *dst, void *src, uint32_t size) {
 	juSwapEndian(dst, size);
 #endif // SDL_LIL_ENDIAN
 }
+#endif // JU_HEADLESS
 
 // Dumps a file into a binary buffer (free it yourself)
 static uint8_t *juGetFile(const char *filename, uint32_t *size) {
@@ -211,6 +465,7 @@ static uint8_t *juGetFile(const char *filename, uint32_t *size) {
 	return buffer;
 }
 
+#ifndef JU_HEADLESS
 // Loads all jufnt data into a struct
 static JUBinaryFont juLoadBinaryFont(const char *file, bool *error) {
 	JUBinaryFont font = {};
@@ -254,6 +509,145 @@ static JUBinaryFont juLoadBinaryFont(const char *file, bool *error) {
 
 	return font;
 }
+#endif // JU_HEADLESS
+
+// Frees everything in the ECS (defined with the rest of the ECS)
+static void juECSQuit();
+
+// Copies the current frame into the previous frame (defined with the rest of the ECS)
+static void juECSJobCopy(void *ptr);
+
+// Which bucket a cell goes in
+static inline int juSpatialGridBucket(const JUSpatialGrid grid, int32_t x, int32_t y) {
+	return (int)((((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u)) & (uint32_t)(grid->bucketCount - 1));
+}
+
+// Which cell a coordinate is in
+static inline int32_t juSpatialGridCell(const JUSpatialGrid grid, double x) {
+	return (int32_t)floor(x / grid->cellSize);
+}
+
+// Puts an entry at the front of its cell's bucket
+static void juSpatialGridLink(JUSpatialGrid grid, int32_t entry) {
+	JUSpatialGridEntry *e = &grid->entries[entry];
+	int bucket = juSpatialGridBucket(grid, e->cellX, e->cellY);
+	e->prev = -1;
+	e->next = grid->buckets[bucket];
+	if (e->next != -1)
+		grid->entries[e->next].prev = entry;
+	grid->buckets[bucket] = entry;
+}
+
+// Takes an entry out of its bucket
+static void juSpatialGridUnlink(JUSpatialGrid grid, int32_t entry) {
+	JUSpatialGridEntry *e = &grid->entries[entry];
+	if (e->prev != -1)
+		grid->entries[e->prev].next = e->next;
+	else
+		grid->buckets[juSpatialGridBucket(grid, e->cellX, e->cellY)] = e->next;
+	if (e->next != -1)
+		grid->entries[e->next].prev = e->prev;
+}
+
+// Doubles the bucket count and relinks every entry once buckets get crowded
+static void juSpatialGridGrowBuckets(JUSpatialGrid grid) {
+	grid->bucketCount *= 2;
+	grid->buckets = juRealloc(grid->buckets, sizeof(int32_t) * grid->bucketCount);
+	for (int i = 0; i < grid->bucketCount; i++)
+		grid->buckets[i] = -1;
+	for (int i = 0; i < grid->proxyCount; i++)
+		for (int32_t entry = grid->proxies[i].entries; entry != -1; entry = grid->entries[entry].proxyNext)
+			juSpatialGridLink(grid, entry);
+}
+
+// Takes a proxy out of every cell, returning its entries to the pool
+static void juSpatialGridClear(JUSpatialGrid grid, int32_t proxy) {
+	if (proxy >= grid->proxyCount)
+		return;
+	int32_t entry = grid->proxies[proxy].entries;
+	while (entry != -1) {
+		int32_t next = grid->entries[entry].proxyNext;
+		juSpatialGridUnlink(grid, entry);
+		grid->entries[entry].proxyNext = grid->freeEntries;
+		grid->freeEntries = entry;
+		grid->liveEntries--;
+		entry = next;
+	}
+	grid->proxies[proxy].entries = -1;
+}
+
+// Inserts or moves a proxy by id, it is only re-bucketed if the cells it covers change
+static void juSpatialGridSet(JUSpatialGrid grid, int32_t proxy, const JURectangle *bounds) {
+	if (proxy >= grid->proxyListSize) {
+		int size = proxy + juListGrowth(proxy);
+		grid->proxies = juRealloc(grid->proxies, sizeof(struct JUSpatialGridProxy) * size);
+		grid->proxyListSize = size;
+	}
+	for (int i = grid->proxyCount; i <= proxy; i++)
+		grid->proxies[i].entries = -1;
+	if (proxy >= grid->proxyCount)
+		grid->proxyCount = proxy + 1;
+
+	JUSpatialGridProxy *p = &grid->proxies[proxy];
+	int32_t minX = juSpatialGridCell(grid, bounds->x);
+	int32_t minY = juSpatialGridCell(grid, bounds->y);
+	int32_t maxX = juSpatialGridCell(grid, bounds->x + bounds->w);
+	int32_t maxY = juSpatialGridCell(grid, bounds->y + bounds->h);
+	p->bounds = *bounds;
+	p->isCircle = false;
+	if (p->entries != -1 && minX == p->minX && minY == p->minY && maxX == p->maxX && maxY == p->maxY)
+		return;
+
+	juSpatialGridClear(grid, proxy);
+	p->minX = minX;
+	p->minY = minY;
+	p->maxX = maxX;
+	p->maxY = maxY;
+	for (int32_t y = minY; y <= maxY; y++) {
+		for (int32_t x = minX; x <= maxX; x++) {
+			int32_t entry = grid->freeEntries;
+			if (entry != -1) {
+				grid->freeEntries = grid->entries[entry].proxyNext;
+			} else {
+				if (grid->entryCount == grid->entryListSize) {
+					grid->entryListSize += juListGrowth(grid->entryListSize);
+					grid->entries = juRealloc(grid->entries, sizeof(struct JUSpatialGridEntry) * grid->entryListSize);
+				}
+				entry = grid->entryCount++;
+			}
+
+			JUSpatialGridEntry *e = &grid->entries[entry];
+			e->cellX = x;
+			e->cellY = y;
+			e->proxy = proxy;
+			e->proxyNext = p->entries;
+			p->entries = entry;
+			juSpatialGridLink(grid, entry);
+			grid->liveEntries++;
+		}
+	}
+
+	if (grid->liveEntries > grid->bucketCount * 2)
+		juSpatialGridGrowBuckets(grid);
+}
+
+// Checks a circle against a rectangle using the closest point in the rectangle to the circle
+static bool juCircleRectangleCollision(const JUCircle *circle, const JURectangle *rect) {
+	double x = circle->x < rect->x ? rect->x : (circle->x > rect->x + rect->w ? rect->x + rect->w : circle->x);
+	double y = circle->y < rect->y ? rect->y : (circle->y > rect->y + rect->h ? rect->y + rect->h : circle->y);
+	return ((circle->x - x) * (circle->x - x)) + ((circle->y - y) * (circle->y - y)) < circle->r * circle->r;
+}
+
+// Exact check between two proxies' shapes
+static bool juSpatialGridProxiesCollide(const JUSpatialGridProxy *p1, const JUSpatialGridProxy *p2) {
+	if (p1->isCircle && p2->isCircle)
+		return juCircleCollision((JUCircle*)&p1->circle, (JUCircle*)&p2->circle);
+	if (p1->isCircle)
+		return juCircleRectangleCollision(&p1->circle, &p2->bounds);
+	if (p2->isCircle)
+		return juCircleRectangleCollision(&p2->circle, &p1->bounds);
+	return juRectangleCollision((JURectangle*)&p1->bounds, (JURectangle*)&p2->bounds);
+}
 
 // Worker thread
 static void *juWorkerThread(void *data) {
@@ -265,10 +659,9 @@ static void *juWorkerThread(void *data) {
 		haveJob = false;
 		pthread_mutex_lock(&gJobSystem.queueAccess);
 		if (gJobSystem.queueSize > 0) {
-			job = gJobSystem.queue[0];
+			job = gJobSystem.queue[gJobSystem.queueStart];
 			haveJob = true;
-			for (int i = 0; i < gJobSystem.queueSize - 1; i++)
-				gJobSystem.queue[i] = gJobSystem.queue[i + 1];
+			gJobSystem.queueStart = (gJobSystem.queueStart + 1) % gJobSystem.queueListSize;
 			gJobSystem.queueSize--;
 		}
 		pthread_mutex_unlock(&gJobSystem.queueAccess);
@@ -286,6 +679,7 @@ static void *juWorkerThread(void *data) {
 /********************** Top-Level **********************/
 
 void juInit(SDL_Window *window, int jobChannels, int minimumThreads) {
+#ifndef JU_HEADLESS
 	// Sound
 	SDL_SysWMinfo wmInfo;
 	SDL_VERSION(&wmInfo.version)
@@ -297,6 +691,7 @@ void juInit(SDL_Window *window, int jobChannels, int minimumThreads) {
 	} else {
 		juLog("Failed to initialize sound.");
 	}
+#endif // JU_HEADLESS
 
 	// Keyboard controls
 	gKeyboardState = (void*)SDL_GetKeyboardState(&gKeyboardSize);
@@ -347,17 +742,7 @@ void juQuit() {
 	// Kill the jobs
 	if (gJobSystem.channelCount > 0) {
 		// Destroy ECS
-		for (int i = 0; i < gECS.componentCount; i++) {
-			juFree(gECS.components[i]);
-			juFree(gECS.previousComponents[i]);
-		}
-		for (int i = 0; i < gECS.entityCount; i++) {
-			juFree(gECS.entities[i].components);
-		}
-		juFree(gECS.entities);
-		juFree(gECS.previousComponents);
-		juFree(gECS.components);
-		juFree(gECS.systemFinished);
+		juECSQuit();
 
 		// Destroy job system
 		gJobSystem.kill = true;
@@ -377,8 +762,10 @@ void juQuit() {
 	gKeyboardPreviousState = NULL;
 	gKeyboardState = NULL;
 	gKeyboardSize = 0;
+#ifndef JU_HEADLESS
 	cs_shutdown_context(gSoundContext);
 	gSoundContext = NULL;
+#endif // JU_HEADLESS
 }
 
 double juDelta() {
@@ -391,895 +778,5092 @@ double juTime() {
 
 /********************** ECS **********************/
 
+// Gets the chunk a component is in
+static inline JUComponentChunk *juECSGetChunk(JUComponent component, JUComponentID id) {
+	return atomic_load_explicit(&gECS.componentChunks[component], memory_order_acquire)[id / JU_ECS_CHUNK_SIZE];
+}
+
+// Gets an entity from the entity chunks
+static inline JUEntity *juECSGetEntity(JUEntityID entity) {
+	return &gECS.entityChunks[entity / JU_ECS_CHUNK_SIZE][entity % JU_ECS_CHUNK_SIZE];
+}
+
 // Sets a component state
 static void juECSSetComponentState(JUComponent component, JUComponentID id, bool val) {
 	if (id != JU_NO_COMPONENT) {
-		*((((uint8_t *) (gECS.components[component])) + ((gECS.componentSizes[component]) + 1) * id) +
-		  gECS.componentSizes[component]) = val;
-		*((((uint8_t *) (gECS.previousComponents[component])) + ((gECS.componentSizes[component]) + 1) * id) +
-		  gECS.componentSizes[component]) = val;
+		JUComponentChunk *chunk = juECSGetChunk(component, id);
+		size_t offset = (gECS.componentSizes[component] + 1) * (id % JU_ECS_CHUNK_SIZE) + gECS.componentSizes[component];
+		chunk->current[offset] = val;
+		chunk->previous[offset] = val;
 	}
 }
 
 // Gets a component state
 static bool juECSGetComponentState(JUComponent component, JUComponentID id) {
 	if (id != JU_NO_COMPONENT)
-		return *((((uint8_t*)(gECS.components[component])) + ((gECS.componentSizes[component]) + 1) * id) + gECS.componentSizes[component]);
+		return juECSGetChunk(component, id)->current[(gECS.componentSizes[component] + 1) * (id % JU_ECS_CHUNK_SIZE) + gECS.componentSizes[component]];
 	return false;
 }
 
 static void *juECSGetComponentFromID(JUComponent component, JUComponentID id) {
 	if (id != JU_NO_COMPONENT)
-		return (((uint8_t*)gECS.components[component]) + ((gECS.componentSizes[component]) + 1) * id);
+		return juECSGetChunk(component, id)->current + (gECS.componentSizes[component] + 1) * (id % JU_ECS_CHUNK_SIZE);
 	return NULL;
 }
 
 static void *juECSGetPreviousComponentFromID(JUComponent component, JUComponentID id) {
 	if (id != JU_NO_COMPONENT)
-		return (((uint8_t*)(gECS.previousComponents[component])) + ((gECS.componentSizes[component]) + 1) * id);
+		return juECSGetChunk(component, id)->previous + (gECS.componentSizes[component] + 1) * (id % JU_ECS_CHUNK_SIZE);
 	return NULL;
 }
 
-// Creates a new components or grabs a stagnant one
-static JUComponentID juECSGetNewComponent(JUComponent component) {
-	JUComponentID id = JU_NO_COMPONENT;
+// Gets the entity that owns a component
+static JUEntityID juECSGetComponentOwner(JUComponent component, JUComponentID id) {
+	return juECSGetChunk(component, id)->owners[id % JU_ECS_CHUNK_SIZE];
+}
+
+// Sets the entity that owns a component
+static void juECSSetComponentOwner(JUComponent component, JUComponentID id, JUEntityID entity) {
+	juECSGetChunk(component, id)->owners[id % JU_ECS_CHUNK_SIZE] = entity;
+}
+
+// Adds an entity to the end of an entity list
+static void juEntityListPush(JUEntityList *list, JUEntityID entity) {
+	if (list->count == list->listSize) {
+		list->listSize += juListGrowth(list->listSize);
+		list->entities = juRealloc(list->entities, sizeof(JUEntityID) * list->listSize);
+	}
+	list->entities[list->count++] = entity;
+}
 
-	// Search for an available component
-	for (int i = 0; i < gECS.componentListSizes[component] && id == JU_NO_COMPONENT; i++)
-		if (juECSGetComponentState(component, i) == false)
-			id = i;
+// Waits for the copy to finish, systems skip this since the copy never starts before every system is done
+static void juECSWaitCopy() {
+	if (gCurrentSystem == -1)
+		juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+}
 
-	// No available spot, make list bigger
-	if (id == JU_NO_COMPONENT) {
-		gECS.components[component] = juRealloc(gECS.components[component], (gECS.componentSizes[component] + 1) * (gECS.componentListSizes[component] + JU_LIST_EXTENSION));
-		gECS.previousComponents[component] = juRealloc(gECS.previousComponents[component], (gECS.componentSizes[component] + 1) * (gECS.componentListSizes[component] + JU_LIST_EXTENSION));
-		id = gECS.componentListSizes[component];
+// Queues a pointer to be freed during the next copy, when no system can be holding onto it anymore
+static void juECSRetire(void *ptr) {
+	if (gECS.retiredCount == gECS.retiredListSize) {
+		gECS.retiredListSize += juListGrowth(gECS.retiredListSize);
+		gECS.retired = juRealloc(gECS.retired, sizeof(void*) * gECS.retiredListSize);
+	}
+	gECS.retired[gECS.retiredCount++] = ptr;
+}
 
-		// Set all the other components to inactive
-		for (int i = gECS.componentListSizes[component] + 1; i < gECS.componentListSizes[component] + JU_LIST_EXTENSION; i++)
-			juECSSetComponentState(component, i, false);
+// Frees everything that has been retired
+static void juECSFreeRetired() {
+	for (int i = 0; i < gECS.retiredCount; i++)
+		juFree(gECS.retired[i]);
+	gECS.retiredCount = 0;
+}
 
-		gECS.componentListSizes[component] += JU_LIST_EXTENSION;
+// Makes a bigger copy of a directory, the old one is retired instead of freed since readers may still be in it
+static void *juECSGrowDirectory(void *directory, size_t oldSize, size_t newSize) {
+	void *out = juMallocZero(newSize);
+	if (directory != NULL) {
+		memcpy(out, directory, oldSize);
+		juECSRetire(directory);
 	}
+	return out;
+}
 
-	// Zero the component and make it active
-	memset(juECSGetComponentFromID(component, id), 0, gECS.componentSizes[component]); // TODO: Zeroing wrong memory
-	memset(juECSGetPreviousComponentFromID(component, id), 0, gECS.componentSizes[component]);
-	juECSSetComponentState(component, id, true); // TODO: Hitting wrong memory
+// Gets an entity's slot in a sparse component's lookup pages, NULL if the page doesn't exist and create is false
+static JUComponentID *juECSSparseSlot(JUComponent component, JUEntityID entity, bool create) {
+	JUSparseSet *set = &gECS.sparseSets[component];
+	int page = entity / JU_SPARSE_PAGE_SIZE;
+
+	// Readers don't take the lock so the directory and pages are only published once they're filled in
+	if (page >= atomic_load_explicit(&set->pageCount, memory_order_acquire)) {
+		if (!create)
+			return NULL;
+		_Atomic(JUComponentID*) *pages = juECSGrowDirectory(set->pages, sizeof(_Atomic(JUComponentID*)) * set->pageCount, sizeof(_Atomic(JUComponentID*)) * (page + 1));
+		atomic_store_explicit(&set->pages, pages, memory_order_release);
+		atomic_store_explicit(&set->pageCount, page + 1, memory_order_release);
+	}
+
+	_Atomic(JUComponentID*) *pages = atomic_load_explicit(&set->pages, memory_order_acquire);
+	JUComponentID *lookup = atomic_load_explicit(&pages[page], memory_order_acquire);
+	if (lookup == NULL) {
+		if (!create)
+			return NULL;
+		lookup = juMalloc(sizeof(JUComponentID) * JU_SPARSE_PAGE_SIZE);
+		for (int i = 0; i < JU_SPARSE_PAGE_SIZE; i++)
+			lookup[i] = JU_NO_COMPONENT;
+		atomic_store_explicit(&pages[page], lookup, memory_order_release);
+	}
+
+	return &lookup[entity % JU_SPARSE_PAGE_SIZE];
+}
+
+// Finds where an entity's component is, JU_NO_COMPONENT if it doesn't have it
+static JUComponentID juECSGetComponentID(JUComponent component, JUEntityID entity) {
+	if (gECS.denseIndices[component] != -1)
+		return juECSGetEntity(entity)->components[gECS.denseIndices[component]];
+	JUComponentID *slot = juECSSparseSlot(component, entity, false);
+	return slot != NULL ? *slot : JU_NO_COMPONENT;
+}
+
+// Sets where an entity's component is
+static void juECSSetComponentID(JUComponent component, JUEntityID entity, JUComponentID id) {
+	if (gECS.denseIndices[component] != -1) {
+		juECSGetEntity(entity)->components[gECS.denseIndices[component]] = id;
+	} else {
+		JUComponentID *slot = juECSSparseSlot(component, entity, id != JU_NO_COMPONENT);
+		if (slot != NULL)
+			*slot = id;
+	}
+}
+
+// Grows a component list by one chunk of inactive components, existing components never move
+static void juECSGrowComponentList(JUComponent component) {
+	int chunks = gECS.componentListSizes[component] / JU_ECS_CHUNK_SIZE;
+	size_t size = (gECS.componentSizes[component] + 1) * JU_ECS_CHUNK_SIZE;
+
+	// The chunk is set up before anything can see it since systems read the lists without a lock
+	JUComponentChunk *chunk = juMalloc(sizeof(struct JUComponentChunk));
+	chunk->current = juMallocZero(size);
+	chunk->previous = juMallocZero(size);
+	chunk->owners = juMalloc(sizeof(JUEntityID) * JU_ECS_CHUNK_SIZE);
+	chunk->versions = juMallocZero(sizeof(uint32_t) * JU_ECS_CHUNK_SIZE);
+	atomic_init(&chunk->version, 0);
+
+	// Only the directory of chunk pointers is ever copied
+	JUComponentChunk **directory = atomic_load_explicit(&gECS.componentChunks[component], memory_order_relaxed);
+	if (chunks == gECS.componentDirectorySizes[component]) {
+		int directorySize = chunks + juListGrowth(chunks);
+		directory = juECSGrowDirectory(directory, sizeof(JUComponentChunk*) * chunks, sizeof(JUComponentChunk*) * directorySize);
+		gECS.componentDirectorySizes[component] = directorySize;
+	}
+	directory[chunks] = chunk;
+	atomic_store_explicit(&gECS.componentChunks[component], directory, memory_order_release);
+	atomic_store_explicit(&gECS.componentListSizes[component], (chunks + 1) * JU_ECS_CHUNK_SIZE, memory_order_release);
+}
+
+// Grows a component list until it has at least a given number of components
+static void juECSReserveComponentList(JUComponent component, int size) {
+	while (gECS.componentListSizes[component] < size)
+		juECSGrowComponentList(component);
+}
+
+// Finds an inactive component (or makes one) for an entity and marks it active without touching its data
+static JUComponentID juECSReserveComponent(JUComponent component, JUEntityID entity) {
+	JUComponentID id = JU_NO_COMPONENT;
+
+	if (gECS.denseIndices[component] == -1) {
+		// Sparse components are always packed so the next one goes on the end
+		JUSparseSet *set = &gECS.sparseSets[component];
+		if (set->count == gECS.componentListSizes[component])
+			juECSGrowComponentList(component);
+		id = set->count;
+		set->count++;
+	} else {
+		// Search for an available component, everything before the hint is in use
+		for (int i = gECS.componentFreeHints[component]; i < gECS.componentListSizes[component] && id == JU_NO_COMPONENT; i++)
+			if (juECSGetComponentState(component, i) == false)
+				id = i;
+
+		// No available spot, make list bigger
+		if (id == JU_NO_COMPONENT) {
+			id = gECS.componentListSizes[component];
+			juECSGrowComponentList(component);
+		}
+		gECS.componentFreeHints[component] = id + 1;
+	}
+
+	juECSSetComponentOwner(component, id, entity);
+	juECSSetComponentState(component, id, true);
+	if (gECS.trackedComponents[component])
+		juEntityListPush(&gECS.pendingEvents[component].added, entity);
+	if (gECS.spatialEnabled && component == gECS.spatialComponent)
+		juEntityListPush(&gECS.spatialAdded, entity);
+	return id;
+}
 
+// Creates a new components or grabs a stagnant one, zeroing it
+static JUComponentID juECSGetNewComponent(JUComponent component, JUEntityID entity) {
+	JUComponentID id = juECSReserveComponent(component, entity);
+	memset(juECSGetComponentFromID(component, id), 0, gECS.componentSizes[component]);
+	memset(juECSGetPreviousComponentFromID(component, id), 0, gECS.componentSizes[component]);
 	return id;
 }
 
+// Converts performance counter ticks to seconds
+static double juTicksToSeconds(uint64_t ticks) {
+	return (double)ticks / (double)SDL_GetPerformanceFrequency();
+}
+
+// Counts down one of the systems or `juECSCopyState` in a pipelined frame, the last one queues the copy (and lets
+// go of the copy channel `juECSCopyState` held) so no worker has to sit waiting on the systems
+static void juECSFinishPipelineStep() {
+	if (atomic_fetch_sub(&gECS.systemsRemaining, 1) == 1) {
+		JUJob job = {JU_JOB_CHANNEL_COPY, juECSJobCopy, NULL};
+		juJobQueue(job);
+		gJobSystem.channels[JU_JOB_CHANNEL_COPY] -= 1;
+	}
+}
+
+// Marks a system as done this frame
+static void juECSFinishSystem(int system) {
+	gECS.systemFinished[system] = true;
+	if (gECS.framePipelined)
+		juECSFinishPipelineStep();
+}
+
 // Job for running a system
 static void juECSJobSystem(void *ptr) {
 	JUSystem *system = ptr;
+	JUSystemStats *stats = &gECS.systemStats[system->id];
+	uint64_t start = SDL_GetPerformanceCounter();
+	int processed = 0;
+	gCurrentSystem = system->id;
+
+	// If a sparse component is required only the entities in the smallest sparse list need to be checked
+	JUComponent smallest = -1;
+	for (int j = 0; j < system->requiredComponentCount; j++) {
+		JUComponent component = system->requiredComponents[j];
+		if (gECS.denseIndices[component] == -1 && (smallest == -1 || gECS.sparseSets[component].count < gECS.sparseSets[smallest].count))
+			smallest = component;
+	}
+	int count = smallest != -1 ? gECS.sparseSets[smallest].count : gECS.entityCount;
 
 	// Find all entities that satisfy this job
-	for (int i = 0; i < gECS.entityCount; i++) {
-		if (gECS.entities[i].exists) {
+	for (int i = 0; i < count; i++) {
+		JUEntityID entity = smallest != -1 ? juECSGetComponentOwner(smallest, i) : i;
+		if (juECSGetEntity(entity)->exists) {
 			// Make sure all components are present
 			bool fulfillsReqs = true;
-			for (int j = 0; j < system->requiredComponentCount; j++)
-				if (gECS.entities[i].components[system->requiredComponents[j]] == JU_NO_COMPONENT)
+			for (int j = 0; j < system->requiredComponentCount && fulfillsReqs; j++)
+				if (juECSGetComponentID(system->requiredComponents[j], entity) == JU_NO_COMPONENT)
 					fulfillsReqs = false;
 
 			// Run the system on this entity
-			if (fulfillsReqs)
-				system->system(i);
+			if (fulfillsReqs) {
+				system->system(entity);
+				processed++;
+			}
 		}
 	}
-	gECS.systemFinished[system->id] = true;
+
+	gCurrentSystem = -1;
+	stats->entities = processed;
+	stats->time = juTicksToSeconds(SDL_GetPerformanceCounter() - start);
+	juECSFinishSystem(system->id);
 }
 
-// Job for copying over components
-static void juECSJobCopy(void *ptr) {
-	// Wipe all entities that need to be destroyed
+// Makes sure a buffer is at least a given size
+static uint8_t *juECSGrowBuffer(uint8_t **buffer, uint32_t *size, uint32_t needed) {
+	if (*size < needed) {
+		*buffer = juRealloc(*buffer, needed);
+		*size = needed;
+	}
+	return *buffer;
+}
+
+// Size in bytes of a single entity in the history's entity table, rows are [exists][type][parent][component ids]
+static uint32_t juECSHistoryRowSize() {
+	return 1 + sizeof(JUEntityType) + sizeof(JUEntityID) + (sizeof(JUComponentID) * gECS.componentCount);
+}
+
+// Where a component's id is in a row of the history's entity table
+static uint32_t juECSHistoryIDOffset(JUComponent component) {
+	return 1 + sizeof(JUEntityType) + sizeof(JUEntityID) + (sizeof(JUComponentID) * component);
+}
+
+// Gets the current state of a history stream, gathered out of the chunks into the gather buffer
+static uint32_t juECSHistoryGather(int stream, const uint8_t **out) {
+	if (stream < gECS.componentCount) {
+		uint32_t chunkSize = (gECS.componentSizes[stream] + 1) * JU_ECS_CHUNK_SIZE;
+		int chunks = gECS.componentListSizes[stream] / JU_ECS_CHUNK_SIZE;
+		uint8_t *list = juECSGrowBuffer(&gECS.history.gather, &gECS.history.gatherSize, chunkSize * chunks);
+		for (int i = 0; i < chunks; i++)
+			memcpy(list + (chunkSize * i), gECS.componentChunks[stream][i]->current, chunkSize);
+		*out = list;
+		return chunkSize * chunks;
+	}
+
+	// Resources are already one block
+	if (stream == gECS.componentCount + 1) {
+		*out = gECS.resources;
+		return gECS.resourcesSize;
+	}
+
+	uint32_t row = juECSHistoryRowSize();
+	uint8_t *table = juECSGrowBuffer(&gECS.history.gather, &gECS.history.gatherSize, row * gECS.entityCount);
 	for (int i = 0; i < gECS.entityCount; i++) {
-		if (gECS.entities[i].exists && gECS.entities[i].queueDeletion) {
-			// Wipe all components
-			for (int j = 0; j < gECS.componentCount; j++) {
-				juECSSetComponentState(j, gECS.entities[i].components[j], false);
-			}
+		uint8_t *dst = table + (row * i);
+		dst[0] = juECSGetEntity(i)->exists;
+		memcpy(dst + 1, &juECSGetEntity(i)->type, sizeof(JUEntityType));
+		memcpy(dst + 1 + sizeof(JUEntityType), &juECSGetEntity(i)->parent, sizeof(JUEntityID));
+		for (int j = 0; j < gECS.componentCount; j++) {
+			JUComponentID id = juECSGetComponentID(j, i);
+			memcpy(dst + juECSHistoryIDOffset(j), &id, sizeof(JUComponentID));
 		}
 	}
+	*out = table;
+	return row * gECS.entityCount;
+}
 
-	// Copy all components
-	for (int i = 0; i < gECS.componentCount; i++)
-		memcpy(gECS.previousComponents[i], gECS.components[i], (gECS.componentSizes[i] + 1) * gECS.componentListSizes[i]);
+// XOR of two buffers at a position where anything past the end of a buffer is 0
+static inline uint8_t juECSHistoryXor(const uint8_t *a, uint32_t aSize, const uint8_t *b, uint32_t bSize, uint32_t i) {
+	return (i < aSize ? a[i] : 0) ^ (i < bSize ? b[i] : 0);
 }
 
-void juECSAddComponents(const size_t *componentSizes, int componentCount) {
-	*((int*)&gECS.componentCount) = componentCount;
-	gECS.componentSizes = componentSizes;
+// Encodes a XOR b as runs of [uint32 zeroes][uint32 literal count][literals], returning a new buffer
+static uint8_t *juECSHistoryEncode(const uint8_t *a, uint32_t aSize, const uint8_t *b, uint32_t bSize, uint32_t *outSize) {
+	const uint32_t header = sizeof(uint32_t) * 2;
+	uint32_t size = aSize > bSize ? aSize : bSize;
+	uint32_t pointer = 0;
+	uint32_t i = 0;
+
+	while (i < size) {
+		uint32_t zeroes = 0;
+		while (i < size && juECSHistoryXor(a, aSize, b, bSize, i) == 0) {
+			zeroes++;
+			i++;
+		}
 
-	// Create lists for components
-	gECS.components = juMallocZero(componentCount * sizeof(JUComponentVector));
-	gECS.previousComponents = juMallocZero(componentCount * sizeof(JUComponentVector));
-	gECS.componentListSizes = juMallocZero(componentCount * sizeof(int));
+		// Literal runs only stop for zero runs that are longer than a header
+		uint32_t literalStart = i;
+		uint32_t quiet = 0;
+		while (i < size && quiet <= header) {
+			quiet = juECSHistoryXor(a, aSize, b, bSize, i) == 0 ? quiet + 1 : 0;
+			i++;
+		}
+		i -= quiet;
+		uint32_t literals = i - literalStart;
+
+		uint8_t *out = juECSGrowBuffer(&gECS.history.scratch, &gECS.history.scratchSize, pointer + header + literals);
+		memcpy(out + pointer, &zeroes, sizeof(uint32_t));
+		memcpy(out + pointer + sizeof(uint32_t), &literals, sizeof(uint32_t));
+		pointer += header;
+		for (uint32_t j = 0; j < literals; j++)
+			out[pointer + j] = juECSHistoryXor(a, aSize, b, bSize, literalStart + j);
+		pointer += literals;
+	}
+
+	uint8_t *delta = juMalloc(pointer > 0 ? pointer : 1);
+	if (pointer > 0)
+		memcpy(delta, gECS.history.scratch, pointer);
+	*outSize = pointer;
+	return delta;
 }
 
-void juECSAddSystems(JUSystem *systems, int systemCount) {
-	gECS.systems = systems;
-	gECS.systemCount = systemCount;
-	gECS.systemFinished = juMallocZero(sizeof(_Atomic bool) * systemCount);
+// XORs an encoded delta into the bytes [start, start + size) of a buffer that starts at byte `start`
+static void juECSHistoryApply(uint8_t *buffer, uint32_t start, uint32_t size, const uint8_t *delta, uint32_t deltaSize) {
+	const uint32_t header = sizeof(uint32_t) * 2;
+	uint32_t pointer = 0;
+	uint32_t i = 0;
+
+	while (pointer < deltaSize && i < start + size) {
+		uint32_t zeroes, literals;
+		memcpy(&zeroes, delta + pointer, sizeof(uint32_t));
+		memcpy(&literals, delta + pointer + sizeof(uint32_t), sizeof(uint32_t));
+		pointer += header;
+		i += zeroes;
+
+		for (uint32_t j = 0; j < literals; j++)
+			if (i + j >= start && i + j < start + size)
+				buffer[i + j - start] ^= delta[pointer + j];
+		pointer += literals;
+		i += literals;
+	}
+}
 
-	for (int i = 0; i < gECS.systemCount; i++)
-		gECS.systems[i].id = i;
+// Gets a frame in the history ring by its frame number (NULL if its not in the ring)
+static JUECSHistoryFrame *juECSHistoryGetFrame(JUFrame frame) {
+	JUECSHistory *history = &gECS.history;
+	if (history->count == 0)
+		return NULL;
+	JUFrame oldest = history->frames[history->start].frame;
+	if (frame < oldest || frame >= oldest + history->count)
+		return NULL;
+	return &history->frames[(history->start + (frame - oldest)) % history->capacity];
 }
 
-bool juECSIsSystemFinished(int systemIndex) {
-	return gECS.systemFinished[systemIndex];
+// Frees all the deltas in a history frame
+static void juECSHistoryClearFrame(JUECSHistoryFrame *frame) {
+	for (int i = 0; i < gECS.history.streamCount; i++) {
+		juFree(frame->deltas[i]);
+		frame->deltas[i] = NULL;
+		frame->deltaSizes[i] = 0;
+	}
 }
 
-void juECSWaitSystemFinished(int systemIndex) {
-	bool finished = false;
-	while (!finished)
-		finished = juECSIsSystemFinished(systemIndex);
+// Records the current state into the history ring as the newest frame
+static void juECSHistoryRecord() {
+	JUECSHistory *history = &gECS.history;
+
+	// Make room for the new frame
+	if (history->count == history->capacity) {
+		juECSHistoryClearFrame(&history->frames[history->start]);
+		history->start = (history->start + 1) % history->capacity;
+		history->count--;
+	}
+	JUECSHistoryFrame *newest = history->count > 0 ? &history->frames[(history->start + history->count - 1) % history->capacity] : NULL;
+	JUECSHistoryFrame *frame = &history->frames[(history->start + history->count) % history->capacity];
+	frame->frame = gECS.frame;
+
+	// The previous newest frame stores how to get back to itself from this frame
+	for (int i = 0; i < history->streamCount; i++) {
+		const uint8_t *state;
+		uint32_t size = juECSHistoryGather(i, &state);
+		if (newest != NULL)
+			newest->deltas[i] = juECSHistoryEncode(history->latest[i], history->latestSizes[i], state, size, &newest->deltaSizes[i]);
+		history->latest[i] = juRealloc(history->latest[i], size > 0 ? size : 1);
+		if (size > 0)
+			memcpy(history->latest[i], state, size);
+		history->latestSizes[i] = size;
+		frame->sizes[i] = size;
+	}
+	history->count++;
 }
 
-JUEntityID juECSAddEntity(const JUComponent *components, JUComponentVector *defaultStates, int componentCount) {
+// Frees the history ring
+static void juECSHistoryFree() {
+	JUECSHistory *history = &gECS.history;
+	for (int i = 0; i < history->capacity; i++) {
+		juECSHistoryClearFrame(&history->frames[i]);
+		juFree(history->frames[i].sizes);
+		juFree(history->frames[i].deltas);
+		juFree(history->frames[i].deltaSizes);
+	}
+	for (int i = 0; i < history->streamCount && history->latest != NULL; i++)
+		juFree(history->latest[i]);
+	juFree(history->frames);
+	juFree(history->latest);
+	juFree(history->latestSizes);
+	juFree(history->scratch);
+	juFree(history->gather);
+	memset(history, 0, sizeof(struct JUECSHistory));
+}
+
+// Resets an entity to not existing with no components
+static void juECSClearEntity(JUEntityID entity) {
+	JUEntity *e = juECSGetEntity(entity);
+	e->exists = false;
+	e->queueDeletion = false;
+	e->type = 0;
+	e->parent = JU_INVALID_ENTITY;
+	e->region = JU_NO_REGION;
+	for (int i = 0; i < gECS.denseCount; i++)
+		e->components[i] = JU_NO_COMPONENT;
+}
+
+// Grows the entity list by one chunk of entities that don't exist, existing entities never move
+static void juECSGrowEntityList() {
+	int chunks = gECS.entityCount / JU_ECS_CHUNK_SIZE;
+	if (chunks == gECS.entityDirectorySize) {
+		int directorySize = chunks + juListGrowth(chunks);
+		gECS.entityChunks = juECSGrowDirectory(gECS.entityChunks, sizeof(JUEntity*) * chunks, sizeof(JUEntity*) * directorySize);
+		gECS.entityDirectorySize = directorySize;
+	}
+
+	// Every entity's component list in the chunk is stored right after the entities
+	JUEntity *chunk = juMalloc((sizeof(struct JUEntity) + (sizeof(JUComponentID) * gECS.denseCount)) * JU_ECS_CHUNK_SIZE);
+	JUComponentID *components = (void*)(chunk + JU_ECS_CHUNK_SIZE);
+	for (int i = 0; i < JU_ECS_CHUNK_SIZE; i++)
+		chunk[i].components = gECS.denseCount > 0 ? components + (gECS.denseCount * i) : NULL;
+	gECS.entityChunks[chunks] = chunk;
+	for (int i = gECS.entityCount; i < gECS.entityCount + JU_ECS_CHUNK_SIZE; i++)
+		juECSClearEntity(i);
+	gECS.entityCount += JU_ECS_CHUNK_SIZE;
+}
+
+// Finds an entity that doesn't exist (or makes one), everything before the new hint is taken afterwards
+static JUEntityID juECSReserveEntity() {
 	JUEntityID entity = JU_INVALID_ENTITY;
-	pthread_mutex_lock(&gECS.createEntityAccess);
-	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
 
 	// Find an available spot in the list
-	for (int i = 0; i < gECS.entityCount && entity == JU_INVALID_ENTITY; i++)
-		if (!gECS.entities[i].exists)
+	for (int i = gECS.entityFreeHint; i < gECS.entityCount && entity == JU_INVALID_ENTITY; i++)
+		if (!juECSGetEntity(i)->exists)
 			entity = i;
 
 	// No spot, extend the list
 	if (entity == JU_INVALID_ENTITY) {
-		gECS.entities = juRealloc(gECS.entities, (gECS.entityCount + JU_LIST_EXTENSION) * sizeof(struct JUEntity));
 		entity = gECS.entityCount;
-
-		// Wipe the new entities
-		for (int i = gECS.entityCount; i < gECS.entityCount + JU_LIST_EXTENSION; i++) {
-			gECS.entities[i].exists = false;
-			gECS.entities[i].queueDeletion = false;
-			gECS.entities[i].type = 0;
-			gECS.entities[i].components = juMalloc(sizeof(JUComponentID) * gECS.componentCount);
-
-			for (int j = 0; j < gECS.componentCount; j++)
-				gECS.entities[i].components[j] = JU_NO_COMPONENT;
-		}
-		gECS.entityCount += JU_LIST_EXTENSION;
+		juECSGrowEntityList();
 	}
+	gECS.entityFreeHint = entity + 1;
 
-	// We have an entity, get it some components and create the type
-	for (int i = 0; i < componentCount; i++) {
-		gECS.entities[entity].components[components[i]] = juECSGetNewComponent(components[i]);
-		gECS.entities[entity].type = gECS.entities[entity].type | (1 << components[i]);
-		gECS.entities[entity].exists = true;
+	return entity;
+}
 
-		// Copy the new state
-		if (defaultStates != NULL) {
-			int id = gECS.entities[entity].components[components[i]];
-			memcpy(juECSGetComponentFromID(components[i], id), defaultStates[i], gECS.componentSizes[components[i]]);
-			memcpy(juECSGetPreviousComponentFromID(components[i], id), defaultStates[i], gECS.componentSizes[components[i]]);
+// Frees everything in the ECS
+static void juECSQuit() {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	if (gECS.streamingEnabled)
+		juJobWaitChannel(gECS.streamChannel);
+	for (int i = 0; i < gECS.regionCount; i++) {
+		juFree((void*)gECS.regions[i]->filename);
+		juFree(gECS.regions[i]->members.entities);
+		juFree(gECS.regions[i]->data);
+		juFree(gECS.regions[i]);
+	}
+	juFree(gECS.regions);
+	for (int i = 0; i < gECS.componentCount; i++) {
+		for (int j = 0; j < gECS.componentListSizes[i] / JU_ECS_CHUNK_SIZE; j++) {
+			juFree(gECS.componentChunks[i][j]->current);
+			juFree(gECS.componentChunks[i][j]->previous);
+			juFree(gECS.componentChunks[i][j]->owners);
+			juFree(gECS.componentChunks[i][j]->versions);
+			juFree(gECS.componentChunks[i][j]);
 		}
+		juFree(gECS.pendingEvents[i].added.entities);
+		juFree(gECS.pendingEvents[i].removed.entities);
+		juFree(gECS.pendingEvents[i].changed.entities);
+		juFree(gECS.events[i].added.entities);
+		juFree(gECS.events[i].removed.entities);
+		juFree(gECS.events[i].changed.entities);
+		juFree(gECS.componentChunks[i]);
+		for (int j = 0; j < gECS.sparseSets[i].pageCount; j++)
+			juFree(gECS.sparseSets[i].pages[j]);
+		juFree(gECS.sparseSets[i].pages);
 	}
-
-	pthread_mutex_unlock(&gECS.createEntityAccess);
-	return entity;
+	for (int i = 0; i < gECS.entityCount / JU_ECS_CHUNK_SIZE; i++)
+		juFree(gECS.entityChunks[i]);
+	juFree(gECS.entityChunks);
+	juFree(gECS.componentChunks);
+	juFree(gECS.componentDirectorySizes);
+	juFree(gECS.componentListSizes);
+	juFree(gECS.componentFreeHints);
+	juFree(gECS.denseIndices);
+	juFree(gECS.sparseSets);
+	juFree(gECS.trackedComponents);
+	juFree(gECS.resources);
+	juFree(gECS.previousResources);
+	juFree(gECS.resourceOffsets);
+	juFree(gECS.pendingEvents);
+	juFree(gECS.events);
+	juFree(gECS.systemFinished);
+	juFree(gECS.systemStats);
+	juFree(gECS.stats[0].systems);
+	juFree(gECS.stats[1].systems);
+	juECSFreeRetired();
+	juFree(gECS.retired);
+	juSpatialGridFree(gECS.spatial);
+	juFree(gECS.spatialAdded.entities);
+	juFree(gECS.links);
+	juFree(gECS.levels);
+	juFree(gECS.transformJobs);
+	juECSHistoryFree();
 }
 
-void *juECSGetComponent(JUComponent component, JUEntityID entity) {
-	if (entity != JU_INVALID_ENTITY && entity < gECS.entityCount)
-		return juECSGetComponentFromID(component, gECS.entities[entity].components[component]);
-	return NULL;
+// Publishes this frame's stats and resets them for the next frame
+static void juECSPublishStats(uint64_t copyTicks) {
+	int index = 1 - gECS.statsIndex;
+	JUECSStats *stats = &gECS.stats[index];
+	memcpy(stats->systems, gECS.systemStats, sizeof(struct JUSystemStats) * gECS.systemCount);
+	memset(gECS.systemStats, 0, sizeof(struct JUSystemStats) * gECS.systemCount);
+	stats->frame = gECS.frame;
+	stats->copyTime = juTicksToSeconds(copyTicks);
+	stats->waitTime = juTicksToSeconds(atomic_exchange(&gJobSystem.waitTicks, 0));
+	stats->entities = 0;
+	for (int i = 0; i < gECS.entityCount; i++)
+		if (juECSGetEntity(i)->exists)
+			stats->entities++;
+	gECS.statsIndex = index;
 }
 
-const void *juECSGetPreviousComponent(JUComponent component, JUEntityID entity) {
-	if (entity != JU_INVALID_ENTITY && entity < gECS.entityCount)
-		return juECSGetComponentFromID(component, gECS.entities[entity].components[component]);
-	return NULL;
+// Carries a component's version over when it moves to another slot, raising the destination chunk's version if
+// it is newer so the moved component's changes aren't skipped
+static void juECSMoveVersion(JUComponent component, JUComponentID from, JUComponentID to) {
+	JUComponentChunk *destination = juECSGetChunk(component, to);
+	uint32_t version = juECSGetChunk(component, from)->versions[from % JU_ECS_CHUNK_SIZE];
+	destination->versions[to % JU_ECS_CHUNK_SIZE] = version;
+	if (version > atomic_load_explicit(&destination->version, memory_order_relaxed))
+		atomic_store_explicit(&destination->version, version, memory_order_relaxed);
 }
 
-void juECSRunSystems() {
-	// Make sure all data is copied before starting next frame processing
-	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
-
-	// Run all systems as jobs
-	for (int i = 0; i < gECS.systemCount; i++) {
-		gECS.systemFinished[i] = false;
-		JUJob job = {JU_JOB_CHANNEL_SYSTEMS, juECSJobSystem, (void*)&gECS.systems[i]};
-		juJobQueue(job);
+// Removes a packed sparse component, moving the last component into its place so the list stays packed
+static void juECSRemoveSparseComponent(JUComponent component, JUComponentID id) {
+	JUSparseSet *set = &gECS.sparseSets[component];
+	JUComponentID last = set->count - 1;
+
+	if (id != last) {
+		memcpy(juECSGetComponentFromID(component, id), juECSGetComponentFromID(component, last), gECS.componentSizes[component]);
+		memcpy(juECSGetPreviousComponentFromID(component, id), juECSGetPreviousComponentFromID(component, last), gECS.componentSizes[component]);
+		juECSMoveVersion(component, last, id);
+		JUEntityID owner = juECSGetComponentOwner(component, last);
+		juECSSetComponentOwner(component, id, owner);
+		*juECSSparseSlot(component, owner, false) = id;
 	}
+	juECSSetComponentState(component, last, false);
+	set->count--;
 }
 
-void juECSCopyState() {
-	// Wait for all systems to finish before copying
-	juJobWaitChannel(JU_JOB_CHANNEL_SYSTEMS);
-	JUJob job = {JU_JOB_CHANNEL_COPY, juECSJobCopy, NULL};
-	juJobQueue(job);
+// Gets an entity's transform, NULL if it doesn't have one
+static JUTransform *juECSGetTransform(JUEntityID entity) {
+	return juECSGetComponentFromID(gECS.transformComponent, juECSGetComponentID(gECS.transformComponent, entity));
 }
 
-void juECSLockNext(JUECSLock *lock) {
-	if (*lock != JU_DISABLED_LOCK) {
-		*lock += 1;
+// Finds how deep an entity is in the hierarchy, caching depths of every ancestor along the way
+static int juECSHierarchyDepth(JUEntityID entity, int *depths) {
+	// Walk up to the first ancestor with a known depth or to the root, never more steps than there are entities
+	JUEntityID top = entity;
+	int steps = 0;
+	while (depths[top] == -1 && juECSGetEntity(top)->parent != JU_INVALID_ENTITY && steps < gECS.entityCount) {
+		top = juECSGetEntity(top)->parent;
+		steps++;
 	}
+	if (depths[top] == -1)
+		depths[top] = 0;
+
+	// Walk back up from the entity filling in each depth below the top
+	int depth = depths[top] + steps;
+	for (JUEntityID ancestor = entity; ancestor != top; ancestor = juECSGetEntity(ancestor)->parent)
+		depths[ancestor] = depth--;
+	return depths[entity];
 }
 
-void juECSLockWait(JUECSLock *lock, int index) {
-	if (*lock != JU_DISABLED_LOCK) {
-		bool done = false;
-		while (!done)
-			done = *lock == index;
+// Sorts every transform by its depth in the hierarchy so each level can be propagated in one sweep
+static void juECSHierarchyRebuild() {
+	int *depths = juMalloc(sizeof(int) * (gECS.entityCount > 0 ? gECS.entityCount : 1));
+	int count = 0;
+	gECS.levelCount = 0;
+
+	// Children of destroyed parents (or parents that lost their transform) keep their world transform as roots
+	for (int i = 0; i < gECS.entityCount; i++) {
+		JUEntity *entity = juECSGetEntity(i);
+		depths[i] = -1;
+		if (entity->exists && entity->parent != JU_INVALID_ENTITY && (!juECSEntityExists(entity->parent) || juECSGetTransform(entity->parent) == NULL)) {
+			JUTransform *transform = juECSGetTransform(i);
+			if (transform != NULL) {
+				transform->x = transform->worldX;
+				transform->y = transform->worldY;
+				transform->rotation = transform->worldRotation;
+			}
+			entity->parent = JU_INVALID_ENTITY;
+		}
 	}
-}
 
-void juECSLockReset(JUECSLock *lock) {
-	if (*lock != JU_DISABLED_LOCK) {
-		*lock = 0;
+	// Count how many transforms are on each level
+	for (int i = 0; i < gECS.entityCount; i++) {
+		if (juECSGetEntity(i)->exists && juECSGetTransform(i) != NULL) {
+			int depth = juECSHierarchyDepth(i, depths);
+			if (depth + 2 > gECS.levelListSize) {
+				gECS.levelListSize = depth + 2 + juListGrowth(depth + 2);
+				gECS.levels = juRealloc(gECS.levels, sizeof(int) * gECS.levelListSize);
+			}
+			for (; gECS.levelCount <= depth; gECS.levelCount++)
+				gECS.levels[gECS.levelCount + 1] = 0;
+			gECS.levels[depth + 1]++;
+			count++;
+		}
+	}
+	if (gECS.levelCount > 0)
+		gECS.levels[0] = 0;
+	for (int i = 1; i <= gECS.levelCount; i++)
+		gECS.levels[i] += gECS.levels[i - 1];
+
+	// Put each transform into its level, levels[d] is used as the insertion point and then shifted back
+	if (count > gECS.linkListSize) {
+		gECS.linkListSize = count + juListGrowth(count);
+		gECS.links = juRealloc(gECS.links, sizeof(struct JUTransformLink) * gECS.linkListSize);
+	}
+	for (int i = 0; i < gECS.entityCount; i++) {
+		if (juECSGetEntity(i)->exists && juECSGetTransform(i) != NULL) {
+			JUEntityID parent = juECSGetEntity(i)->parent;
+			JUTransformLink *link = &gECS.links[gECS.levels[depths[i]]++];
+			link->child = juECSGetComponentID(gECS.transformComponent, i);
+			link->parent = parent == JU_INVALID_ENTITY ? JU_NO_COMPONENT : juECSGetComponentID(gECS.transformComponent, parent);
+		}
 	}
+	for (int i = gECS.levelCount; i > 0; i--)
+		gECS.levels[i] = gECS.levels[i - 1];
+	if (gECS.levelCount > 0)
+		gECS.levels[0] = 0;
+
+	juFree(depths);
+	gECS.hierarchyDirty = false;
 }
 
-void juECSLockDisable(JUECSLock *lock) {
-	*lock = JU_DISABLED_LOCK;
+// Calculates world transforms for a range of links whose parents are already up to date
+static void juECSPropagateTransforms(int start, int end) {
+	for (int i = start; i < end; i++) {
+		JUTransform *child = juECSGetComponentFromID(gECS.transformComponent, gECS.links[i].child);
+		if (gECS.links[i].parent == JU_NO_COMPONENT) {
+			child->worldX = child->x;
+			child->worldY = child->y;
+			child->worldRotation = child->rotation;
+		} else {
+			// Same rotation juRotatePoint does
+			const JUTransform *parent = juECSGetComponentFromID(gECS.transformComponent, gECS.links[i].parent);
+			double c = cos(-parent->worldRotation);
+			double s = sin(-parent->worldRotation);
+			child->worldX = parent->worldX + (child->x * c) - (child->y * s);
+			child->worldY = parent->worldY + (child->x * s) + (child->y * c);
+			child->worldRotation = parent->worldRotation + child->rotation;
+		}
+	}
 }
 
-void juECSEntityIterStart() {
-	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
-	pthread_mutex_lock(&gECS.createEntityAccess);
-	gECS.entityIterator = 0;
+// Job for propagating part of a level
+static void juECSJobTransforms(void *ptr) {
+	JUTransformJob *job = ptr;
+	juECSPropagateTransforms(job->start, job->end);
 }
 
-JUEntity *juECSEntityIterNext() {
-	JUEntity *out = NULL;
+// Updates every world transform one level at a time, splitting wide levels into jobs
+static void juECSUpdateTransforms() {
+	if (gECS.hierarchyDirty)
+		juECSHierarchyRebuild();
+
+	for (int level = 0; level < gECS.levelCount; level++) {
+		int start = gECS.levels[level];
+		int end = gECS.levels[level + 1];
+
+		// The copy job is already using one of the workers so there must be at least one more to help
+		if (end - start >= JU_TRANSFORM_JOB_SIZE && gJobSystem.threadCount > 1) {
+			int jobs = gJobSystem.threadCount;
+			int size = ((end - start) + jobs - 1) / jobs;
+			if (jobs > gECS.transformJobListSize) {
+				gECS.transformJobs = juRealloc(gECS.transformJobs, sizeof(struct JUTransformJob) * jobs);
+				gECS.transformJobListSize = jobs;
+			}
 
-	// Find the next entity that exists
-	while (out == NULL && gECS.entityIterator < gECS.entityCount) {
-		if (gECS.entities[gECS.entityIterator].exists)
-			out = &gECS.entities[gECS.entityIterator];
-		gECS.entityIterator += 1;
+			// The systems channel is free since the copy only starts once every system is done
+			for (int i = 0; i < jobs; i++) {
+				gECS.transformJobs[i].start = start + (size * i) < end ? start + (size * i) : end;
+				gECS.transformJobs[i].end = start + (size * (i + 1)) < end ? start + (size * (i + 1)) : end;
+				JUJob job = {JU_JOB_CHANNEL_SYSTEMS, juECSJobTransforms, &gECS.transformJobs[i]};
+				juJobQueue(job);
+			}
+			juJobWaitChannel(JU_JOB_CHANNEL_SYSTEMS);
+		} else {
+			juECSPropagateTransforms(start, end);
+		}
 	}
+}
 
-	return out;
+// Puts one spatial component's owner in the spatial hash by its current bounds
+static void juECSSpatialSet(JUComponentID id) {
+	JURectangle bounds;
+	const void *data = juECSGetComponentFromID(gECS.spatialComponent, id);
+	if (gECS.spatialBounds != NULL)
+		gECS.spatialBounds(data, &bounds);
+	else
+		memcpy(&bounds, data, sizeof(struct JURectangle));
+	juSpatialGridSet(gECS.spatial, juECSGetComponentOwner(gECS.spatialComponent, id), &bounds);
 }
 
-void juECSEntityIterEnd() {
-	pthread_mutex_unlock(&gECS.createEntityAccess);
+// Brings the spatial hash up to date with the spatial components added or written to this frame
+static void juECSSpatialUpdate() {
+	const uint32_t version = (uint32_t)gECS.frame + 1;
+	JUComponent component = gECS.spatialComponent;
+
+	// Components can only be written through juECSGetComponent so chunks that weren't touched are skipped
+	for (int i = 0; i < gECS.componentListSizes[component] / JU_ECS_CHUNK_SIZE; i++) {
+		JUComponentChunk *chunk = gECS.componentChunks[component][i];
+		if (atomic_load_explicit(&chunk->version, memory_order_relaxed) != version)
+			continue;
+		for (int j = 0; j < JU_ECS_CHUNK_SIZE; j++) {
+			JUComponentID id = (i * JU_ECS_CHUNK_SIZE) + j;
+			if (chunk->versions[j] == version && juECSGetComponentState(component, id))
+				juECSSpatialSet(id);
+		}
+	}
+
+	// New components are set up without going through juECSGetComponent, entities destroyed since are skipped
+	for (int i = 0; i < gECS.spatialAdded.count; i++) {
+		JUComponentID id = juECSGetComponentID(component, gECS.spatialAdded.entities[i]);
+		if (id != JU_NO_COMPONENT)
+			juECSSpatialSet(id);
+	}
+	gECS.spatialAdded.count = 0;
 }
 
-JUEntityType juECSGetEntityType(JUEntityID entity) {
-	if (entity != JU_INVALID_ENTITY && entity < gECS.entityCount)
-		return gECS.entities[entity].type;
-	return JU_INVALID_TYPE;
+// Throws out the spatial hash and builds it again from every active spatial component
+static void juECSSpatialRebuild(double cellSize) {
+	juSpatialGridFree(gECS.spatial);
+	gECS.spatial = juSpatialGridCreate(cellSize);
+	for (int i = 0; i < gECS.componentListSizes[gECS.spatialComponent]; i++)
+		if (juECSGetComponentState(gECS.spatialComponent, i))
+			juECSSpatialSet(i);
+	gECS.spatialAdded.count = 0;
 }
 
-bool juECSEntityExists(JUEntityID entity) {
-	return entity != JU_INVALID_ENTITY && entity < gECS.entityCount && gECS.entities[entity].exists;
+// Moves a component into an inactive slot, pointing its owner at the new spot
+static void juECSMoveComponent(JUComponent component, JUComponentID from, JUComponentID to) {
+	size_t size = gECS.componentSizes[component] + 1;
+	memcpy(juECSGetComponentFromID(component, to), juECSGetComponentFromID(component, from), size);
+	memcpy(juECSGetPreviousComponentFromID(component, to), juECSGetPreviousComponentFromID(component, from), size);
+	juECSMoveVersion(component, from, to);
+
+	JUEntityID owner = juECSGetComponentOwner(component, from);
+	juECSSetComponentOwner(component, to, owner);
+	juECSSetComponentID(component, owner, to);
+	juECSSetComponentState(component, from, false);
+	if (gECS.transformEnabled && component == gECS.transformComponent)
+		gECS.hierarchyDirty = true;
 }
 
-bool juECSSameType(JUEntityID entity1, JUEntityID entity2) {
-	if (gECS.componentCount < 64 && juECSEntityExists(entity1) && juECSEntityExists(entity2)) {
-		return juECSGetEntityType(entity1) == juECSGetEntityType(entity2);
-	} else if (juECSEntityExists(entity1) && juECSEntityExists(entity2)) {
-		bool out = true;
+// Frees chunks at the end of a component list that have nothing active in them
+static void juECSShrinkComponentList(JUComponent component) {
+	bool empty = true;
+	while (empty && gECS.componentListSizes[component] > 0) {
+		int start = gECS.componentListSizes[component] - JU_ECS_CHUNK_SIZE;
+		if (gECS.denseIndices[component] == -1) {
+			empty = gECS.sparseSets[component].count <= start;
+		} else {
+			for (int i = gECS.componentListSizes[component] - 1; i >= start && empty; i--)
+				empty = !juECSGetComponentState(component, i);
+		}
 
-		for (int i = 0; i < gECS.componentCount; i++) {
-			if (!((gECS.entities[entity1].components[i] == JU_NO_COMPONENT &&
-				   gECS.entities[entity2].components[i] == JU_NO_COMPONENT) ||
-				  (gECS.entities[entity1].components[i] != JU_NO_COMPONENT &&
-				   gECS.entities[entity2].components[i] != JU_NO_COMPONENT)))
-				out = false;
+		// Retired instead of freed in case anything outside the ECS is still looking at it
+		if (empty) {
+			JUComponentChunk *chunk = juECSGetChunk(component, start);
+			juECSRetire(chunk->current);
+			juECSRetire(chunk->previous);
+			juECSRetire(chunk->owners);
+			juECSRetire(chunk->versions);
+			juECSRetire(chunk);
+			gECS.componentListSizes[component] = start;
 		}
+	}
+	if (gECS.componentFreeHints[component] > gECS.componentListSizes[component])
+		gECS.componentFreeHints[component] = gECS.componentListSizes[component];
+}
 
-		return out;
+// Moves components from the end of each list into holes near the start, up to a budget of moves,
+// and frees chunks at the end of a list once it has no holes left
+static void juECSCompact(int budget) {
+	for (int i = 0; i < gECS.componentCount; i++) {
+		// Sparse components never have holes so they only need shrinking
+		if (gECS.denseIndices[i] != -1) {
+			int low = gECS.componentFreeHints[i];
+			int high = gECS.componentListSizes[i] - 1;
+			while (true) {
+				while (low < high && juECSGetComponentState(i, low))
+					low++;
+				while (high > low && !juECSGetComponentState(i, high))
+					high--;
+				if (low >= high || budget <= 0)
+					break;
+				juECSMoveComponent(i, high, low);
+				budget--;
+			}
+			gECS.componentFreeHints[i] = low;
+			if (low < high)
+				continue;
+		}
+		juECSShrinkComponentList(i);
 	}
-	return false;
 }
 
-void juECSDestroyEntity(JUEntityID entity) {
+// Collects the entities whose components were written this frame and swaps the pending events in
+static void juECSPublishEvents() {
+	const uint32_t version = (uint32_t)gECS.frame + 1;
+	for (int i = 0; i < gECS.componentCount; i++) {
+		if (!gECS.trackedComponents[i])
+			continue;
+		JUECSEvents *events = &gECS.pendingEvents[i];
+
+		// Only chunks that were written to need to be looked through
+		events->changed.count = 0;
+		for (int j = 0; j < gECS.componentListSizes[i] / JU_ECS_CHUNK_SIZE; j++) {
+			JUComponentChunk *chunk = gECS.componentChunks[i][j];
+			if (atomic_load_explicit(&chunk->version, memory_order_relaxed) != version)
+				continue;
+			for (int k = 0; k < JU_ECS_CHUNK_SIZE; k++) {
+				JUComponentID id = (j * JU_ECS_CHUNK_SIZE) + k;
+				if (chunk->versions[k] == version && juECSGetComponentState(i, id))
+					juEntityListPush(&events->changed, chunk->owners[k]);
+			}
+		}
+
+		JUECSEvents old = gECS.events[i];
+		gECS.events[i] = *events;
+		*events = old;
+		events->added.count = 0;
+		events->removed.count = 0;
+		events->changed.count = 0;
+	}
+}
+
+// Appends bytes to a region's data
+static void juECSRegionWrite(JUStreamRegion *region, const void *bytes, uint32_t size) {
+	if (region->size + size > region->dataListSize) {
+		region->dataListSize = (region->size + size) * 2;
+		region->data = juRealloc(region->data, region->dataListSize);
+	}
+	memcpy(region->data + region->size, bytes, size);
+	region->size += size;
+}
+
+// Size of a region file's header, which is ["JURG"][version][component count][each component's size][entity count]
+static uint32_t juECSRegionHeaderSize() {
+	return 4 + (sizeof(uint32_t) * (3 + gECS.componentCount));
+}
+
+// Starts a region's data with a header, the entity count is filled in once every entity is saved
+static void juECSRegionWriteHeader(JUStreamRegion *region) {
+	uint32_t version = JU_REGION_VERSION;
+	uint32_t componentCount = gECS.componentCount;
+	uint32_t entityCount = 0;
+	region->size = 0;
+	juECSRegionWrite(region, "JURG", 4);
+	juECSRegionWrite(region, &version, sizeof(uint32_t));
+	juECSRegionWrite(region, &componentCount, sizeof(uint32_t));
+	for (int i = 0; i < gECS.componentCount; i++) {
+		uint32_t size = gECS.componentSizes[i];
+		juECSRegionWrite(region, &size, sizeof(uint32_t));
+	}
+	juECSRegionWrite(region, &entityCount, sizeof(uint32_t));
+}
+
+// Checks a region file against the current components and walks every entity once so spawning doesn't need bounds checks
+static bool juECSRegionValidate(JUStreamRegion *region) {
+	uint32_t header = juECSRegionHeaderSize();
+	uint32_t value;
+	if (region->size < header || memcmp(region->data, "JURG", 4) != 0)
+		return false;
+	memcpy(&value, region->data + 4, sizeof(uint32_t));
+	if (value != JU_REGION_VERSION)
+		return false;
+	memcpy(&value, region->data + 8, sizeof(uint32_t));
+	if (value != gECS.componentCount)
+		return false;
+	for (int i = 0; i < gECS.componentCount; i++) {
+		memcpy(&value, region->data + 12 + (sizeof(uint32_t) * i), sizeof(uint32_t));
+		if (value != gECS.componentSizes[i])
+			return false;
+	}
+	memcpy(&region->remaining, region->data + header - sizeof(uint32_t), sizeof(uint32_t));
+
+	// Each entity is [component count] then [component][component data] for each of its components, listing
+	// a component twice would spawn it twice so seen[c] holds the last entity (plus one) that listed c
+	uint32_t *seen = juMallocZero(sizeof(uint32_t) * gECS.componentCount);
+	uint32_t position = header;
+	bool valid = true;
+	for (uint32_t i = 0; i < region->remaining && valid; i++) {
+		uint16_t count;
+		if (position + sizeof(uint16_t) > region->size) {
+			valid = false;
+			break;
+		}
+		memcpy(&count, region->data + position, sizeof(uint16_t));
+		position += sizeof(uint16_t);
+		for (int j = 0; j < count && valid; j++) {
+			uint16_t component;
+			if (position + sizeof(uint16_t) > region->size) {
+				valid = false;
+				break;
+			}
+			memcpy(&component, region->data + position, sizeof(uint16_t));
+			position += sizeof(uint16_t);
+			if (component >= gECS.componentCount || seen[component] == i + 1 || position + gECS.componentSizes[component] > region->size) {
+				valid = false;
+				break;
+			}
+			seen[component] = i + 1;
+			position += gECS.componentSizes[component];
+		}
+	}
+	juFree(seen);
+	region->position = header;
+	return valid;
+}
+
+// Job that writes an unloading region's file, if it can't the region is spawned back
+static void juECSJobRegionSave(void *ptr) {
+	JUStreamRegion *region = ptr;
+	FILE *out = fopen(region->filename, "wb");
+	bool saved = out != NULL && fwrite(region->data, region->size, 1, out) == 1;
+	if (out != NULL && fclose(out) != 0)
+		saved = false;
+
+	if (saved) {
+		juFree(region->data);
+		region->data = NULL;
+		region->size = 0;
+		region->dataListSize = 0;
+		region->state = JU_REGION_UNLOADED;
+	} else {
+		juLog("Failed to save region \"%s\", spawning it back", region->filename);
+		region->position = juECSRegionHeaderSize();
+		region->ready = true;
+		region->state = JU_REGION_LOADING;
+	}
+}
+
+// Job that reads a loading region's file, if it can't be used the region stays unloaded
+static void juECSJobRegionLoad(void *ptr) {
+	JUStreamRegion *region = ptr;
+	region->data = juGetFile(region->filename, &region->size);
+
+	if (region->data != NULL && juECSRegionValidate(region)) {
+		region->dataListSize = region->size;
+		region->ready = true;
+	} else {
+		if (region->data != NULL)
+			juLog("Region file \"%s\" is corrupt or was saved with different components", region->filename);
+		juFree(region->data);
+		region->data = NULL;
+		region->size = 0;
+		region->state = JU_REGION_UNLOADED;
+	}
+}
+
+// Writes an entity's components to the end of its region's data and queues it for deletion
+static void juECSRegionSaveEntity(JUStreamRegion *region, JUEntityID entity) {
+	uint32_t countPosition = region->size;
+	uint16_t count = 0;
+	juECSRegionWrite(region, &count, sizeof(uint16_t));
+	for (int i = 0; i < gECS.componentCount; i++) {
+		JUComponentID id = juECSGetComponentID(i, entity);
+		if (id != JU_NO_COMPONENT) {
+			uint16_t component = i;
+			juECSRegionWrite(region, &component, sizeof(uint16_t));
+			juECSRegionWrite(region, juECSGetComponentFromID(i, id), gECS.componentSizes[i]);
+			count++;
+		}
+	}
+	memcpy(region->data + countPosition, &count, sizeof(uint16_t));
+	region->remaining++;
+
+	juECSGetEntity(entity)->region = JU_NO_REGION;
+	juECSGetEntity(entity)->queueDeletion = true;
+}
+
+// Spawns the next entity in a region's data, the previous state is filled in by the copy
+static void juECSRegionSpawnEntity(JURegion regionID, JUStreamRegion *region) {
+	JUEntityID entity = juECSReserveEntity();
+	JUEntity *e = juECSGetEntity(entity);
+	uint16_t count;
+	memcpy(&count, region->data + region->position, sizeof(uint16_t));
+	region->position += sizeof(uint16_t);
+
+	for (int i = 0; i < count; i++) {
+		uint16_t component;
+		memcpy(&component, region->data + region->position, sizeof(uint16_t));
+		region->position += sizeof(uint16_t);
+		JUComponentID id = juECSReserveComponent(component, entity);
+		juECSSetComponentID(component, entity, id);
+		memcpy(juECSGetComponentFromID(component, id), region->data + region->position, gECS.componentSizes[component]);
+		region->position += gECS.componentSizes[component];
+		e->type = e->type | ((JUEntityType)1 << component);
+	}
+
+	e->region = regionID;
+	juEntityListPush(&region->members, entity);
+	e->exists = true;
+	region->remaining--;
+}
+
+// Spends this copy's budgets on regions that are unloading or loading
+static void juECSStream() {
+	int spawns = gECS.spawnBudget > 0 ? gECS.spawnBudget : INT_MAX;
+	int despawns = gECS.despawnBudget > 0 ? gECS.despawnBudget : INT_MAX;
+
+	for (int i = 0; i < gECS.regionCount; i++) {
+		JUStreamRegion *region = gECS.regions[i];
+		if (region->state == JU_REGION_UNLOADING && !region->writing) {
+			while (despawns > 0 && region->cursor < region->members.count) {
+				JUEntityID entity = region->members.entities[region->cursor++];
+				JUEntity *e = juECSGetEntity(entity);
+				if (e->exists && !e->queueDeletion && e->region == i) {
+					juECSRegionSaveEntity(region, entity);
+					despawns--;
+				}
+			}
+
+			// Everything is saved, the file can be written while the entities are wiped
+			if (region->cursor == region->members.count) {
+				memcpy(region->data + juECSRegionHeaderSize() - sizeof(uint32_t), &region->remaining, sizeof(uint32_t));
+				region->members.count = 0;
+				region->writing = true;
+				JUJob job = {gECS.streamChannel, juECSJobRegionSave, region};
+				juJobQueue(job);
+			}
+		} else if (region->state == JU_REGION_LOADING && region->ready) {
+			while (spawns > 0 && region->remaining > 0) {
+				juECSRegionSpawnEntity(i, region);
+				gECS.hierarchyDirty = true;
+				spawns--;
+			}
+
+			if (region->remaining == 0) {
+				juFree(region->data);
+				region->data = NULL;
+				region->size = 0;
+				region->dataListSize = 0;
+				region->state = JU_REGION_LOADED;
+			}
+		}
+	}
+}
+
+// Job for copying over components
+static void juECSJobCopy(void *ptr) {
+	uint64_t start = SDL_GetPerformanceCounter();
+
+	// Systems are done so nothing can still be reading outgrown directories
+	juECSFreeRetired();
+
+	// Saved entities are wiped with everything else below (regions aren't part of the history so this waits while resimulating)
+	if (gECS.streamingEnabled && !gECS.history.resimulating)
+		juECSStream();
+
+	// Wipe all entities that need to be destroyed
+	for (int i = 0; i < gECS.entityCount; i++) {
+		JUEntity *entity = juECSGetEntity(i);
+		if (entity->exists && entity->queueDeletion) {
+			// Wipe all components
+			if (gECS.spatialEnabled)
+				juSpatialGridClear(gECS.spatial, i);
+			for (int j = 0; j < gECS.componentCount; j++) {
+				JUComponentID id = juECSGetComponentID(j, i);
+				if (id != JU_NO_COMPONENT && gECS.trackedComponents[j])
+					juEntityListPush(&gECS.pendingEvents[j].removed, i);
+				if (id != JU_NO_COMPONENT && gECS.denseIndices[j] == -1)
+					juECSRemoveSparseComponent(j, id);
+				else
+					juECSSetComponentState(j, id, false);
+				if (id != JU_NO_COMPONENT && id < gECS.componentFreeHints[j])
+					gECS.componentFreeHints[j] = id;
+				juECSSetComponentID(j, i, JU_NO_COMPONENT);
+			}
+			juECSClearEntity(i);
+			gECS.hierarchyDirty = true;
+			if (i < gECS.entityFreeHint)
+				gECS.entityFreeHint = i;
+		}
+	}
+
+	if (gECS.compactionBudget > 0)
+		juECSCompact(gECS.compactionBudget);
+	juECSPublishEvents();
+
+	// World transforms are calculated before the copy so the previous frame has them too
+	if (gECS.transformEnabled)
+		juECSUpdateTransforms();
+
+	// Copy all components
+	for (int i = 0; i < gECS.componentCount; i++) {
+		size_t chunkSize = (gECS.componentSizes[i] + 1) * JU_ECS_CHUNK_SIZE;
+		for (int j = 0; j < gECS.componentListSizes[i] / JU_ECS_CHUNK_SIZE; j++)
+			memcpy(gECS.componentChunks[i][j]->previous, gECS.componentChunks[i][j]->current, chunkSize);
+	}
+
+	if (gECS.resourcesSize > 0)
+		memcpy(gECS.previousResources, gECS.resources, gECS.resourcesSize);
+
+	// The hash now matches what systems will see as the previous frame
+	if (gECS.spatialEnabled)
+		juECSSpatialUpdate();
+
+	gECS.frame++;
+	if (gECS.history.capacity > 0)
+		juECSHistoryRecord();
+
+	if (gECS.systemCount > 0)
+		juECSPublishStats(SDL_GetPerformanceCounter() - start);
+}
+
+void juECSAddComponents(const size_t *componentSizes, int componentCount) {
+	*((int*)&gECS.componentCount) = componentCount;
+	gECS.componentSizes = componentSizes;
+
+	// Create lists for components
+	gECS.componentChunks = juMallocZero(componentCount * sizeof(_Atomic(JUComponentChunk**)));
+	gECS.componentDirectorySizes = juMallocZero(componentCount * sizeof(int));
+	gECS.componentListSizes = juMallocZero(componentCount * sizeof(_Atomic int));
+	gECS.componentFreeHints = juMallocZero(componentCount * sizeof(int));
+	gECS.denseIndices = juMallocZero(componentCount * sizeof(int));
+	gECS.sparseSets = juMallocZero(componentCount * sizeof(struct JUSparseSet));
+	gECS.trackedComponents = juMallocZero(componentCount * sizeof(bool));
+	gECS.pendingEvents = juMallocZero(componentCount * sizeof(struct JUECSEvents));
+	gECS.events = juMallocZero(componentCount * sizeof(struct JUECSEvents));
+	for (int i = 0; i < componentCount; i++)
+		gECS.denseIndices[i] = i;
+	gECS.denseCount = componentCount;
+}
+
+void juECSAddResources(const size_t *resourceSizes, int resourceCount) {
+	if (gECS.resources != NULL || gECS.history.capacity > 0) {
+		juLog("Resources must be added once, before the history is enabled");
+		return;
+	}
+
+	// Resources are padded so any type can be stored in them
+	gECS.resourceCount = resourceCount;
+	gECS.resourceOffsets = juMalloc(sizeof(size_t) * (resourceCount > 0 ? resourceCount : 1));
+	gECS.resourcesSize = 0;
+	for (int i = 0; i < resourceCount; i++) {
+		gECS.resourceOffsets[i] = gECS.resourcesSize;
+		gECS.resourcesSize += ((resourceSizes[i] + JU_RESOURCE_ALIGNMENT - 1) / JU_RESOURCE_ALIGNMENT) * JU_RESOURCE_ALIGNMENT;
+	}
+	gECS.resources = juMallocZero(gECS.resourcesSize > 0 ? gECS.resourcesSize : 1);
+	gECS.previousResources = juMallocZero(gECS.resourcesSize > 0 ? gECS.resourcesSize : 1);
+}
+
+void juECSSetSparseComponents(const JUComponent *components, int componentCount) {
+	if (gECS.entityCount > 0) {
+		juLog("Sparse components must be set before any entities are added");
+		return;
+	}
+
+	for (int i = 0; i < componentCount; i++)
+		gECS.denseIndices[components[i]] = -1;
+
+	// Everything else gets packed into each entity's component list
+	gECS.denseCount = 0;
+	for (int i = 0; i < gECS.componentCount; i++)
+		if (gECS.denseIndices[i] != -1)
+			gECS.denseIndices[i] = gECS.denseCount++;
+}
+
+void juECSAddSystems(JUSystem *systems, int systemCount) {
+	gECS.systems = systems;
+	gECS.systemCount = systemCount;
+	gECS.systemFinished = juMallocZero(sizeof(_Atomic bool) * systemCount);
+	gECS.systemStats = juMallocZero(sizeof(struct JUSystemStats) * systemCount);
+	for (int i = 0; i < 2; i++) {
+		gECS.stats[i].systemCount = systemCount;
+		gECS.stats[i].systems = juMallocZero(sizeof(struct JUSystemStats) * systemCount);
+	}
+
+	for (int i = 0; i < gECS.systemCount; i++)
+		gECS.systems[i].id = i;
+}
+
+bool juECSIsSystemFinished(int systemIndex) {
+	return gECS.systemFinished[systemIndex];
+}
+
+void juECSWaitSystemFinished(int systemIndex) {
+	bool finished = false;
+	while (!finished)
+		finished = juECSIsSystemFinished(systemIndex);
+}
+
+JUEntityID juECSAddEntity(const JUComponent *components, JUComponentVector *defaultStates, int componentCount) {
+	pthread_mutex_lock(&gECS.createEntityAccess);
+	juECSWaitCopy();
+	JUEntityID entity = juECSReserveEntity();
+
+	// We have an entity, get it some components and create the type
+	for (int i = 0; i < componentCount; i++) {
+		JUComponentID id;
+		juECSGetEntity(entity)->type = juECSGetEntity(entity)->type | ((JUEntityType)1 << components[i]);
+
+		// Copy the new state (there is no point zeroing it first if there is a default)
+		if (defaultStates != NULL) {
+			id = juECSReserveComponent(components[i], entity);
+			memcpy(juECSGetComponentFromID(components[i], id), defaultStates[i], gECS.componentSizes[components[i]]);
+			memcpy(juECSGetPreviousComponentFromID(components[i], id), defaultStates[i], gECS.componentSizes[components[i]]);
+		} else {
+			id = juECSGetNewComponent(components[i], entity);
+		}
+		juECSSetComponentID(components[i], entity, id);
+	}
+
+	// Only exists once its components are all set up since queries don't lock
+	juECSGetEntity(entity)->exists = true;
+	gECS.hierarchyDirty = true;
+	pthread_mutex_unlock(&gECS.createEntityAccess);
+	return entity;
+}
+
+JUPrefab juECSCreatePrefab(const JUComponent *components, JUComponentVector *defaultStates, int componentCount) {
+	JUPrefab prefab = juMallocZero(sizeof(struct JUPrefab));
+	prefab->componentCount = componentCount;
+	prefab->components = juMalloc(sizeof(JUComponent) * componentCount);
+	prefab->offsets = juMalloc(sizeof(size_t) * componentCount);
+
+	// Each component in the blob is laid out exactly like it is in the component lists (data then an active byte)
+	for (int i = 0; i < componentCount; i++) {
+		prefab->components[i] = components[i];
+		prefab->offsets[i] = prefab->size;
+		prefab->size += gECS.componentSizes[components[i]] + 1;
+		prefab->type |= (JUEntityType)1 << components[i];
+	}
+	prefab->defaults = juMallocZero(prefab->size);
+	for (int i = 0; i < componentCount; i++) {
+		uint8_t *component = ((uint8_t*)prefab->defaults) + prefab->offsets[i];
+		if (defaultStates != NULL)
+			memcpy(component, defaultStates[i], gECS.componentSizes[components[i]]);
+		component[gECS.componentSizes[components[i]]] = true;
+	}
+
+	return prefab;
+}
+
+void juECSInstantiate(JUPrefab prefab, int count, JUEntityID *entities) {
+	juECSInstantiateWith(prefab, count, NULL, 0, entities);
+}
+
+void juECSInstantiateWith(JUPrefab prefab, int count, const JUPrefabOverride *overrides, int overrideCount, JUEntityID *entities) {
+	JUComponentID ids[prefab->componentCount > 0 ? prefab->componentCount : 1];
+	int overrideIndices[overrideCount > 0 ? overrideCount : 1];
+
+	// Find which of the prefab's components each override goes to once instead of per entity
+	for (int i = 0; i < overrideCount; i++) {
+		overrideIndices[i] = -1;
+		for (int j = 0; j < prefab->componentCount; j++)
+			if (prefab->components[j] == overrides[i].component)
+				overrideIndices[i] = j;
+		if (overrideIndices[i] == -1)
+			juLog("Prefab override for component %i ignored, the prefab doesn't have it", overrides[i].component);
+	}
+
+	pthread_mutex_lock(&gECS.createEntityAccess);
+	juECSWaitCopy();
+
+	for (int i = 0; i < count; i++) {
+		JUEntityID entity = juECSReserveEntity();
+
+		// The blob already has the active byte set so a single copy per list sets up each component
+		for (int j = 0; j < prefab->componentCount; j++) {
+			JUComponent component = prefab->components[j];
+			const uint8_t *blob = ((uint8_t*)prefab->defaults) + prefab->offsets[j];
+			ids[j] = juECSReserveComponent(component, entity);
+			juECSSetComponentID(component, entity, ids[j]);
+			memcpy(juECSGetComponentFromID(component, ids[j]), blob, gECS.componentSizes[component] + 1);
+			memcpy(juECSGetPreviousComponentFromID(component, ids[j]), blob, gECS.componentSizes[component] + 1);
+		}
+
+		for (int j = 0; j < overrideCount; j++) {
+			if (overrideIndices[j] != -1) {
+				const JUPrefabOverride *override = &overrides[j];
+				size_t stride = override->stride != 0 ? override->stride : override->size;
+				const uint8_t *value = ((const uint8_t*)override->values) + (stride * i);
+				memcpy(((uint8_t*)juECSGetComponentFromID(override->component, ids[overrideIndices[j]])) + override->offset, value, override->size);
+				memcpy(((uint8_t*)juECSGetPreviousComponentFromID(override->component, ids[overrideIndices[j]])) + override->offset, value, override->size);
+			}
+		}
+
+		juECSGetEntity(entity)->type = prefab->type;
+		juECSGetEntity(entity)->exists = true;
+		gECS.hierarchyDirty = true;
+		if (entities != NULL)
+			entities[i] = entity;
+	}
+
+	pthread_mutex_unlock(&gECS.createEntityAccess);
+}
+
+void juECSFreePrefab(JUPrefab prefab) {
+	if (prefab != NULL) {
+		juFree(prefab->components);
+		juFree(prefab->offsets);
+		juFree(prefab->defaults);
+		juFree(prefab);
+	}
+}
+
+void *juECSGetResource(JUResource resource) {
+	if (resource >= 0 && resource < gECS.resourceCount)
+		return gECS.resources + gECS.resourceOffsets[resource];
+	return NULL;
+}
+
+const void *juECSGetPreviousResource(JUResource resource) {
+	if (resource >= 0 && resource < gECS.resourceCount)
+		return gECS.previousResources + gECS.resourceOffsets[resource];
+	return NULL;
+}
+
+void *juECSGetComponent(JUComponent component, JUEntityID entity) {
+	if (entity != JU_INVALID_ENTITY && entity < gECS.entityCount) {
+		JUComponentID id = juECSGetComponentID(component, entity);
+
+		// Getting the current component counts as writing to it, the chunk's version is only touched
+		// if it changes so systems writing to the same chunk don't keep fighting over its cache line.
+		// Chunks never move, so a bump can't land in an old copy of the directory while another system grows it
+		if (id != JU_NO_COMPONENT) {
+			JUComponentChunk *chunk = juECSGetChunk(component, id);
+			const uint32_t version = (uint32_t)gECS.frame + 1;
+			chunk->versions[id % JU_ECS_CHUNK_SIZE] = version;
+			if (atomic_load_explicit(&chunk->version, memory_order_relaxed) != version)
+				atomic_store_explicit(&chunk->version, version, memory_order_relaxed);
+		}
+		return juECSGetComponentFromID(component, id);
+	}
+	return NULL;
+}
+
+const void *juECSGetPreviousComponent(JUComponent component, JUEntityID entity) {
 	if (entity != JU_INVALID_ENTITY && entity < gECS.entityCount)
-		gECS.entities[entity].queueDeletion = true;
+		return juECSGetPreviousComponentFromID(component, juECSGetComponentID(component, entity));
+	return NULL;
 }
 
-void juECSDestroyAll() {
-	for (int i = 0; i < gECS.entityCount; i++)
-		juECSDestroyEntity(i);
+// Queues either the render or simulation systems
+static void juECSQueueSystems(bool render) {
+	for (int i = 0; i < gECS.systemCount; i++) {
+		if (gECS.systems[i].render == render) {
+			// Nothing gets drawn while resimulating
+			if (render && gECS.history.resimulating) {
+				juECSFinishSystem(i);
+			} else {
+				JUJob job = {JU_JOB_CHANNEL_SYSTEMS, juECSJobSystem, (void*)&gECS.systems[i]};
+				juJobQueue(job);
+			}
+		}
+	}
 }
 
-bool juECSEntityHasComponents(JUEntityID entity, JUComponent *components, int componentCount) {
-	if (juECSEntityExists(entity)) {
-		bool out = true;
-		for (int i = 0; i < componentCount; i++)
-			if (gECS.entities[entity].components[components[i]] == JU_NO_COMPONENT)
-				out = false;
-		return out;
+void juECSRunSystems() {
+	// Make sure all data is copied before starting next frame processing
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+
+	// Run all systems as jobs
+	for (int i = 0; i < gECS.systemCount; i++)
+		gECS.systemFinished[i] = false;
+	gECS.framePipelined = gECS.pipelineMode == JU_PIPELINE_OVERLAPPED;
+	atomic_store(&gECS.systemsRemaining, gECS.systemCount + 1);
+	juECSQueueSystems(gECS.renderFirst);
+	juECSQueueSystems(!gECS.renderFirst);
+}
+
+void juECSCopyState() {
+	if (gECS.framePipelined) {
+		// Whichever simulation system finishes last queues the copy, only render systems hold up the main thread.
+		// The copy channel is held open until then so waiting on it still waits for the systems
+		juECSWaitRenderFinished();
+		gJobSystem.channels[JU_JOB_CHANNEL_COPY] += 1;
+		juECSFinishPipelineStep();
+	} else {
+		// Wait for all systems to finish before copying
+		juJobWaitChannel(JU_JOB_CHANNEL_SYSTEMS);
+		JUJob job = {JU_JOB_CHANNEL_COPY, juECSJobCopy, NULL};
+		juJobQueue(job);
 	}
-	return false;
 }
 
-/********************** Clock **********************/
+void juECSSetPipeline(JUPipelineMode mode, bool renderFirst) {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	gECS.pipelineMode = mode;
+	gECS.renderFirst = renderFirst;
+}
 
-void juClockReset(JUClock *clock) {
-	clock->totalTime = 0;
-	clock->totalIterations = 0;
-	clock->lastTime = 0;
-	juClockStart(clock);
+void juECSWaitRenderFinished() {
+	for (int i = 0; i < gECS.systemCount; i++)
+		if (gECS.systems[i].render)
+			juECSWaitSystemFinished(i);
 }
 
-void juClockStart(JUClock *clock) {
-	clock->lastTime = SDL_GetPerformanceCounter();
+void juECSLockNext(JUECSLock *lock) {
+	if (*lock != JU_DISABLED_LOCK) {
+		*lock += 1;
+	}
 }
 
-double juClockTime(JUClock *clock) {
-	return ((double)SDL_GetPerformanceCounter() - (double)clock->lastTime) / (double)SDL_GetPerformanceFrequency();
+void juECSLockWait(JUECSLock *lock, int index) {
+	if (*lock != JU_DISABLED_LOCK && *lock != index) {
+		uint64_t start = SDL_GetPerformanceCounter();
+		bool done = false;
+		while (!done)
+			done = *lock == index;
+
+		// Only time spent actually spinning is recorded
+		if (gCurrentSystem != -1)
+			gECS.systemStats[gCurrentSystem].lockWaitTime += juTicksToSeconds(SDL_GetPerformanceCounter() - start);
+	}
 }
 
-double juClockTick(JUClock *clock) {
-	double time = juClockTime(clock);
-	clock->totalTime += time;
-	clock->totalIterations++;
-	juClockStart(clock);
-	return time;
+void juECSLockReset(JUECSLock *lock) {
+	if (*lock != JU_DISABLED_LOCK) {
+		*lock = 0;
+	}
 }
 
-void juClockFramerate(JUClock *clock, double framerate) {
-	double time = juClockTime(clock);
-	clock->totalTime += time;
-	clock->totalIterations++;
+void juECSLockDisable(JUECSLock *lock) {
+	*lock = JU_DISABLED_LOCK;
+}
 
-	bool done = false;
-	while (!done)
-		done = juClockTime(clock) >= 1.0 / framerate;
+void juECSEntityIterStart() {
+	juECSWaitCopy();
+	pthread_mutex_lock(&gECS.createEntityAccess);
+	gECS.entityIterator = 0;
+}
+
+JUEntity *juECSEntityIterNext() {
+	JUEntity *out = NULL;
+
+	// Find the next entity that exists
+	while (out == NULL && gECS.entityIterator < gECS.entityCount) {
+		if (juECSGetEntity(gECS.entityIterator)->exists)
+			out = juECSGetEntity(gECS.entityIterator);
+		gECS.entityIterator += 1;
+	}
+
+	return out;
+}
+
+void juECSEntityIterEnd() {
+	pthread_mutex_unlock(&gECS.createEntityAccess);
+}
+
+// Checks if an entity has everything a query needs
+static bool juECSQueryMatches(JUECSQuery query, JUEntityID entity) {
+	JUEntity *e = juECSGetEntity(entity);
+	if (!e->exists)
+		return false;
+	if (gECS.componentCount < 64)
+		return (e->type & query->mask) == query->mask;
+	for (int i = 0; i < query->componentCount; i++)
+		if (juECSGetComponentID(query->components[i], entity) == JU_NO_COMPONENT)
+			return false;
+	return true;
+}
+
+// Collects every entity in a batch of a query (batches line up with the entity/sparse component chunks)
+static int juECSQueryCollect(JUECSQuery query, int batch, JUEntityID *out) {
+	int limit = query->sparse != -1 ? gECS.sparseSets[query->sparse].count : gECS.entityCount;
+	int end = (batch + 1) * JU_ECS_CHUNK_SIZE;
+	int count = 0;
+	end = end < limit ? end : limit;
+
+	for (int i = batch * JU_ECS_CHUNK_SIZE; i < end; i++) {
+		JUEntityID entity = query->sparse != -1 ? juECSGetComponentOwner(query->sparse, i) : i;
+		if (juECSQueryMatches(query, entity))
+			out[count++] = entity;
+	}
+
+	return count;
+}
+
+// Job for collecting and processing a single batch of a parallel query
+static void juECSJobQuery(void *ptr) {
+	JUECSQueryJob *job = ptr;
+	JUEntityID entities[JU_ECS_CHUNK_SIZE];
+	int count = juECSQueryCollect(job->query, job->batch, entities);
+	if (count > 0)
+		job->query->job(entities, count, job->query->data);
+}
+
+JUECSQuery juECSQueryCreate(const JUComponent *components, int componentCount) {
+	JUECSQuery query = juMallocZero(sizeof(struct JUECSQuery));
+	query->components = juMalloc(sizeof(JUComponent) * (componentCount > 0 ? componentCount : 1));
+	query->componentCount = componentCount;
+	query->batch = juMalloc(sizeof(JUEntityID) * JU_ECS_CHUNK_SIZE);
+	for (int i = 0; i < componentCount; i++) {
+		query->components[i] = components[i];
+		query->mask |= (JUEntityType)1 << components[i];
+	}
+	return query;
+}
+
+void juECSQueryStart(JUECSQuery query) {
+	juECSWaitCopy();
+
+	// Same as systems, only the smallest sparse list needs to be walked if there is one
+	query->sparse = -1;
+	for (int i = 0; i < query->componentCount; i++) {
+		JUComponent component = query->components[i];
+		if (gECS.denseIndices[component] == -1 && (query->sparse == -1 || gECS.sparseSets[component].count < gECS.sparseSets[query->sparse].count))
+			query->sparse = component;
+	}
+
+	int limit = query->sparse != -1 ? gECS.sparseSets[query->sparse].count : gECS.entityCount;
+	query->batchCount = (limit + JU_ECS_CHUNK_SIZE - 1) / JU_ECS_CHUNK_SIZE;
+	query->position = 0;
+}
+
+int juECSQueryNext(JUECSQuery query, const JUEntityID **entities) {
+	int count = 0;
+
+	// Empty batches are skipped
+	while (count == 0 && query->position < query->batchCount)
+		count = juECSQueryCollect(query, query->position++, query->batch);
+
+	*entities = query->batch;
+	return count;
+}
+
+void juECSQueryParallel(JUECSQuery query, int channel, void (*job)(const JUEntityID *entities, int count, void *data), void *data) {
+	juECSQueryStart(query);
+	query->job = job;
+	query->data = data;
+	if (query->batchCount > query->jobListSize) {
+		query->jobs = juRealloc(query->jobs, sizeof(struct JUECSQueryJob) * query->batchCount);
+		query->jobListSize = query->batchCount;
+	}
+
+	for (int i = 0; i < query->batchCount; i++) {
+		query->jobs[i].query = query;
+		query->jobs[i].batch = i;
+		JUJob batchJob = {channel, juECSJobQuery, &query->jobs[i]};
+		juJobQueue(batchJob);
+	}
+	query->position = query->batchCount;
+}
+
+void juECSQueryFree(JUECSQuery query) {
+	if (query != NULL) {
+		juFree(query->components);
+		juFree(query->batch);
+		juFree(query->jobs);
+		juFree(query);
+	}
+}
+
+JUEntityType juECSGetEntityType(JUEntityID entity) {
+	if (entity != JU_INVALID_ENTITY && entity < gECS.entityCount)
+		return juECSGetEntity(entity)->type;
+	return JU_INVALID_TYPE;
+}
+
+bool juECSEntityExists(JUEntityID entity) {
+	return entity != JU_INVALID_ENTITY && entity < gECS.entityCount && juECSGetEntity(entity)->exists;
+}
+
+bool juECSSameType(JUEntityID entity1, JUEntityID entity2) {
+	if (gECS.componentCount < 64 && juECSEntityExists(entity1) && juECSEntityExists(entity2)) {
+		return juECSGetEntityType(entity1) == juECSGetEntityType(entity2);
+	} else if (juECSEntityExists(entity1) && juECSEntityExists(entity2)) {
+		bool out = true;
+
+		for (int i = 0; i < gECS.componentCount; i++) {
+			if (!((juECSGetComponentID(i, entity1) == JU_NO_COMPONENT &&
+				   juECSGetComponentID(i, entity2) == JU_NO_COMPONENT) ||
+				  (juECSGetComponentID(i, entity1) != JU_NO_COMPONENT &&
+				   juECSGetComponentID(i, entity2) != JU_NO_COMPONENT)))
+				out = false;
+		}
+
+		return out;
+	}
+	return false;
+}
+
+void juECSDestroyEntity(JUEntityID entity) {
+	if (entity != JU_INVALID_ENTITY && entity < gECS.entityCount)
+		juECSGetEntity(entity)->queueDeletion = true;
+}
+
+void juECSDestroyAll() {
+	for (int i = 0; i < gECS.entityCount; i++)
+		juECSDestroyEntity(i);
+}
+
+bool juECSEntityHasComponents(JUEntityID entity, JUComponent *components, int componentCount) {
+	if (juECSEntityExists(entity)) {
+		bool out = true;
+		for (int i = 0; i < componentCount; i++)
+			if (juECSGetComponentID(components[i], entity) == JU_NO_COMPONENT)
+				out = false;
+		return out;
+	}
+	return false;
+}
+
+void juECSSpatialEnable(JUComponent component, double cellSize, void (*bounds)(const void *component, JURectangle *bounds)) {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	gECS.spatialEnabled = true;
+	gECS.spatialComponent = component;
+	gECS.spatialBounds = bounds;
+	juECSSpatialRebuild(cellSize);
+}
+
+int juECSSpatialQuery(const JURectangle *area, JUEntityID *entities, int size) {
+	if (!gECS.spatialEnabled)
+		return 0;
+	return juSpatialGridQuery(gECS.spatial, area, entities, size);
+}
+
+void juECSSetCompactionBudget(int moves) {
+	gECS.compactionBudget = moves;
+}
+
+void juECSCompactNow() {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	pthread_mutex_lock(&gECS.createEntityAccess);
+	juECSCompact(INT_MAX);
+	pthread_mutex_unlock(&gECS.createEntityAccess);
+}
+
+void juECSStreamingEnable(int channel, int spawnBudget, int despawnBudget) {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	gECS.streamingEnabled = true;
+	gECS.streamChannel = channel;
+	gECS.spawnBudget = spawnBudget;
+	gECS.despawnBudget = despawnBudget;
+}
+
+JURegion juECSRegionCreate(const char *filename, bool onDisk) {
+	juECSWaitCopy();
+	pthread_mutex_lock(&gECS.createEntityAccess);
+	if (gECS.regionCount == gECS.regionListSize) {
+		gECS.regionListSize += juListGrowth(gECS.regionListSize);
+		gECS.regions = juRealloc(gECS.regions, sizeof(JUStreamRegion*) * gECS.regionListSize);
+	}
+	JUStreamRegion *region = juMallocZero(sizeof(struct JUStreamRegion));
+	region->filename = juCopyString(filename);
+	region->state = onDisk ? JU_REGION_UNLOADED : JU_REGION_LOADED;
+	gECS.regions[gECS.regionCount] = region;
+	JURegion out = gECS.regionCount++;
+	pthread_mutex_unlock(&gECS.createEntityAccess);
+	return out;
+}
+
+bool juECSRegionAdd(JURegion region, JUEntityID entity) {
+	juECSWaitCopy();
+	if (region < 0 || region >= gECS.regionCount || gECS.regions[region]->state != JU_REGION_LOADED || !juECSEntityExists(entity))
+		return false;
+	JUStreamRegion *r = gECS.regions[region];
+	pthread_mutex_lock(&gECS.createEntityAccess);
+	if (juECSGetEntity(entity)->region == region) {
+		pthread_mutex_unlock(&gECS.createEntityAccess);
+		return true;
+	}
+
+	// Drop members that were destroyed or moved to another region before the list grows
+	if (r->members.count == r->members.listSize) {
+		int count = 0;
+		for (int i = 0; i < r->members.count; i++)
+			if (juECSEntityExists(r->members.entities[i]) && juECSGetEntity(r->members.entities[i])->region == region)
+				r->members.entities[count++] = r->members.entities[i];
+		r->members.count = count;
+	}
+
+	juECSGetEntity(entity)->region = region;
+	juEntityListPush(&r->members, entity);
+	pthread_mutex_unlock(&gECS.createEntityAccess);
+	return true;
+}
+
+bool juECSRegionUnload(JURegion region) {
+	juECSWaitCopy();
+	if (region < 0 || region >= gECS.regionCount || gECS.regions[region]->state != JU_REGION_LOADED)
+		return false;
+	JUStreamRegion *r = gECS.regions[region];
+	r->cursor = 0;
+	r->remaining = 0;
+	r->writing = false;
+	juECSRegionWriteHeader(r);
+	r->state = JU_REGION_UNLOADING;
+	return true;
+}
+
+bool juECSRegionLoad(JURegion region) {
+	juECSWaitCopy();
+	if (region < 0 || region >= gECS.regionCount || gECS.regions[region]->state != JU_REGION_UNLOADED)
+		return false;
+	JUStreamRegion *r = gECS.regions[region];
+	r->ready = false;
+	r->state = JU_REGION_LOADING;
+	JUJob job = {gECS.streamChannel, juECSJobRegionLoad, r};
+	juJobQueue(job);
+	return true;
+}
+
+JURegionState juECSRegionGetState(JURegion region) {
+	if (region < 0 || region >= gECS.regionCount)
+		return JU_REGION_UNLOADED;
+	return gECS.regions[region]->state;
+}
+
+void juECSTrackComponents(const JUComponent *components, int componentCount) {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	for (int i = 0; i < componentCount; i++)
+		gECS.trackedComponents[components[i]] = true;
+}
+
+// Gets one of a component's event lists from the last frame
+static int juECSGetEvents(JUComponent component, const JUEntityList *list, const JUEntityID **entities) {
+	*entities = list->entities;
+	return gECS.trackedComponents[component] ? list->count : 0;
+}
+
+int juECSGetAdded(JUComponent component, const JUEntityID **entities) {
+	return juECSGetEvents(component, &gECS.events[component].added, entities);
+}
+
+int juECSGetRemoved(JUComponent component, const JUEntityID **entities) {
+	return juECSGetEvents(component, &gECS.events[component].removed, entities);
+}
+
+int juECSGetChanged(JUComponent component, const JUEntityID **entities) {
+	return juECSGetEvents(component, &gECS.events[component].changed, entities);
+}
+
+void juECSTransformEnable(JUComponent component) {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	gECS.transformEnabled = true;
+	gECS.transformComponent = component;
+	gECS.hierarchyDirty = true;
+}
+
+bool juECSSetParent(JUEntityID child, JUEntityID parent) {
+	if (!juECSEntityExists(child) || (parent != JU_INVALID_ENTITY && !juECSEntityExists(parent)))
+		return false;
+	juECSWaitCopy();
+
+	// An entity can't be its own ancestor, the check and the write are locked together so two calls can't form a cycle
+	pthread_mutex_lock(&gECS.createEntityAccess);
+	for (JUEntityID ancestor = parent; ancestor != JU_INVALID_ENTITY; ancestor = juECSGetEntity(ancestor)->parent) {
+		if (ancestor == child) {
+			pthread_mutex_unlock(&gECS.createEntityAccess);
+			juLog("Entity %i can't be parented to its own descendant %i", child, parent);
+			return false;
+		}
+	}
+
+	juECSGetEntity(child)->parent = parent;
+	gECS.hierarchyDirty = true;
+	pthread_mutex_unlock(&gECS.createEntityAccess);
+	return true;
+}
+
+JUEntityID juECSGetParent(JUEntityID entity) {
+	if (juECSEntityExists(entity))
+		return juECSGetEntity(entity)->parent;
+	return JU_INVALID_ENTITY;
+}
+
+const JUECSStats *juECSGetStats() {
+	return &gECS.stats[gECS.statsIndex];
+}
+
+#ifndef JU_HEADLESS
+void juECSDrawStats(JUFont font, float x, float y) {
+	const JUECSStats *stats = juECSGetStats();
+	juFontDraw(font, x, y, "Frame %llu: %i entities, copy %.3fms, waiting %.3fms", (unsigned long long)stats->frame, stats->entities, stats->copyTime * 1000, stats->waitTime * 1000);
+
+	// Each system gets its own line so long system lists don't overflow the font's string buffer
+	for (int i = 0; i < stats->systemCount; i++) {
+		y += font->newLineHeight;
+		juFontDraw(font, x, y, "System %i: %.3fms, %i entities, %.3fms locked", i, stats->systems[i].time * 1000, stats->systems[i].entities, stats->systems[i].lockWaitTime * 1000);
+	}
+}
+#endif // JU_HEADLESS
+
+JUFrame juECSGetFrame() {
+	return gECS.frame;
+}
+
+void juECSHistoryEnable(int frames) {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	juECSHistoryFree();
+
+	if (frames > 0) {
+		JUECSHistory *history = &gECS.history;
+		history->capacity = frames;
+		history->streamCount = gECS.componentCount + 2;
+		history->frames = juMallocZero(sizeof(struct JUECSHistoryFrame) * frames);
+		history->latest = juMallocZero(sizeof(uint8_t*) * history->streamCount);
+		history->latestSizes = juMallocZero(sizeof(uint32_t) * history->streamCount);
+		for (int i = 0; i < frames; i++) {
+			history->frames[i].sizes = juMallocZero(sizeof(uint32_t) * history->streamCount);
+			history->frames[i].deltas = juMallocZero(sizeof(uint8_t*) * history->streamCount);
+			history->frames[i].deltaSizes = juMallocZero(sizeof(uint32_t) * history->streamCount);
+		}
+
+		// The current state is the first frame in the history
+		juECSHistoryRecord();
+	}
+}
+
+JUFrame juECSHistoryOldestFrame() {
+	if (gECS.history.count > 0)
+		return gECS.history.frames[gECS.history.start].frame;
+	return gECS.frame;
+}
+
+bool juECSHistoryGetComponent(JUComponent component, JUEntityID entity, JUFrame frame, void *dst) {
+	JUECSHistory *history = &gECS.history;
+	if (juECSHistoryGetFrame(frame) == NULL || entity == JU_INVALID_ENTITY)
+		return false;
+	const int table = gECS.componentCount;
+	const JUFrame newest = history->frames[(history->start + history->count - 1) % history->capacity].frame;
+
+	// Work backwards from the newest frame to find this entity's row in the table on that frame
+	uint32_t rowSize = juECSHistoryRowSize();
+	uint8_t row[rowSize];
+	memset(row, 0, rowSize);
+	uint32_t rowStart = rowSize * entity;
+	if (rowStart + rowSize <= history->latestSizes[table])
+		memcpy(row, history->latest[table] + rowStart, rowSize);
+	for (JUFrame f = newest; f > frame; f--) {
+		JUECSHistoryFrame *older = juECSHistoryGetFrame(f - 1);
+		juECSHistoryApply(row, rowStart, rowSize, older->deltas[table], older->deltaSizes[table]);
+	}
+	JUComponentID id;
+	memcpy(&id, row + juECSHistoryIDOffset(component), sizeof(JUComponentID));
+	if (!row[0] || id == JU_NO_COMPONENT)
+		return false;
+
+	// Same thing for the component itself, which includes the active byte at the end
+	uint32_t componentSize = gECS.componentSizes[component] + 1;
+	uint8_t data[componentSize];
+	memset(data, 0, componentSize);
+	uint32_t componentStart = componentSize * id;
+	if (componentStart + componentSize <= history->latestSizes[component])
+		memcpy(data, history->latest[component] + componentStart, componentSize);
+	for (JUFrame f = newest; f > frame; f--) {
+		JUECSHistoryFrame *older = juECSHistoryGetFrame(f - 1);
+		juECSHistoryApply(data, componentStart, componentSize, older->deltas[component], older->deltaSizes[component]);
+	}
+	if (!data[componentSize - 1])
+		return false;
+	memcpy(dst, data, componentSize - 1);
+	return true;
+}
+
+bool juECSHistoryRestore(JUFrame frame) {
+	JUECSHistory *history = &gECS.history;
+	JUECSHistoryFrame *target = juECSHistoryGetFrame(frame);
+	if (target == NULL)
+		return false;
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	pthread_mutex_lock(&gECS.createEntityAccess);
+	const JUFrame newest = history->frames[(history->start + history->count - 1) % history->capacity].frame;
+
+	// Rebuild every stream by walking the deltas back from the newest frame
+	for (int i = 0; i < history->streamCount; i++) {
+		uint32_t size = history->latestSizes[i];
+		for (JUFrame f = frame; f < newest; f++)
+			if (juECSHistoryGetFrame(f)->sizes[i] > size)
+				size = juECSHistoryGetFrame(f)->sizes[i];
+
+		uint8_t *state = juMallocZero(size > 0 ? size : 1);
+		memcpy(state, history->latest[i], history->latestSizes[i]);
+		for (JUFrame f = newest; f > frame; f--) {
+			JUECSHistoryFrame *older = juECSHistoryGetFrame(f - 1);
+			juECSHistoryApply(state, 0, size, older->deltas[i], older->deltaSizes[i]);
+		}
+		juFree(history->latest[i]);
+		history->latest[i] = state;
+		history->latestSizes[i] = target->sizes[i];
+	}
+
+	// Everything newer than the target frame is gone now
+	for (JUFrame f = frame; f <= newest; f++)
+		juECSHistoryClearFrame(juECSHistoryGetFrame(f));
+	history->count = (int)(frame - history->frames[history->start].frame) + 1;
+
+	// Resources are a single block, the same size every frame
+	if (gECS.resourcesSize > 0) {
+		memcpy(gECS.resources, history->latest[gECS.componentCount + 1], gECS.resourcesSize);
+		memcpy(gECS.previousResources, gECS.resources, gECS.resourcesSize);
+	}
+
+	// Put the components back, restoring doesn't shrink lists so anything past the restored state is inactive
+	for (int i = 0; i < gECS.componentCount; i++) {
+		uint32_t chunkSize = (gECS.componentSizes[i] + 1) * JU_ECS_CHUNK_SIZE;
+		gECS.componentFreeHints[i] = 0;
+		juECSReserveComponentList(i, history->latestSizes[i] / (gECS.componentSizes[i] + 1));
+		for (int j = 0; j < gECS.componentListSizes[i] / JU_ECS_CHUNK_SIZE; j++) {
+			JUComponentChunk *chunk = gECS.componentChunks[i][j];
+			uint32_t start = chunkSize * j;
+			uint32_t size = start < history->latestSizes[i] ? history->latestSizes[i] - start : 0;
+			size = size > chunkSize ? chunkSize : size;
+			memcpy(chunk->current, history->latest[i] + start, size);
+			memset(chunk->current + size, 0, chunkSize - size);
+			memcpy(chunk->previous, chunk->current, chunkSize);
+		}
+	}
+
+	// Sparse lookups are rebuilt along with the entities
+	for (int j = 0; j < gECS.componentCount; j++) {
+		if (gECS.denseIndices[j] == -1) {
+			JUSparseSet *set = &gECS.sparseSets[j];
+			for (int k = 0; k < set->pageCount; k++)
+				juFree(set->pages[k]);
+			juFree(set->pages);
+			set->pages = NULL;
+			set->pageCount = 0;
+			set->count = 0;
+		}
+	}
+
+	// Put the entities back
+	const uint32_t rowSize = juECSHistoryRowSize();
+	const uint8_t *table = history->latest[gECS.componentCount];
+	const int rows = history->latestSizes[gECS.componentCount] / rowSize;
+	while (gECS.entityCount < rows)
+		juECSGrowEntityList();
+	for (int i = 0; i < gECS.entityCount; i++) {
+		juECSClearEntity(i);
+		if (i < rows) {
+			const uint8_t *row = table + (rowSize * i);
+			memcpy(&juECSGetEntity(i)->type, row + 1, sizeof(JUEntityType));
+			memcpy(&juECSGetEntity(i)->parent, row + 1 + sizeof(JUEntityType), sizeof(JUEntityID));
+			for (int j = 0; j < gECS.componentCount; j++) {
+				JUComponentID id;
+				memcpy(&id, row + juECSHistoryIDOffset(j), sizeof(JUComponentID));
+				if (id != JU_NO_COMPONENT) {
+					juECSSetComponentID(j, i, id);
+					juECSSetComponentOwner(j, id, i);
+					if (gECS.denseIndices[j] == -1)
+						gECS.sparseSets[j].count++;
+				}
+			}
+			juECSGetEntity(i)->exists = row[0];
+		}
+	}
+
+	if (gECS.spatialEnabled)
+		juECSSpatialRebuild(gECS.spatial->cellSize);
+	gECS.hierarchyDirty = true;
+	gECS.entityFreeHint = 0;
+	gECS.frame = frame;
+	pthread_mutex_unlock(&gECS.createEntityAccess);
+	return true;
+}
+
+void juECSHistoryResimulate(JUFrame frame, void (*prepareFrame)(JUFrame frame)) {
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	gECS.history.resimulating = true;
+	while (gECS.frame < frame) {
+		if (prepareFrame != NULL)
+			prepareFrame(gECS.frame + 1);
+		juECSRunSystems();
+		juECSCopyState();
+		juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	}
+	gECS.history.resimulating = false;
+}
+
+bool juECSIsResimulating() {
+	return gECS.history.resimulating;
+}
+
+/********************** Clock **********************/
+
+void juClockReset(JUClock *clock) {
+	clock->totalTime = 0;
+	clock->totalIterations = 0;
+	clock->lastTime = 0;
+	juClockStart(clock);
+}
+
+void juClockStart(JUClock *clock) {
+	clock->lastTime = SDL_GetPerformanceCounter();
+}
+
+double juClockTime(JUClock *clock) {
+	return ((double)SDL_GetPerformanceCounter() - (double)clock->lastTime) / (double)SDL_GetPerformanceFrequency();
+}
+
+double juClockTick(JUClock *clock) {
+	double time = juClockTime(clock);
+	clock->totalTime += time;
+	clock->totalIterations++;
+	juClockStart(clock);
+	return time;
+}
+
+void juClockFramerate(JUClock *clock, double framerate) {
+	double time = juClockTime(clock);
+	clock->totalTime += time;
+	clock->totalIterations++;
+
+	bool done = false;
+	while (!done)
+		done = juClockTime(clock) >= 1.0 / framerate;
+
+	juClockStart(clock);
+}
+
+double juClockGetAverage(JUClock *clock) {
+	return clock->totalTime / clock->totalIterations;
+}
+
+#ifndef JU_HEADLESS
+/********************** Font **********************/
+
+JUFont juFontLoad(const char *filename) {
+	JUFont font = juMalloc(sizeof(struct JUFont));
+	bool error;
+	JUBinaryFont binaryFont = juLoadBinaryFont(filename, &error);
+
+	if (!error) {
+		// Create an SDL surface for the png
+		int w, h, channels;
+		void *pixels = stbi_load_from_memory(binaryFont.png, binaryFont.size, &w, &h, &channels, 4);
+
+		if (pixels != NULL) {
+			font->image = vk2dImageFromPixels(vk2dRendererGetDevice(), pixels, w, h);
+			free(pixels);
+			font->bitmap = vk2dTextureLoadFromImage(font->image);
+
+			// Basic data
+			font->unicodeStart = 1;
+			font->unicodeEnd = binaryFont.characters + 1;
+			font->characters = juMalloc(sizeof(struct JUCharacter) * binaryFont.characters);
+			font->newLineHeight = 0;
+
+			// Load the characters
+			int x = 0;
+			for (int i = 0; i < binaryFont.characters; i++) {
+				font->characters[i].x = x;
+				font->characters[i].y = 0;
+				font->characters[i].w = binaryFont.characterDimensions[i].width;
+				font->characters[i].h = binaryFont.characterDimensions[i].height;
+				if (font->newLineHeight < font->characters[i].h)
+					font->newLineHeight = font->characters[i].h;
+				x += binaryFont.characterDimensions[i].width;
+				font->characters[i].drawn = i >= 32;
+			}
+		} else {
+			juLog("Failed to load font's image");
+		}
+
+		free(binaryFont.png);
+		free(binaryFont.characterDimensions);
+	}
+
+	return font;
+}
+
+JUFont juFontLoadFromImage(const char *image, uint32_t unicodeStart, uint32_t unicodeEnd, float w, float h) {
+	// Setup font struct
+	JUFont font = juMalloc(sizeof(struct JUFont));
+	font->characters = juMalloc(sizeof(struct JUCharacter) * (unicodeEnd - unicodeStart));
+	font->bitmap = vk2dTextureLoad(image);
+	font->image = NULL;
+	font->newLineHeight = h;
+	font->unicodeStart = unicodeStart;
+	font->unicodeEnd = unicodeEnd;
+
+	// Make sure the texture loaded and the texture has enough space to load the desired characters
+	if (font->bitmap != NULL && w * h * (unicodeEnd - unicodeStart) <= font->bitmap->img->width * font->bitmap->img->height) {
+		// Calculate positions of every character in the font
+		float x = 0;
+		float y = 0;
+		int i = unicodeStart;
+		while (i < unicodeEnd) {
+			font->characters[i - unicodeStart].x = x;
+			font->characters[i - unicodeStart].y = y;
+			font->characters[i - unicodeStart].w = w;
+			font->characters[i - unicodeStart].h = h;
+			font->characters[i - unicodeStart].drawn = true;
+			if (x + w >= font->bitmap->img->width) {
+				y += h;
+				x = 0;
+			} else {
+				x += w;
+			}
+			i++;
+		}
+	} else {
+		juLog("Failed to load texture \"%s\"", image);
+		vk2dTextureFree(font->bitmap);
+		free(font->characters);
+		free(font);
+		font = NULL;
+	}
+
+	return font;
+}
+
+void juFontFree(JUFont font) {
+	if (font != NULL) {
+		vk2dTextureFree(font->bitmap);
+		vk2dImageFree(font->image);
+		free(font->characters);
+		free(font);
+	}
+}
+
+void juFontDraw(JUFont font, float x, float y, const char *fmt, ...) {
+	// Var args stuff
+	unsigned char buffer[JU_STRING_BUFFER];
+	va_list va;
+	va_start(va, fmt);
+	vsprintf((void*)buffer, fmt, va);
+	va_end(va);
+
+	// Information needed to draw the text
+	float startX = x;
+	int len = strlen((void*)buffer);
+
+	// Loop through each character and render individually
+	for (int i = 0; i < len; i++) {
+		if (font->unicodeStart <= buffer[i] && font->unicodeEnd > buffer[i]) {
+			JUCharacter *c = &font->characters[buffer[i] - font->unicodeStart];
+
+			// Move to the next line if we're about to go over
+			if (buffer[i] == '\n') {
+				x = startX;
+				y += font->newLineHeight;
+			}
+
+			// Draw character (or not) and move the cursor forward
+			if (c->drawn)
+				vk2dRendererDrawTexture(font->bitmap, x, y, 1, 1, 0, 0, 0, c->x, c->y, c->w, c->h);
+			if (buffer[i] != '\n') x += c->w;
+		}
+	}
+}
+
+void juFontDrawWrapped(JUFont font, float x, float y, float w, const char *fmt, ...) {
+	// Var args stuff
+	unsigned char buffer[JU_STRING_BUFFER];
+	va_list va;
+	va_start(va, fmt);
+	vsprintf((void*)buffer, fmt, va);
+	va_end(va);
+
+	// Information needed to draw the text
+	float startX = x;
+	int len = strlen((void*)buffer);
+	bool justMadeNewline = false;
+
+	// Loop through each character and render individually
+	for (int i = 0; i < len; i++) {
+		if (font->unicodeStart <= buffer[i] && font->unicodeEnd > buffer[i]) {
+			JUCharacter *c = &font->characters[buffer[i] - font->unicodeStart];
+
+			// Move to the next line if we're about to go over
+			if ((c->w + x) - startX > w || buffer[i] == '\n') {
+				x = startX;
+				y += font->newLineHeight;
+				justMadeNewline = true;
+			} else {
+				justMadeNewline = false;
+			}
+
+			// Draw character (or not) and move the cursor forward
+			if (!(buffer[i] == ' ' && justMadeNewline)) {
+				if (c->drawn)
+					vk2dRendererDrawTexture(font->bitmap, x, y, 1, 1, 0, 0, 0, c->x, c->y, c->w, c->h);
+				if (buffer[i] != '\n') x += c->w;
+			}
+		}
+	}
+}
+#endif // JU_HEADLESS
+
+/********************** Buffer **********************/
+
+JUBuffer juBufferLoad(const char *filename) {
+	JUBuffer buffer = juMalloc(sizeof(struct JUBuffer));
+	buffer->data = juGetFile(filename, &buffer->size);
+
+	if (buffer->data == NULL) {
+		free(buffer);
+		buffer = NULL;
+	}
+
+	return buffer;
+}
+
+JUBuffer juBufferCreate(void *data, uint32_t size) {
+	JUBuffer buffer = juMalloc(sizeof(struct JUBuffer));
+	buffer->data = juMalloc(size);
+	buffer->size = size;
+	memcpy(buffer->data, data, size);
+	return buffer;
+}
+
+void juBufferSave(JUBuffer buffer, const char *filename) {
+	FILE *out = fopen(filename, "wb");
+
+	if (out != NULL) {
+		fwrite(buffer->data, buffer->size, 1, out);
+		fclose(out);
+	} else {
+		juLog("Failed to open file \"%s\"", filename);
+	}
+}
+
+void juBufferFree(JUBuffer buffer) {
+	if (buffer != NULL) {
+		free(buffer->data);
+		free(buffer);
+	}
+}
+
+void juBufferSaveRaw(void *data, uint32_t size, const char *filename) {
+	FILE *out = fopen(filename, "wb");
+
+	if (out != NULL) {
+		fwrite(data, size, 1, out);
+		fclose(out);
+	} else {
+		juLog("Failed to open file \"%s\"", filename);
+	}
+}
+
+/********************** Jobs System **********************/
+
+void juJobQueue(JUJob job) {
+	gJobSystem.channels[job.channel] += 1;
+
+	// Wait for the queue and queue it
+	pthread_mutex_lock(&gJobSystem.queueAccess);
+
+	// Extend queue list, unwrapping the ring so the front is at 0 again
+	if (gJobSystem.queueListSize == gJobSystem.queueSize) {
+		int newSize = gJobSystem.queueListSize + juListGrowth(gJobSystem.queueListSize);
+		JUJob *queue = juMalloc(newSize * sizeof(JUJob));
+		for (int i = 0; i < gJobSystem.queueSize; i++)
+			queue[i] = gJobSystem.queue[(gJobSystem.queueStart + i) % gJobSystem.queueListSize];
+		juFree(gJobSystem.queue);
+		gJobSystem.queue = queue;
+		gJobSystem.queueListSize = newSize;
+		gJobSystem.queueStart = 0;
+	}
+	gJobSystem.queue[(gJobSystem.queueStart + gJobSystem.queueSize) % gJobSystem.queueListSize] = job;
+	gJobSystem.queueSize++;
+
+	pthread_mutex_unlock(&gJobSystem.queueAccess);
+}
+
+void juJobWaitChannel(int channel) {
+	if (gJobSystem.channels[channel] != 0) {
+		uint64_t start = SDL_GetPerformanceCounter();
+		bool done = false;
+		while (!done) {
+			done = gJobSystem.channels[channel] == 0;
+		}
+		gJobSystem.waitTicks += SDL_GetPerformanceCounter() - start;
+	}
+}
+
+#ifndef JU_HEADLESS
+/********************** Asset Loader **********************/
+
+// Puts an asset into the loader (properly)
+static void juLoaderAdd(JULoader loader, JUAsset asset) {
+	uint32_t hash = juHash(asset->name);
+
+	// Either we drop the asset right into its slot or send it down a linked
+	// list chain if there is a hash collision
+	if (loader->assets[hash] == NULL) {
+		loader->assets[hash] = asset;
+	} else {
+		JUAsset current = loader->assets[hash];
+		bool placed = false;
+		while (!placed) {
+			if (current->next == NULL) {
+				placed = true;
+				current->next = asset;
+			} else {
+				current = current->next;
+			}
+		}
+	}
+}
+
+// Just gets the raw asset from the loader
+static JUAsset juLoaderGet(JULoader loader, const char *key, JUAssetType type) {
+	JUAsset current = loader->assets[juHash(key)];
+	bool found = false;
+
+	while (!found) {
+		if (current != NULL && strcmp(current->name, key) == 0 && current->type == type) // this is the right asset
+			found = true;
+		else if (current != NULL) // wrong one, next one down the chain
+			current = current->next;
+		else // it doesn't exist, current should be null at this point
+			found = true;
+	}
+
+	return current;
+}
+
+// Frees a specific asset (not its next one in its chain though)
+static void juLoaderAssetFree(JUAsset asset) {
+	if (asset->type == JU_ASSET_TYPE_FONT) {
+		juFontFree(asset->Asset.font);
+	} else if (asset->type == JU_ASSET_TYPE_TEXTURE) {
+		vk2dTextureFree(asset->Asset.tex);
+	} else if (asset->type == JU_ASSET_TYPE_SOUND) {
+		juSoundFree(asset->Asset.sound);
+	} else if (asset->type == JU_ASSET_TYPE_BUFFER) {
+		juBufferFree(asset->Asset.buffer);
+	} else if (asset->type == JU_ASSET_TYPE_SPRITE) {
+		juSpriteFree(asset->Asset.sprite);
+	}
+	free((void*)asset->name);
+	free(asset);
+}
+
+JULoader juLoaderCreate(JULoadedAsset *files, uint32_t fileCount) {
+	JULoader loader = juMalloc(sizeof(struct JULoader));
+	JUAsset *assets = juMallocZero(JU_BUCKET_SIZE * sizeof(struct JUAsset));
+	loader->assets = assets;
+
+	// Load all assets
+	for (int i = 0; i < fileCount; i++) {
+		const char *extension = files[i].path + juLastDot(files[i].path) + 1;
+		JUAsset asset = juMalloc(sizeof(struct JUAsset));
+		asset->name = juCopyString(files[i].path);
+		asset->next = NULL;
+
+		// Load file based on asset
+		if (strcmp(extension, "jufnt") == 0) {
+			asset->type = JU_ASSET_TYPE_FONT;
+			asset->Asset.font = juFontLoad(files[i].path);
+		} else if (strcmp(extension, "png") == 0 || strcmp(extension, "jpg") == 0 || strcmp(extension, "jpeg") == 0 || strcmp(extension, "bmp") == 0) {
+			if (files[i].h + files[i].w + files[i].delay != 0) {
+				// Sprite
+				asset->type = JU_ASSET_TYPE_SPRITE; // TODO: Check for existing textures with the same name first
+
+				// Check if we already loaded the texture
+				JUAsset tex = juLoaderGet(loader, asset->name, JU_ASSET_TYPE_TEXTURE);
+				if (tex != NULL)
+					asset->Asset.sprite = juSpriteFrom(tex->Asset.tex, files[i].x, files[i].y, files[i].w, files[i].h, files[i].delay, files[i].frames);
+				else
+					asset->Asset.sprite = juSpriteCreate(files[i].path, files[i].x, files[i].y, files[i].w, files[i].h, files[i].delay, files[i].frames);
+				if (asset->Asset.sprite != NULL) {
+					asset->Asset.sprite->originX = files[i].originX;
+					asset->Asset.sprite->originY = files[i].originY;
+				}
+			} else {
+				// Just a textures
+				asset->type = JU_ASSET_TYPE_TEXTURE;
+				asset->Asset.tex = vk2dTextureLoad(files[i].path);
+			}
+		} else if (strcmp(extension, "wav") == 0) {
+			asset->type = JU_ASSET_TYPE_SOUND;
+			asset->Asset.sound = juSoundLoad(files[i].path);
+		} else {
+			asset->type = JU_ASSET_TYPE_BUFFER;
+			asset->Asset.buffer = juBufferLoad(files[i].path);
+		}
+
+		juLoaderAdd(loader, asset);
+	}
+
+	return loader;
+}
+
+VK2DTexture juLoaderGetTexture(JULoader loader, const char *filename) {
+	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_TEXTURE);
+	VK2DTexture out = NULL;
+
+	if (asset != NULL) {
+		out = asset->Asset.tex;
+	} else {
+		juLog("Asset \"%s\" was never loaded", filename);
+	}
+
+	return out;
+}
+
+JUFont juLoaderGetFont(JULoader loader, const char *filename) {
+	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_FONT);
+	JUFont out = NULL;
+
+	if (asset != NULL) {
+		out = asset->Asset.font;
+	} else {
+		juLog("Asset \"%s\" doesn't exist", filename);
+	}
+
+	return out;
+}
+
+JUSound juLoaderGetSound(JULoader loader, const char *filename) {
+	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_SOUND);
+	JUSound out = NULL;
+
+	if (asset != NULL) {
+		out = asset->Asset.sound;
+	} else {
+		juLog("Asset \"%s\" doesn't exist", filename);
+	}
+
+	return out;
+}
+
+JUBuffer juLoaderGetBuffer(JULoader loader, const char *filename) {
+	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_BUFFER);
+	JUBuffer out = NULL;
+
+	if (asset != NULL) {
+		out = asset->Asset.buffer;
+	} else {
+		juLog("Asset \"%s\" doesn't exist", filename);
+	}
+
+	return out;
+}
+
+JUSprite juLoaderGetSprite(JULoader loader, const char *filename) {
+	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_SPRITE);
+	JUSprite out = NULL;
+
+	if (asset != NULL) {
+		out = asset->Asset.sprite;
+	} else {
+		juLog("Asset \"%s\" doesn't exist", filename);
+	}
+
+	return out;
+}
+
+void juLoaderFree(JULoader loader) {
+	if (loader != NULL) {
+		for (int i = 0; i < JU_BUCKET_SIZE; i++) {
+			JUAsset current = loader->assets[i];
+			while (current != NULL) {
+				JUAsset next = current->next;
+				juLoaderAssetFree(current);
+				current = next;
+			}
+		}
+		free(loader->assets);
+	}
+}
+
+/********************** Sound **********************/
+
+JUSound juSoundLoad(const char *filename) {
+	JUSound sound = juMallocZero(sizeof(struct JUSound));
+	sound->sound = cs_load_wav(filename);
+	return sound;
+}
+
+JUPlayingSound juSoundPlay(JUSound sound, bool loop, float volumeLeft, float volumeRight) {
+	sound->soundInfo = cs_make_def(&sound->sound);
+	sound->soundInfo.looped = loop;
+	sound->soundInfo.volume_left = 0.5;
+	sound->soundInfo.volume_right = 0.5;
+	JUPlayingSound new = {cs_play_sound(gSoundContext, sound->soundInfo)};
+	return new;
+}
+
+void juSoundUpdate(JUPlayingSound sound, bool loop, float volumeLeft, float volumeRight) {
+	if (sound.playingSound != NULL && cs_is_active(sound.playingSound)) {
+		cs_loop_sound(sound.playingSound, loop);
+		cs_set_volume(sound.playingSound, volumeLeft, volumeRight);
+	}
+}
+
+void juSoundStop(JUPlayingSound sound) {
+	if (sound.playingSound != NULL && cs_is_active(sound.playingSound))
+		cs_stop_sound(sound.playingSound);
+}
+
+void juSoundFree(JUSound sound) {
+	cs_free_sound(&sound->sound);
+	free(sound);
+}
+
+void juSoundStopAll() {
+	cs_stop_all_sounds(gSoundContext);
+}
+#endif // JU_HEADLESS
+
+/********************** Collisions **********************/
+
+double juPointAngle(double x1, double y1, double x2, double y2) {
+	return atan2(x2 - x1, y2 - y1) - (VK2D_PI / 2);
+}
+
+double juPointDistance(double x1, double y1, double x2, double y2) {
+	return sqrt(juPointDistanceSquared(x1, y1, x2, y2));
+}
+
+double juPointDistanceSquared(double x1, double y1, double x2, double y2) {
+	return ((x2 - x1) * (x2 - x1)) + ((y2 - y1) * (y2 - y1));
+}
+
+JUPoint2D juRotatePoint(double x, double y, double originX, double originY, double rotation) {
+	// Applies a 2D rotation matrix
+	JUPoint2D point = {x - originX, y - originY};
+	JUPoint2D final;
+	final.x = (point.x * cos(-rotation)) - (point.y * sin(-rotation));
+	final.y = (point.x * sin(-rotation)) + (point.y * cos(-rotation));
+	final.x += originX;
+	final.y += originY;
+	return final;
+}
+
+bool juRectangleCollision(JURectangle *r1, JURectangle *r2) {
+	return (r1->y + r1->h > r2->y && r1->y < r2->y + r2->h && r1->x + r1->w > r2->x && r1->x < r2->x + r2->w);
+}
+
+bool juRotatedRectangleCollision(JURectangle *r1, double rot1, double originX1, double originY1, JURectangle *r2, double rot2, double originX2, double originY2) {
+	JUOrientedRectangle o1, o2;
+	juOrientedRectangleCreate(&o1, r1, rot1, originX1, originY1);
+	juOrientedRectangleCreate(&o2, r2, rot2, originX2, originY2);
+	return juOrientedRectangleCollision(&o1, &o2);
+}
+
+bool juCircleCollision(JUCircle *c1, JUCircle *c2) {
+	return juPointDistanceSquared(c1->x, c1->y, c2->x, c2->y) < (c1->r + c2->r) * (c1->r + c2->r);
+}
+
+bool juPointInRectangle(JURectangle *rect, double x, double y) {
+	return (x >= rect->x && x <= rect->x + rect->w && y >= rect->y && y <= rect->y + rect->h);
+}
+
+bool juPointInRotatedRectangle(JURectangle *rect, double rot, double originX, double originY, double x, double y) {
+	// Here we work in reverse so instead of rotating the rectangle we rotate the point we are checking in reverse about the origin
+	double c = cos(rot);
+	double s = sin(rot);
+	double pivotX = originX + rect->x;
+	double pivotY = originY + rect->y;
+	double newX = pivotX + ((x - pivotX) * c) + ((y - pivotY) * s);
+	double newY = pivotY - ((x - pivotX) * s) + ((y - pivotY) * c);
+	return juPointInRectangle(rect, newX, newY);
+}
+
+bool juPointInCircle(JUCircle *circle, double x, double y) {
+	return juPointDistanceSquared(circle->x, circle->y, x, y) <= circle->r * circle->r;
+}
+
+float juPointAnglef(JUVec2f p1, JUVec2f p2) {
+	return atan2f(p2.x - p1.x, p2.y - p1.y) - (float)(VK2D_PI / 2);
+}
+
+float juPointDistancef(JUVec2f p1, JUVec2f p2) {
+	return sqrtf(juPointDistanceSquaredf(p1, p2));
+}
+
+float juPointDistanceSquaredf(JUVec2f p1, JUVec2f p2) {
+	float dx = p2.x - p1.x;
+	float dy = p2.y - p1.y;
+	return (dx * dx) + (dy * dy);
+}
+
+JUVec2f juRotatePointf(JUVec2f point, JUVec2f origin, float rotation) {
+	float c = cosf(-rotation);
+	float s = sinf(-rotation);
+	JUVec2f final = {origin.x + ((point.x - origin.x) * c) - ((point.y - origin.y) * s), origin.y + ((point.x - origin.x) * s) + ((point.y - origin.y) * c)};
+	return final;
+}
+
+bool juRectangleCollisionf(const JURectanglef *r1, const JURectanglef *r2) {
+	return (r1->y + r1->h > r2->y && r1->y < r2->y + r2->h && r1->x + r1->w > r2->x && r1->x < r2->x + r2->w);
+}
+
+// Works out the center and axes of a rotated single precision rectangle the same way juOrientedRectangleCreate does
+static void juRectanglefOrient(const JURectanglef *rect, float rot, JUVec2f origin, JUVec2f *center, JUVec2f axes[2]) {
+	float c = cosf(rot);
+	float s = sinf(rot);
+	float localX = (rect->w / 2) - origin.x;
+	float localY = (rect->h / 2) - origin.y;
+	center->x = rect->x + origin.x + (localX * c) - (localY * s);
+	center->y = rect->y + origin.y + (localX * s) + (localY * c);
+	axes[0].x = c;
+	axes[0].y = s;
+	axes[1].x = -s;
+	axes[1].y = c;
+}
+
+// Single precision juOrientedRectangleSeparated
+static bool juRectanglefSeparated(JUVec2f delta, const JUVec2f *axes1, const JURectanglef *r1, const JUVec2f *axes2, const JURectanglef *r2, JUVec2f axis) {
+	float distance = fabsf((delta.x * axis.x) + (delta.y * axis.y));
+	float extent1 = ((r1->w / 2) * fabsf((axes1[0].x * axis.x) + (axes1[0].y * axis.y))) + ((r1->h / 2) * fabsf((axes1[1].x * axis.x) + (axes1[1].y * axis.y)));
+	float extent2 = ((r2->w / 2) * fabsf((axes2[0].x * axis.x) + (axes2[0].y * axis.y))) + ((r2->h / 2) * fabsf((axes2[1].x * axis.x) + (axes2[1].y * axis.y)));
+	return distance >= extent1 + extent2;
+}
+
+bool juRotatedRectangleCollisionf(const JURectanglef *r1, float rot1, JUVec2f origin1, const JURectanglef *r2, float rot2, JUVec2f origin2) {
+	JUVec2f center1, center2, axes1[2], axes2[2];
+	juRectanglefOrient(r1, rot1, origin1, &center1, axes1);
+	juRectanglefOrient(r2, rot2, origin2, &center2, axes2);
+	JUVec2f delta = {center2.x - center1.x, center2.y - center1.y};
+	return !juRectanglefSeparated(delta, axes1, r1, axes2, r2, axes1[0]) &&
+		   !juRectanglefSeparated(delta, axes1, r1, axes2, r2, axes1[1]) &&
+		   !juRectanglefSeparated(delta, axes1, r1, axes2, r2, axes2[0]) &&
+		   !juRectanglefSeparated(delta, axes1, r1, axes2, r2, axes2[1]);
+}
+
+bool juCircleCollisionf(const JUCirclef *c1, const JUCirclef *c2) {
+	JUVec2f p1 = {c1->x, c1->y};
+	JUVec2f p2 = {c2->x, c2->y};
+	return juPointDistanceSquaredf(p1, p2) < (c1->r + c2->r) * (c1->r + c2->r);
+}
+
+bool juPointInRectanglef(const JURectanglef *rect, JUVec2f point) {
+	return (point.x >= rect->x && point.x <= rect->x + rect->w && point.y >= rect->y && point.y <= rect->y + rect->h);
+}
+
+bool juPointInRotatedRectanglef(const JURectanglef *rect, float rot, JUVec2f origin, JUVec2f point) {
+	float c = cosf(rot);
+	float s = sinf(rot);
+	JUVec2f pivot = {rect->x + origin.x, rect->y + origin.y};
+	JUVec2f local = {pivot.x + ((point.x - pivot.x) * c) + ((point.y - pivot.y) * s), pivot.y - ((point.x - pivot.x) * s) + ((point.y - pivot.y) * c)};
+	return juPointInRectanglef(rect, local);
+}
+
+bool juPointInCirclef(const JUCirclef *circle, JUVec2f point) {
+	JUVec2f center = {circle->x, circle->y};
+	return juPointDistanceSquaredf(center, point) <= circle->r * circle->r;
+}
+
+// Clips a ray's [tMin, tMax] to the slab between min and max on one axis, false if nothing is left
+static bool juRaycastSlab(double origin, double delta, double min, double max, double *tMin, double *tMax) {
+	if (delta == 0)
+		return origin >= min && origin <= max;
+	double t1 = (min - origin) / delta;
+	double t2 = (max - origin) / delta;
+	if (t1 > t2) {
+		double t = t1;
+		t1 = t2;
+		t2 = t;
+	}
+	if (t1 > *tMin)
+		*tMin = t1;
+	if (t2 < *tMax)
+		*tMax = t2;
+	return *tMin <= *tMax;
+}
+
+// Slab test between a segment from (x, y) along (dx, dy) and a box, true if it enters the box before maxFraction
+static bool juRaycastBox(double minX, double minY, double maxX, double maxY, double x, double y, double dx, double dy, double maxFraction, double *fraction) {
+	double tMin = 0;
+	double tMax = maxFraction;
+	if (!juRaycastSlab(x, dx, minX, maxX, &tMin, &tMax) || !juRaycastSlab(y, dy, minY, maxY, &tMin, &tMax))
+		return false;
+	*fraction = tMin;
+	return true;
+}
+
+bool juRaycast(JURectangle *rect, double x1, double y1, double x2, double y2, double *fraction) {
+	double t;
+	if (!juRaycastBox(rect->x, rect->y, rect->x + rect->w, rect->y + rect->h, x1, y1, x2 - x1, y2 - y1, 1, &t))
+		return false;
+	if (fraction != NULL)
+		*fraction = t;
+	return true;
+}
+
+double juLerp(double percent, double start, double stop) {
+	return start + ((stop - start) * percent);
+}
+
+double juSerp(double percent, double start, double stop) {
+	return start + ((stop - start) * ((sin((percent * VK2D_PI) - (VK2D_PI / 2)) / 2) + 0.5));
+}
+
+double juCastX(double length, double angle) {
+	return length * cos(-angle);
+}
+
+double juCastY(double length, double angle) {
+	return length * sin(-angle);
+}
+
+double juSign(double x) {
+	return x < 0 ? -1 : (x > 0 ? 1 : 0);
+}
+
+double juSubToZero(double x, double y) {
+	if (x < 0) {
+		return x + y > 0 ? 0 : x + y;
+	} else if (x > 0) {
+		return x - y < 0 ? 0 : x - y;
+	}
+	return x;
+}
+
+double juClamp(double x, double min, double max) {
+	return x < min ? min : (x > max ? max : x);
+}
+
+// Which batch collision kernels this CPU can run
+static JUSIMDLevel juGetSIMDLevel() {
+	if (gSIMDLevel == JU_SIMD_UNKNOWN) {
+#ifdef JU_X86_SIMD
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx"))
+			gSIMDLevel = JU_SIMD_AVX;
+		else if (__builtin_cpu_supports("sse2"))
+			gSIMDLevel = JU_SIMD_SSE2;
+		else
+			gSIMDLevel = JU_SIMD_NONE;
+#else
+		gSIMDLevel = JU_SIMD_NONE;
+#endif // JU_X86_SIMD
+	}
+	return gSIMDLevel;
+}
+
+// Index of the lowest set bit
+static inline int juLowestBit(uint64_t bits) {
+#ifdef __GNUC__
+	return __builtin_ctzll(bits);
+#else
+	int i = 0;
+	while ((bits & 1) == 0) {
+		bits >>= 1;
+		i++;
+	}
+	return i;
+#endif // __GNUC__
+}
+
+// Index of the highest set bit
+static inline int juHighestBit(uint64_t bits) {
+#ifdef __GNUC__
+	return 63 - __builtin_clzll(bits);
+#else
+	int i = 63;
+	while ((bits & ((uint64_t)1 << 63)) == 0) {
+		bits <<= 1;
+		i--;
+	}
+	return i;
+#endif // __GNUC__
+}
+
+// Number of set bits
+static inline int juBitCount(uint64_t bits) {
+#ifdef __GNUC__
+	return __builtin_popcountll(bits);
+#else
+	int count = 0;
+	for (; bits != 0; bits &= bits - 1)
+		count++;
+	return count;
+#endif // __GNUC__
+}
+
+// Checks up to 64 rectangles starting at start, bit i of the result is for rectangle start + i
+static uint64_t juRectangleKernel(const void *shape, const void *batch, int start, int n) {
+	const JURectangle *r = shape;
+	const JURectangleBatch *b = batch;
+	uint64_t mask = 0;
+	for (int i = 0; i < n; i++) {
+		int j = start + i;
+		if (r->y + r->h > b->y[j] && r->y < b->y[j] + b->h[j] && r->x + r->w > b->x[j] && r->x < b->x[j] + b->w[j])
+			mask |= (uint64_t)1 << i;
+	}
+	return mask;
+}
+
+// Checks up to 64 circles starting at start
+static uint64_t juCircleKernel(const void *shape, const void *batch, int start, int n) {
+	const JUCircle *c = shape;
+	const JUCircleBatch *b = batch;
+	uint64_t mask = 0;
+	for (int i = 0; i < n; i++) {
+		int j = start + i;
+		double dx = b->x[j] - c->x;
+		double dy = b->y[j] - c->y;
+		double r = b->r[j] + c->r;
+		if ((dx * dx) + (dy * dy) < r * r)
+			mask |= (uint64_t)1 << i;
+	}
+	return mask;
+}
+
+// Checks up to 64 points starting at start
+static uint64_t juPointKernel(const void *shape, const void *batch, int start, int n) {
+	const JURectangle *r = shape;
+	const JUPointBatch *b = batch;
+	uint64_t mask = 0;
+	for (int i = 0; i < n; i++) {
+		int j = start + i;
+		if (b->x[j] >= r->x && b->x[j] <= r->x + r->w && b->y[j] >= r->y && b->y[j] <= r->y + r->h)
+			mask |= (uint64_t)1 << i;
+	}
+	return mask;
+}
+
+#ifdef JU_X86_SIMD
+// SSE2 version of juRectangleKernel, 2 rectangles at a time
+__attribute__((target("sse2")))
+static uint64_t juRectangleKernelSSE2(const void *shape, const void *batch, int start, int n) {
+	const JURectangle *r = shape;
+	const JURectangleBatch *b = batch;
+	__m128d left = _mm_set1_pd(r->x);
+	__m128d top = _mm_set1_pd(r->y);
+	__m128d right = _mm_set1_pd(r->x + r->w);
+	__m128d bottom = _mm_set1_pd(r->y + r->h);
+	uint64_t mask = 0;
+	int i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m128d x = _mm_loadu_pd(b->x + start + i);
+		__m128d y = _mm_loadu_pd(b->y + start + i);
+		__m128d w = _mm_loadu_pd(b->w + start + i);
+		__m128d h = _mm_loadu_pd(b->h + start + i);
+		__m128d vertical = _mm_and_pd(_mm_cmpgt_pd(bottom, y), _mm_cmplt_pd(top, _mm_add_pd(y, h)));
+		__m128d horizontal = _mm_and_pd(_mm_cmpgt_pd(right, x), _mm_cmplt_pd(left, _mm_add_pd(x, w)));
+		mask |= (uint64_t)_mm_movemask_pd(_mm_and_pd(vertical, horizontal)) << i;
+	}
+	return i < n ? mask | (juRectangleKernel(shape, batch, start + i, n - i) << i) : mask;
+}
+
+// AVX version of juRectangleKernel, 4 rectangles at a time
+__attribute__((target("avx")))
+static uint64_t juRectangleKernelAVX(const void *shape, const void *batch, int start, int n) {
+	const JURectangle *r = shape;
+	const JURectangleBatch *b = batch;
+	__m256d left = _mm256_set1_pd(r->x);
+	__m256d top = _mm256_set1_pd(r->y);
+	__m256d right = _mm256_set1_pd(r->x + r->w);
+	__m256d bottom = _mm256_set1_pd(r->y + r->h);
+	uint64_t mask = 0;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256d x = _mm256_loadu_pd(b->x + start + i);
+		__m256d y = _mm256_loadu_pd(b->y + start + i);
+		__m256d w = _mm256_loadu_pd(b->w + start + i);
+		__m256d h = _mm256_loadu_pd(b->h + start + i);
+		__m256d vertical = _mm256_and_pd(_mm256_cmp_pd(bottom, y, _CMP_GT_OQ), _mm256_cmp_pd(top, _mm256_add_pd(y, h), _CMP_LT_OQ));
+		__m256d horizontal = _mm256_and_pd(_mm256_cmp_pd(right, x, _CMP_GT_OQ), _mm256_cmp_pd(left, _mm256_add_pd(x, w), _CMP_LT_OQ));
+		mask |= (uint64_t)_mm256_movemask_pd(_mm256_and_pd(vertical, horizontal)) << i;
+	}
+	return i < n ? mask | (juRectangleKernel(shape, batch, start + i, n - i) << i) : mask;
+}
+
+// SSE2 version of juCircleKernel
+__attribute__((target("sse2")))
+static uint64_t juCircleKernelSSE2(const void *shape, const void *batch, int start, int n) {
+	const JUCircle *c = shape;
+	const JUCircleBatch *b = batch;
+	__m128d cx = _mm_set1_pd(c->x);
+	__m128d cy = _mm_set1_pd(c->y);
+	__m128d cr = _mm_set1_pd(c->r);
+	uint64_t mask = 0;
+	int i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m128d dx = _mm_sub_pd(_mm_loadu_pd(b->x + start + i), cx);
+		__m128d dy = _mm_sub_pd(_mm_loadu_pd(b->y + start + i), cy);
+		__m128d r = _mm_add_pd(_mm_loadu_pd(b->r + start + i), cr);
+		__m128d distance = _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy));
+		mask |= (uint64_t)_mm_movemask_pd(_mm_cmplt_pd(distance, _mm_mul_pd(r, r))) << i;
+	}
+	return i < n ? mask | (juCircleKernel(shape, batch, start + i, n - i) << i) : mask;
+}
+
+// AVX version of juCircleKernel
+__attribute__((target("avx")))
+static uint64_t juCircleKernelAVX(const void *shape, const void *batch, int start, int n) {
+	const JUCircle *c = shape;
+	const JUCircleBatch *b = batch;
+	__m256d cx = _mm256_set1_pd(c->x);
+	__m256d cy = _mm256_set1_pd(c->y);
+	__m256d cr = _mm256_set1_pd(c->r);
+	uint64_t mask = 0;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256d dx = _mm256_sub_pd(_mm256_loadu_pd(b->x + start + i), cx);
+		__m256d dy = _mm256_sub_pd(_mm256_loadu_pd(b->y + start + i), cy);
+		__m256d r = _mm256_add_pd(_mm256_loadu_pd(b->r + start + i), cr);
+		__m256d distance = _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy));
+		mask |= (uint64_t)_mm256_movemask_pd(_mm256_cmp_pd(distance, _mm256_mul_pd(r, r), _CMP_LT_OQ)) << i;
+	}
+	return i < n ? mask | (juCircleKernel(shape, batch, start + i, n - i) << i) : mask;
+}
+
+// SSE2 version of juPointKernel
+__attribute__((target("sse2")))
+static uint64_t juPointKernelSSE2(const void *shape, const void *batch, int start, int n) {
+	const JURectangle *r = shape;
+	const JUPointBatch *b = batch;
+	__m128d left = _mm_set1_pd(r->x);
+	__m128d top = _mm_set1_pd(r->y);
+	__m128d right = _mm_set1_pd(r->x + r->w);
+	__m128d bottom = _mm_set1_pd(r->y + r->h);
+	uint64_t mask = 0;
+	int i = 0;
+	for (; i + 2 <= n; i += 2) {
+		__m128d x = _mm_loadu_pd(b->x + start + i);
+		__m128d y = _mm_loadu_pd(b->y + start + i);
+		__m128d horizontal = _mm_and_pd(_mm_cmpge_pd(x, left), _mm_cmple_pd(x, right));
+		__m128d vertical = _mm_and_pd(_mm_cmpge_pd(y, top), _mm_cmple_pd(y, bottom));
+		mask |= (uint64_t)_mm_movemask_pd(_mm_and_pd(horizontal, vertical)) << i;
+	}
+	return i < n ? mask | (juPointKernel(shape, batch, start + i, n - i) << i) : mask;
+}
+
+// AVX version of juPointKernel
+__attribute__((target("avx")))
+static uint64_t juPointKernelAVX(const void *shape, const void *batch, int start, int n) {
+	const JURectangle *r = shape;
+	const JUPointBatch *b = batch;
+	__m256d left = _mm256_set1_pd(r->x);
+	__m256d top = _mm256_set1_pd(r->y);
+	__m256d right = _mm256_set1_pd(r->x + r->w);
+	__m256d bottom = _mm256_set1_pd(r->y + r->h);
+	uint64_t mask = 0;
+	int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m256d x = _mm256_loadu_pd(b->x + start + i);
+		__m256d y = _mm256_loadu_pd(b->y + start + i);
+		__m256d horizontal = _mm256_and_pd(_mm256_cmp_pd(x, left, _CMP_GE_OQ), _mm256_cmp_pd(x, right, _CMP_LE_OQ));
+		__m256d vertical = _mm256_and_pd(_mm256_cmp_pd(y, top, _CMP_GE_OQ), _mm256_cmp_pd(y, bottom, _CMP_LE_OQ));
+		mask |= (uint64_t)_mm256_movemask_pd(_mm256_and_pd(horizontal, vertical)) << i;
+	}
+	return i < n ? mask | (juPointKernel(shape, batch, start + i, n - i) << i) : mask;
+}
+#endif // JU_X86_SIMD
+
+// Picks the fastest version of a kernel this CPU can run
+static JUBatchKernel juPickKernel(JUBatchKernel scalar, JUBatchKernel sse2, JUBatchKernel avx) {
+	JUSIMDLevel level = juGetSIMDLevel();
+	if (level == JU_SIMD_AVX)
+		return avx;
+	if (level == JU_SIMD_SSE2)
+		return sse2;
+	return scalar;
+}
+
+// Runs a kernel over a whole batch 64 shapes at a time, filling in the mask/indices and returning the number of hits
+static int juBatchCollect(JUBatchKernel kernel, const void *shape, const void *batch, int count, uint64_t *mask, int32_t *indices) {
+	int hits = 0;
+	for (int start = 0; start < count; start += 64) {
+		uint64_t bits = kernel(shape, batch, start, count - start < 64 ? count - start : 64);
+		if (mask != NULL)
+			mask[start / 64] = bits;
+		if (indices != NULL) {
+			for (; bits != 0; bits &= bits - 1)
+				indices[hits++] = start + juLowestBit(bits);
+		} else {
+			hits += juBitCount(bits);
+		}
+	}
+	return hits;
+}
+
+#ifdef JU_X86_SIMD
+#define JU_KERNEL(name) juPickKernel(name, name##SSE2, name##AVX)
+#else
+#define JU_KERNEL(name) (name)
+#endif // JU_X86_SIMD
+
+int juRectangleCollisionBatch(const JURectangle *rect, const JURectangleBatch *batch, uint64_t *mask, int32_t *indices) {
+	return juBatchCollect(JU_KERNEL(juRectangleKernel), rect, batch, batch->count, mask, indices);
+}
+
+int juRectangleCollisionBatchAll(const JURectangleBatch *a, const JURectangleBatch *b, int32_t *pairs, int size) {
+	JUBatchKernel kernel = JU_KERNEL(juRectangleKernel);
+	int count = 0;
+	for (int i = 0; i < a->count; i++) {
+		JURectangle rect = {a->x[i], a->y[i], a->w[i], a->h[i]};
+		for (int start = 0; start < b->count; start += 64) {
+			uint64_t bits = kernel(&rect, b, start, b->count - start < 64 ? b->count - start : 64);
+			for (; bits != 0; bits &= bits - 1) {
+				if (count < size) {
+					pairs[count * 2] = i;
+					pairs[(count * 2) + 1] = start + juLowestBit(bits);
+				}
+				count++;
+			}
+		}
+	}
+	return count;
+}
+
+int juCircleCollisionBatch(const JUCircle *circle, const JUCircleBatch *batch, uint64_t *mask, int32_t *indices) {
+	return juBatchCollect(JU_KERNEL(juCircleKernel), circle, batch, batch->count, mask, indices);
+}
+
+int juPointInRectangleBatch(const JURectangle *rect, const JUPointBatch *batch, uint64_t *mask, int32_t *indices) {
+	return juBatchCollect(JU_KERNEL(juPointKernel), rect, batch, batch->count, mask, indices);
+}
+
+// Rotates x/y arrays by a rotation matrix that has already been worked out
+static void juRotateKernel(const double *x, const double *y, int start, int count, double originX, double originY, double c, double s, double *outX, double *outY) {
+	for (int i = start; i < count; i++) {
+		double px = x[i] - originX;
+		double py = y[i] - originY;
+		outX[i] = originX + (px * c) - (py * s);
+		outY[i] = originY + (px * s) + (py * c);
+	}
+}
+
+// Splits an angle into how many quarter turns it is (the bottom 2 bits of which are returned) and what's left over in [-pi/4, pi/4]
+static inline double juTrigReduce(double angle, int *quadrant) {
+	double shifted = (angle * (2 / VK2D_PI)) + JU_TRIG_ROUND;
+	uint64_t bits;
+	memcpy(&bits, &shifted, sizeof(bits));
+	*quadrant = (int)(bits & 3);
+	double k = shifted - JU_TRIG_ROUND;
+
+	// pi/2 is split in two so k * pi/2 doesn't lose precision for big angles
+	return (angle - (k * 1.57079632673412561417e+00)) - (k * 6.07710050650619224932e-11);
+}
+
+// sin on [-pi/4, pi/4]
+static inline double juSinPolynomial(double r) {
+	double r2 = r * r;
+	return r + (r * r2 * (-1.66666666666666324348e-01 + (r2 * (8.33333333332248946124e-03 + (r2 * (-1.98412698298579493134e-04 + (r2 * 2.75573137070700676789e-06)))))));
+}
+
+// cos on [-pi/4, pi/4]
+static inline double juCosPolynomial(double r) {
+	double r2 = r * r;
+	return 1 + (r2 * (-0.5 + (r2 * (4.16666666666666019037e-02 + (r2 * (-1.38888888888741095749e-03 + (r2 * (2.48015872894767294178e-05 + (r2 * -2.75573143513906633035e-07)))))))));
+}
+
+// atan on [0, 1], Abramowitz and Stegun 4.4.49
+static inline double juAtanPolynomial(double z) {
+	double z2 = z * z;
+	return z * (0.9999993329 + (z2 * (-0.3332985605 + (z2 * (0.1994653599 + (z2 * (-0.1390853351 + (z2 * (0.0964200441 + (z2 * (-0.0559098861 + (z2 * (0.0218612288 + (z2 * -0.0040540580))))))))))))));
+}
+
+// juFastSinCos over part of a list of angles
+static void juSinCosKernel(const double *angles, int start, int count, double *sines, double *cosines) {
+	for (int i = start; i < count; i++)
+		juFastSinCos(angles[i], &sines[i], &cosines[i]);
+}
+
+#ifdef JU_X86_SIMD
+// SSE2 version of juRotateKernel
+__attribute__((target("sse2")))
+static void juRotateKernelSSE2(const double *x, const double *y, int count, double originX, double originY, double c, double s, double *outX, double *outY) {
+	__m128d ox = _mm_set1_pd(originX);
+	__m128d oy = _mm_set1_pd(originY);
+	__m128d vc = _mm_set1_pd(c);
+	__m128d vs = _mm_set1_pd(s);
+	int i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m128d px = _mm_sub_pd(_mm_loadu_pd(x + i), ox);
+		__m128d py = _mm_sub_pd(_mm_loadu_pd(y + i), oy);
+		_mm_storeu_pd(outX + i, _mm_add_pd(ox, _mm_sub_pd(_mm_mul_pd(px, vc), _mm_mul_pd(py, vs))));
+		_mm_storeu_pd(outY + i, _mm_add_pd(oy, _mm_add_pd(_mm_mul_pd(px, vs), _mm_mul_pd(py, vc))));
+	}
+	juRotateKernel(x, y, i, count, originX, originY, c, s, outX, outY);
+}
+
+// AVX version of juRotateKernel
+__attribute__((target("avx")))
+static void juRotateKernelAVX(const double *x, const double *y, int count, double originX, double originY, double c, double s, double *outX, double *outY) {
+	__m256d ox = _mm256_set1_pd(originX);
+	__m256d oy = _mm256_set1_pd(originY);
+	__m256d vc = _mm256_set1_pd(c);
+	__m256d vs = _mm256_set1_pd(s);
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m256d px = _mm256_sub_pd(_mm256_loadu_pd(x + i), ox);
+		__m256d py = _mm256_sub_pd(_mm256_loadu_pd(y + i), oy);
+		_mm256_storeu_pd(outX + i, _mm256_add_pd(ox, _mm256_sub_pd(_mm256_mul_pd(px, vc), _mm256_mul_pd(py, vs))));
+		_mm256_storeu_pd(outY + i, _mm256_add_pd(oy, _mm256_add_pd(_mm256_mul_pd(px, vs), _mm256_mul_pd(py, vc))));
+	}
+	juRotateKernel(x, y, i, count, originX, originY, c, s, outX, outY);
+}
+
+// SSE2 version of juSinCosKernel, the quadrant's bits are shifted up into sign bits to pick and flip results
+__attribute__((target("sse2")))
+static void juSinCosKernelSSE2(const double *angles, int count, double *sines, double *cosines) {
+	const __m128d round = _mm_set1_pd(JU_TRIG_ROUND);
+	const __m128d sign = _mm_set1_pd(-0.0);
+	int i = 0;
+	for (; i + 2 <= count; i += 2) {
+		__m128d angle = _mm_loadu_pd(angles + i);
+		__m128d shifted = _mm_add_pd(_mm_mul_pd(angle, _mm_set1_pd(2 / VK2D_PI)), round);
+		__m128i quadrant = _mm_castpd_si128(shifted);
+		__m128d k = _mm_sub_pd(shifted, round);
+		__m128d r = _mm_sub_pd(_mm_sub_pd(angle, _mm_mul_pd(k, _mm_set1_pd(1.57079632673412561417e+00))), _mm_mul_pd(k, _mm_set1_pd(6.07710050650619224932e-11)));
+		__m128d r2 = _mm_mul_pd(r, r);
+		__m128d s = _mm_add_pd(_mm_set1_pd(-1.98412698298579493134e-04), _mm_mul_pd(r2, _mm_set1_pd(2.75573137070700676789e-06)));
+		s = _mm_add_pd(_mm_set1_pd(8.33333333332248946124e-03), _mm_mul_pd(r2, s));
+		s = _mm_add_pd(_mm_set1_pd(-1.66666666666666324348e-01), _mm_mul_pd(r2, s));
+		s = _mm_add_pd(r, _mm_mul_pd(_mm_mul_pd(r, r2), s));
+		__m128d c = _mm_add_pd(_mm_set1_pd(2.48015872894767294178e-05), _mm_mul_pd(r2, _mm_set1_pd(-2.75573143513906633035e-07)));
+		c = _mm_add_pd(_mm_set1_pd(-1.38888888888741095749e-03), _mm_mul_pd(r2, c));
+		c = _mm_add_pd(_mm_set1_pd(4.16666666666666019037e-02), _mm_mul_pd(r2, c));
+		c = _mm_add_pd(_mm_set1_pd(-0.5), _mm_mul_pd(r2, c));
+		c = _mm_add_pd(_mm_set1_pd(1), _mm_mul_pd(r2, c));
+
+		// Odd quadrants swap sin and cos, sin is negative in quadrants 2 and 3 and cos in 1 and 2
+		__m128i swap = _mm_shuffle_epi32(_mm_srai_epi32(_mm_slli_epi64(quadrant, 63), 31), _MM_SHUFFLE(3, 3, 1, 1));
+		__m128d sinSign = _mm_and_pd(_mm_castsi128_pd(_mm_slli_epi64(quadrant, 62)), sign);
+		__m128d cosSign = _mm_and_pd(_mm_castsi128_pd(_mm_slli_epi64(_mm_add_epi64(quadrant, _mm_set1_epi64x(1)), 62)), sign);
+		__m128d swapMask = _mm_castsi128_pd(swap);
+		__m128d sine = _mm_or_pd(_mm_and_pd(swapMask, c), _mm_andnot_pd(swapMask, s));
+		__m128d cosine = _mm_or_pd(_mm_and_pd(swapMask, s), _mm_andnot_pd(swapMask, c));
+		_mm_storeu_pd(sines + i, _mm_xor_pd(sine, sinSign));
+		_mm_storeu_pd(cosines + i, _mm_xor_pd(cosine, cosSign));
+	}
+	juSinCosKernel(angles, i, count, sines, cosines);
+}
+
+// AVX version of juSinCosKernel, AVX has no 256 bit integer instructions so the quadrant is worked out in doubles
+__attribute__((target("avx")))
+static void juSinCosKernelAVX(const double *angles, int count, double *sines, double *cosines) {
+	const __m256d round = _mm256_set1_pd(JU_TRIG_ROUND);
+	const __m256d sign = _mm256_set1_pd(-0.0);
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		__m256d angle = _mm256_loadu_pd(angles + i);
+		__m256d k = _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(angle, _mm256_set1_pd(2 / VK2D_PI)), round), round);
+		__m256d quadrant = _mm256_sub_pd(k, _mm256_mul_pd(_mm256_set1_pd(4), _mm256_floor_pd(_mm256_mul_pd(k, _mm256_set1_pd(0.25)))));
+		__m256d r = _mm256_sub_pd(_mm256_sub_pd(angle, _mm256_mul_pd(k, _mm256_set1_pd(1.57079632673412561417e+00))), _mm256_mul_pd(k, _mm256_set1_pd(6.07710050650619224932e-11)));
+		__m256d r2 = _mm256_mul_pd(r, r);
+		__m256d s = _mm256_add_pd(_mm256_set1_pd(-1.98412698298579493134e-04), _mm256_mul_pd(r2, _mm256_set1_pd(2.75573137070700676789e-06)));
+		s = _mm256_add_pd(_mm256_set1_pd(8.33333333332248946124e-03), _mm256_mul_pd(r2, s));
+		s = _mm256_add_pd(_mm256_set1_pd(-1.66666666666666324348e-01), _mm256_mul_pd(r2, s));
+		s = _mm256_add_pd(r, _mm256_mul_pd(_mm256_mul_pd(r, r2), s));
+		__m256d c = _mm256_add_pd(_mm256_set1_pd(2.48015872894767294178e-05), _mm256_mul_pd(r2, _mm256_set1_pd(-2.75573143513906633035e-07)));
+		c = _mm256_add_pd(_mm256_set1_pd(-1.38888888888741095749e-03), _mm256_mul_pd(r2, c));
+		c = _mm256_add_pd(_mm256_set1_pd(4.16666666666666019037e-02), _mm256_mul_pd(r2, c));
+		c = _mm256_add_pd(_mm256_set1_pd(-0.5), _mm256_mul_pd(r2, c));
+		c = _mm256_add_pd(_mm256_set1_pd(1), _mm256_mul_pd(r2, c));
+
+		__m256d one = _mm256_cmp_pd(quadrant, _mm256_set1_pd(1), _CMP_EQ_OQ);
+		__m256d two = _mm256_cmp_pd(quadrant, _mm256_set1_pd(2), _CMP_EQ_OQ);
+		__m256d three = _mm256_cmp_pd(quadrant, _mm256_set1_pd(3), _CMP_EQ_OQ);
+		__m256d swapMask = _mm256_or_pd(one, three);
+		__m256d sinSign = _mm256_and_pd(_mm256_or_pd(two, three), sign);
+		__m256d cosSign = _mm256_and_pd(_mm256_or_pd(one, two), sign);
+		__m256d sine = _mm256_blendv_pd(s, c, swapMask);
+		__m256d cosine = _mm256_blendv_pd(c, s, swapMask);
+		_mm256_storeu_pd(sines + i, _mm256_xor_pd(sine, sinSign));
+		_mm256_storeu_pd(cosines + i, _mm256_xor_pd(cosine, cosSign));
+	}
+	juSinCosKernel(angles, i, count, sines, cosines);
+}
+#endif // JU_X86_SIMD
+
+void juRotatePointBatch(const JUPointBatch *points, double originX, double originY, double rotation, double *outX, double *outY) {
+	// Same rotation juRotatePoint does
+	double c = cos(-rotation);
+	double s = sin(-rotation);
+#ifdef JU_X86_SIMD
+	JUSIMDLevel level = juGetSIMDLevel();
+	if (level == JU_SIMD_AVX) {
+		juRotateKernelAVX(points->x, points->y, points->count, originX, originY, c, s, outX, outY);
+		return;
+	} else if (level == JU_SIMD_SSE2) {
+		juRotateKernelSSE2(points->x, points->y, points->count, originX, originY, c, s, outX, outY);
+		return;
+	}
+#endif // JU_X86_SIMD
+	juRotateKernel(points->x, points->y, 0, points->count, originX, originY, c, s, outX, outY);
+}
+
+void juCastBatch(const double *lengths, int count, double angle, double *outX, double *outY) {
+	double c = cos(-angle);
+	double s = sin(-angle);
+	for (int i = 0; i < count; i++) {
+		outX[i] = lengths[i] * c;
+		outY[i] = lengths[i] * s;
+	}
+}
+
+double juFastSin(double angle) {
+	int quadrant;
+	double r = juTrigReduce(angle, &quadrant);
+	double result = quadrant & 1 ? juCosPolynomial(r) : juSinPolynomial(r);
+	return quadrant & 2 ? -result : result;
+}
+
+double juFastCos(double angle) {
+	int quadrant;
+	double r = juTrigReduce(angle, &quadrant);
+	double result = quadrant & 1 ? juSinPolynomial(r) : juCosPolynomial(r);
+	return (quadrant + 1) & 2 ? -result : result;
+}
+
+void juFastSinCos(double angle, double *sine, double *cosine) {
+	int quadrant;
+	double r = juTrigReduce(angle, &quadrant);
+	double s = juSinPolynomial(r);
+	double c = juCosPolynomial(r);
+	*sine = quadrant & 1 ? c : s;
+	*cosine = quadrant & 1 ? s : c;
+	if (quadrant & 2)
+		*sine = -*sine;
+	if ((quadrant + 1) & 2)
+		*cosine = -*cosine;
+}
+
+double juFastAtan2(double y, double x) {
+	// Fold everything into the first octant, then unfold the result
+	double ax = fabs(x);
+	double ay = fabs(y);
+	double big = ax > ay ? ax : ay;
+	if (big == 0)
+		return 0;
+	double result = juAtanPolynomial((ax < ay ? ax : ay) / big);
+	if (ay > ax)
+		result = (VK2D_PI / 2) - result;
+	if (x < 0)
+		result = VK2D_PI - result;
+	return signbit(y) ? -result : result;
+}
+
+void juFastSinCosBatch(const double *angles, int count, double *sines, double *cosines) {
+#ifdef JU_X86_SIMD
+	JUSIMDLevel level = juGetSIMDLevel();
+	if (level == JU_SIMD_AVX) {
+		juSinCosKernelAVX(angles, count, sines, cosines);
+		return;
+	} else if (level == JU_SIMD_SSE2) {
+		juSinCosKernelSSE2(angles, count, sines, cosines);
+		return;
+	}
+#endif // JU_X86_SIMD
+	juSinCosKernel(angles, 0, count, sines, cosines);
+}
+
+void juOrientedRectangleCreate(JUOrientedRectangle *obb, const JURectangle *rect, double rot, double originX, double originY) {
+	// Same rotation juPointInRotatedRectangle undoes, the only trig the oriented functions ever do
+	double c = cos(rot);
+	double s = sin(rot);
+	double pivotX = rect->x + originX;
+	double pivotY = rect->y + originY;
+	const double localX[4] = {-originX, rect->w - originX, rect->w - originX, -originX};
+	const double localY[4] = {-originY, -originY, rect->h - originY, rect->h - originY};
+	double minX = INFINITY, minY = INFINITY, maxX = -INFINITY, maxY = -INFINITY;
+	for (int i = 0; i < 4; i++) {
+		obb->corners[i].x = pivotX + (localX[i] * c) - (localY[i] * s);
+		obb->corners[i].y = pivotY + (localX[i] * s) + (localY[i] * c);
+		minX = obb->corners[i].x < minX ? obb->corners[i].x : minX;
+		minY = obb->corners[i].y < minY ? obb->corners[i].y : minY;
+		maxX = obb->corners[i].x > maxX ? obb->corners[i].x : maxX;
+		maxY = obb->corners[i].y > maxY ? obb->corners[i].y : maxY;
+	}
+	obb->axes[0].x = c;
+	obb->axes[0].y = s;
+	obb->axes[1].x = -s;
+	obb->axes[1].y = c;
+	obb->center.x = (obb->corners[0].x + obb->corners[2].x) / 2;
+	obb->center.y = (obb->corners[0].y + obb->corners[2].y) / 2;
+	obb->halfWidth = rect->w / 2;
+	obb->halfHeight = rect->h / 2;
+	obb->bounds.x = minX;
+	obb->bounds.y = minY;
+	obb->bounds.w = maxX - minX;
+	obb->bounds.h = maxY - minY;
+}
+
+// Checks if an axis separates two oriented rectangles by comparing the distance between their centers to their projected half sizes
+static bool juOrientedRectangleSeparated(const JUOrientedRectangle *o1, const JUOrientedRectangle *o2, JUPoint2D axis) {
+	double distance = fabs(((o2->center.x - o1->center.x) * axis.x) + ((o2->center.y - o1->center.y) * axis.y));
+	double r1 = (o1->halfWidth * fabs((o1->axes[0].x * axis.x) + (o1->axes[0].y * axis.y))) + (o1->halfHeight * fabs((o1->axes[1].x * axis.x) + (o1->axes[1].y * axis.y)));
+	double r2 = (o2->halfWidth * fabs((o2->axes[0].x * axis.x) + (o2->axes[0].y * axis.y))) + (o2->halfHeight * fabs((o2->axes[1].x * axis.x) + (o2->axes[1].y * axis.y)));
+	return distance >= r1 + r2;
+}
+
+bool juOrientedRectangleCollision(const JUOrientedRectangle *o1, const JUOrientedRectangle *o2) {
+	// Rectangles only have 2 unique edge normals each, so 4 axes cover every possible separating axis
+	return !juOrientedRectangleSeparated(o1, o2, o1->axes[0]) &&
+		   !juOrientedRectangleSeparated(o1, o2, o1->axes[1]) &&
+		   !juOrientedRectangleSeparated(o1, o2, o2->axes[0]) &&
+		   !juOrientedRectangleSeparated(o1, o2, o2->axes[1]);
+}
+
+// Checks up to 64 oriented rectangles against one, rejecting on bounds before running the separating axis test
+static uint64_t juOrientedRectangleKernel(const void *shape, const void *batch, int start, int n) {
+	const JUOrientedRectangle *o = shape;
+	const JUOrientedRectangle *others = batch;
+	uint64_t mask = 0;
+	for (int i = 0; i < n; i++) {
+		const JUOrientedRectangle *other = &others[start + i];
+		if (juRectangleCollision((JURectangle*)&o->bounds, (JURectangle*)&other->bounds) && juOrientedRectangleCollision(o, other))
+			mask |= (uint64_t)1 << i;
+	}
+	return mask;
+}
+
+int juOrientedRectangleCollisionBatch(const JUOrientedRectangle *obb, const JUOrientedRectangle *others, int count, uint64_t *mask, int32_t *indices) {
+	return juBatchCollect(juOrientedRectangleKernel, obb, others, count, mask, indices);
+}
+
+// Gets the times a point moving along one axis is strictly inside [min, max], empty if it never is
+static inline void juSweptSlab(double origin, double delta, double min, double max, double *enter, double *exit) {
+	if (delta == 0) {
+		bool inside = origin > min && origin < max;
+		*enter = inside ? -INFINITY : INFINITY;
+		*exit = inside ? INFINITY : -INFINITY;
+	} else if (delta > 0) {
+		*enter = (min - origin) / delta;
+		*exit = (max - origin) / delta;
+	} else {
+		*enter = (max - origin) / delta;
+		*exit = (min - origin) / delta;
+	}
+}
+
+// Sweeps a point against a box, which is what every rectangle sweep turns into once the mover's size is added to the box
+static bool juSweptPointBox(double x, double y, double dx, double dy, double minX, double minY, double maxX, double maxY, JUSweptHit *hit) {
+	double enterX, exitX, enterY, exitY;
+	juSweptSlab(x, dx, minX, maxX, &enterX, &exitX);
+	juSweptSlab(y, dy, minY, maxY, &enterY, &exitY);
+	double enter = enterX > enterY ? enterX : enterY;
+	double exit = exitX < exitY ? exitX : exitY;
+	if (enter >= exit || enter >= 1 || exit <= 0)
+		return false;
+	hit->time = enter > 0 ? enter : 0;
+	hit->normalX = 0;
+	hit->normalY = 0;
+	if (enter >= 0) {
+		if (enterX > enterY)
+			hit->normalX = dx > 0 ? -1 : 1;
+		else
+			hit->normalY = dy > 0 ? -1 : 1;
+	}
+	return true;
+}
+
+// Sweeps a point against a circle with the quadratic for when it is r away from the center
+static bool juSweptPointCircle(double x, double y, double dx, double dy, double cx, double cy, double r, JUSweptHit *hit) {
+	double mx = x - cx;
+	double my = y - cy;
+	double c = (mx * mx) + (my * my) - (r * r);
+	if (c < 0) {
+		hit->time = 0;
+		hit->normalX = 0;
+		hit->normalY = 0;
+		return true;
+	}
+	double a = (dx * dx) + (dy * dy);
+	double b = (mx * dx) + (my * dy);
+	double discriminant = (b * b) - (a * c);
+	if (a == 0 || b >= 0 || discriminant <= 0)
+		return false;
+	double t = (-b - sqrt(discriminant)) / a;
+	if (t >= 1)
+		return false;
+	hit->time = t;
+	hit->normalX = (mx + (dx * t)) / r;
+	hit->normalY = (my + (dy * t)) / r;
+	return true;
+}
+
+JURectangle juSweptBounds(const JURectangle *rect, double dx, double dy) {
+	JURectangle bounds = {dx < 0 ? rect->x + dx : rect->x, dy < 0 ? rect->y + dy : rect->y, rect->w + fabs(dx), rect->h + fabs(dy)};
+	return bounds;
+}
+
+bool juSweptRectangleCollision(const JURectangle *rect, double dx, double dy, const JURectangle *target, JUSweptHit *hit) {
+	// The top left of the moving rectangle against the target grown by the moving rectangle's size
+	JUSweptHit local;
+	return juSweptPointBox(rect->x, rect->y, dx, dy, target->x - rect->w, target->y - rect->h, target->x + target->w, target->y + target->h, hit != NULL ? hit : &local);
+}
+
+bool juSweptCircleRectangleCollision(const JUCircle *circle, double dx, double dy, const JURectangle *target, JUSweptHit *hit) {
+	JUSweptHit local;
+	hit = hit != NULL ? hit : &local;
+	double closestX = juClamp(circle->x, target->x, target->x + target->w);
+	double closestY = juClamp(circle->y, target->y, target->y + target->h);
+	if (juPointDistanceSquared(circle->x, circle->y, closestX, closestY) < circle->r * circle->r) {
+		hit->time = 0;
+		hit->normalX = 0;
+		hit->normalY = 0;
+		return true;
+	}
+
+	// The center against the rectangle grown by the radius, which is two boxes and a circle on each corner
+	double r = circle->r;
+	double right = target->x + target->w;
+	double bottom = target->y + target->h;
+	const double cornerX[4] = {target->x, right, right, target->x};
+	const double cornerY[4] = {target->y, target->y, bottom, bottom};
+	JUSweptHit candidate;
+	bool found = false;
+	if (juSweptPointBox(circle->x, circle->y, dx, dy, target->x - r, target->y, right + r, bottom, &candidate)) {
+		*hit = candidate;
+		found = true;
+	}
+	if (juSweptPointBox(circle->x, circle->y, dx, dy, target->x, target->y - r, right, bottom + r, &candidate) && (!found || candidate.time < hit->time)) {
+		*hit = candidate;
+		found = true;
+	}
+	for (int i = 0; i < 4; i++) {
+		if (juSweptPointCircle(circle->x, circle->y, dx, dy, cornerX[i], cornerY[i], r, &candidate) && (!found || candidate.time < hit->time)) {
+			*hit = candidate;
+			found = true;
+		}
+	}
+	return found;
+}
+
+bool juSweptCircleCollision(const JUCircle *circle, double dx, double dy, const JUCircle *target, JUSweptHit *hit) {
+	JUSweptHit local;
+	return juSweptPointCircle(circle->x, circle->y, dx, dy, target->x, target->y, circle->r + target->r, hit != NULL ? hit : &local);
+}
+
+// Number of candidates a batch mover has and where they start, for when the candidate list is NULL and it's every target
+static inline int juSweptCandidates(const int32_t *candidates, const int32_t *candidateStarts, int mover, int targetCount, int *start) {
+	if (candidates == NULL) {
+		*start = 0;
+		return targetCount;
+	}
+	*start = candidateStarts[mover];
+	return candidateStarts[mover + 1] - candidateStarts[mover];
+}
+
+int juSweptRectangleBatch(const JURectangleBatch *movers, const JUPointBatch *movement, const JURectangleBatch *targets, const int32_t *candidates, const int32_t *candidateStarts, JUSweptHit *hits) {
+	int hitCount = 0;
+	for (int i = 0; i < movers->count; i++) {
+		JURectangle rect = {movers->x[i], movers->y[i], movers->w[i], movers->h[i]};
+		JUSweptHit *best = &hits[i];
+		best->time = 1;
+		best->normalX = 0;
+		best->normalY = 0;
+		best->target = -1;
+		int start;
+		int count = juSweptCandidates(candidates, candidateStarts, i, targets->count, &start);
+
+		// Once something is hit at time 0 nothing can be earlier
+		for (int j = 0; j < count && (best->target == -1 || best->time > 0); j++) {
+			int32_t target = candidates != NULL ? candidates[start + j] : j;
+			JUSweptHit hit;
+			if (juSweptPointBox(rect.x, rect.y, movement->x[i], movement->y[i], targets->x[target] - rect.w, targets->y[target] - rect.h, targets->x[target] + targets->w[target], targets->y[target] + targets->h[target], &hit) && (best->target == -1 || hit.time < best->time)) {
+				*best = hit;
+				best->target = target;
+			}
+		}
+		hitCount += best->target != -1;
+	}
+	return hitCount;
+}
+
+int juSweptCircleBatch(const JUCircleBatch *movers, const JUPointBatch *movement, const JURectangleBatch *targets, const int32_t *candidates, const int32_t *candidateStarts, JUSweptHit *hits) {
+	int hitCount = 0;
+	for (int i = 0; i < movers->count; i++) {
+		JUCircle circle = {movers->x[i], movers->y[i], movers->r[i]};
+		JURectangle sweep = {circle.x - circle.r, circle.y - circle.r, circle.r * 2, circle.r * 2};
+		sweep = juSweptBounds(&sweep, movement->x[i], movement->y[i]);
+		JUSweptHit *best = &hits[i];
+		best->time = 1;
+		best->normalX = 0;
+		best->normalY = 0;
+		best->target = -1;
+		int start;
+		int count = juSweptCandidates(candidates, candidateStarts, i, targets->count, &start);
+		for (int j = 0; j < count && (best->target == -1 || best->time > 0); j++) {
+			int32_t target = candidates != NULL ? candidates[start + j] : j;
+			JURectangle rect = {targets->x[target], targets->y[target], targets->w[target], targets->h[target]};
+			JUSweptHit hit;
+
+			// The exact sweep is a lot more work than the rectangle one so anything outside the swept bounds is skipped first
+			if (juRectangleCollision(&sweep, &rect) && juSweptCircleRectangleCollision(&circle, movement->x[i], movement->y[i], &rect, &hit) && (best->target == -1 || hit.time < best->time)) {
+				*best = hit;
+				best->target = target;
+			}
+		}
+		hitCount += best->target != -1;
+	}
+	return hitCount;
+}
+
+/********************** Spatial Grid **********************/
+
+// Finds every proxy overlapping a shape that doesn't need to be in the grid
+static int juSpatialGridQueryShape(JUSpatialGrid grid, const JUSpatialGridProxy *shape, JUProxy *out, int outSize) {
+	int32_t minX = juSpatialGridCell(grid, shape->bounds.x);
+	int32_t minY = juSpatialGridCell(grid, shape->bounds.y);
+	int32_t maxX = juSpatialGridCell(grid, shape->bounds.x + shape->bounds.w);
+	int32_t maxY = juSpatialGridCell(grid, shape->bounds.y + shape->bounds.h);
+	int count = 0;
+
+	for (int32_t y = minY; y <= maxY; y++) {
+		for (int32_t x = minX; x <= maxX; x++) {
+			for (int32_t entry = grid->buckets[juSpatialGridBucket(grid, x, y)]; entry != -1; entry = grid->entries[entry].next) {
+				const JUSpatialGridEntry *e = &grid->entries[entry];
+				const JUSpatialGridProxy *p = &grid->proxies[e->proxy];
+
+				// A proxy is only reported from the first cell it shares with the area, so queries
+				// don't need any scratch memory to avoid duplicates and may run in parallel
+				if (e->cellX != x || e->cellY != y ||
+					x != (p->minX > minX ? p->minX : minX) || y != (p->minY > minY ? p->minY : minY))
+					continue;
+				if (juSpatialGridProxiesCollide(p, shape)) {
+					if (count < outSize)
+						out[count] = e->proxy;
+					count++;
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+// Takes an id off the free list or makes a new one
+static JUProxy juSpatialGridNewProxy(JUSpatialGrid grid) {
+	if (grid->freeProxies != -1) {
+		JUProxy proxy = grid->freeProxies;
+		grid->freeProxies = grid->proxies[proxy].nextFree;
+		return proxy;
+	}
+	return grid->proxyCount;
+}
+
+JUSpatialGrid juSpatialGridCreate(double cellSize) {
+	JUSpatialGrid grid = juMallocZero(sizeof(struct JUSpatialGrid));
+	grid->cellSize = cellSize;
+	grid->bucketCount = JU_SPATIAL_GRID_BUCKETS;
+	grid->buckets = juMalloc(sizeof(int32_t) * grid->bucketCount);
+	for (int i = 0; i < grid->bucketCount; i++)
+		grid->buckets[i] = -1;
+	grid->freeEntries = -1;
+	grid->freeProxies = -1;
+	return grid;
+}
+
+JUProxy juSpatialGridInsert(JUSpatialGrid grid, const JURectangle *rect) {
+	JUProxy proxy = juSpatialGridNewProxy(grid);
+	juSpatialGridSet(grid, proxy, rect);
+	return proxy;
+}
+
+JUProxy juSpatialGridInsertCircle(JUSpatialGrid grid, const JUCircle *circle) {
+	JUProxy proxy = juSpatialGridNewProxy(grid);
+	juSpatialGridUpdateCircle(grid, proxy, circle);
+	return proxy;
+}
+
+void juSpatialGridUpdate(JUSpatialGrid grid, JUProxy proxy, const JURectangle *rect) {
+	juSpatialGridSet(grid, proxy, rect);
+}
+
+void juSpatialGridUpdateCircle(JUSpatialGrid grid, JUProxy proxy, const JUCircle *circle) {
+	JURectangle bounds = {circle->x - circle->r, circle->y - circle->r, circle->r * 2, circle->r * 2};
+	juSpatialGridSet(grid, proxy, &bounds);
+	grid->proxies[proxy].circle = *circle;
+	grid->proxies[proxy].isCircle = true;
+}
+
+void juSpatialGridRemove(JUSpatialGrid grid, JUProxy proxy) {
+	if (proxy >= 0 && proxy < grid->proxyCount && grid->proxies[proxy].entries != -1) {
+		juSpatialGridClear(grid, proxy);
+		grid->proxies[proxy].nextFree = grid->freeProxies;
+		grid->freeProxies = proxy;
+	}
+}
+
+int juSpatialGridQuery(JUSpatialGrid grid, const JURectangle *area, JUProxy *proxies, int size) {
+	JUSpatialGridProxy shape = {0};
+	shape.bounds = *area;
+	return juSpatialGridQueryShape(grid, &shape, proxies, size);
+}
+
+int juSpatialGridQueryCircle(JUSpatialGrid grid, const JUCircle *area, JUProxy *proxies, int size) {
+	JUSpatialGridProxy shape = {0};
+	shape.bounds = (JURectangle){area->x - area->r, area->y - area->r, area->r * 2, area->r * 2};
+	shape.circle = *area;
+	shape.isCircle = true;
+	return juSpatialGridQueryShape(grid, &shape, proxies, size);
+}
+
+int juSpatialGridPairs(JUSpatialGrid grid, void (*pair)(JUProxy proxy1, JUProxy proxy2, void *data), void *data) {
+	int count = 0;
+
+	for (int i = 0; i < grid->bucketCount; i++) {
+		for (int32_t entry1 = grid->buckets[i]; entry1 != -1; entry1 = grid->entries[entry1].next) {
+			const JUSpatialGridEntry *e1 = &grid->entries[entry1];
+			const JUSpatialGridProxy *p1 = &grid->proxies[e1->proxy];
+			for (int32_t entry2 = e1->next; entry2 != -1; entry2 = grid->entries[entry2].next) {
+				const JUSpatialGridEntry *e2 = &grid->entries[entry2];
+				if (e2->cellX != e1->cellX || e2->cellY != e1->cellY)
+					continue;
+
+				// Only the first cell both proxies cover reports the pair
+				const JUSpatialGridProxy *p2 = &grid->proxies[e2->proxy];
+				if (e1->cellX != (p1->minX > p2->minX ? p1->minX : p2->minX) || e1->cellY != (p1->minY > p2->minY ? p1->minY : p2->minY))
+					continue;
+				if (juSpatialGridProxiesCollide(p1, p2)) {
+					if (pair != NULL)
+						pair(e1->proxy < e2->proxy ? e1->proxy : e2->proxy, e1->proxy < e2->proxy ? e2->proxy : e1->proxy, data);
+					count++;
+				}
+			}
+		}
+	}
+
+	return count;
+}
+
+void juSpatialGridFree(JUSpatialGrid grid) {
+	if (grid != NULL) {
+		juFree(grid->buckets);
+		juFree(grid->entries);
+		juFree(grid->proxies);
+		juFree(grid);
+	}
+}
+
+/********************** AABB Tree **********************/
+
+// Takes a node out of the pool, this may move every node
+static int32_t juAABBTreeAllocate(JUAABBTree tree) {
+	int32_t node = tree->freeNodes;
+	if (node != -1) {
+		tree->freeNodes = tree->nodes[node].parent;
+	} else {
+		if (tree->nodeCount == tree->nodeListSize) {
+			tree->nodeListSize += juListGrowth(tree->nodeListSize);
+			tree->nodes = juRealloc(tree->nodes, sizeof(struct JUAABBTreeNode) * tree->nodeListSize);
+		}
+		node = tree->nodeCount++;
+	}
+
+	JUAABBTreeNode *n = &tree->nodes[node];
+	n->parent = -1;
+	n->child1 = -1;
+	n->child2 = -1;
+	n->height = 0;
+	return node;
+}
+
+// Returns a node to the pool
+static void juAABBTreeRelease(JUAABBTree tree, int32_t node) {
+	tree->nodes[node].parent = tree->freeNodes;
+	tree->nodes[node].height = -1;
+	tree->freeNodes = node;
+}
+
+// Box around two nodes
+static inline void juAABBTreeUnion(JUAABBTreeNode *out, const JUAABBTreeNode *a, const JUAABBTreeNode *b) {
+	out->minX = a->minX < b->minX ? a->minX : b->minX;
+	out->minY = a->minY < b->minY ? a->minY : b->minY;
+	out->maxX = a->maxX > b->maxX ? a->maxX : b->maxX;
+	out->maxY = a->maxY > b->maxY ? a->maxY : b->maxY;
+}
+
+// Perimeter of the box around two nodes, the cost used to pick where leaves go
+static inline double juAABBTreeUnionPerimeter(const JUAABBTreeNode *a, const JUAABBTreeNode *b) {
+	JUAABBTreeNode box;
+	juAABBTreeUnion(&box, a, b);
+	return 2 * ((box.maxX - box.minX) + (box.maxY - box.minY));
+}
+
+// Perimeter of a node's box
+static inline double juAABBTreePerimeter(const JUAABBTreeNode *node) {
+	return 2 * ((node->maxX - node->minX) + (node->maxY - node->minY));
+}
+
+// Whether or not a node's box touches an area
+static inline bool juAABBTreeOverlaps(const JUAABBTreeNode *node, double minX, double minY, double maxX, double maxY) {
+	return node->minX <= maxX && node->maxX >= minX && node->minY <= maxY && node->maxY >= minY;
+}
+
+// Points a node's parent (or the root) at a different child
+static void juAABBTreeReplaceChild(JUAABBTree tree, int32_t parent, int32_t oldChild, int32_t newChild) {
+	if (parent == -1)
+		tree->root = newChild;
+	else if (tree->nodes[parent].child1 == oldChild)
+		tree->nodes[parent].child1 = newChild;
+	else
+		tree->nodes[parent].child2 = newChild;
+}
+
+// Recalculates a node's box and height from its children
+static void juAABBTreeRefit(JUAABBTree tree, int32_t node) {
+	JUAABBTreeNode *n = &tree->nodes[node];
+	const JUAABBTreeNode *c1 = &tree->nodes[n->child1];
+	const JUAABBTreeNode *c2 = &tree->nodes[n->child2];
+	juAABBTreeUnion(n, c1, c2);
+	n->height = 1 + (c1->height > c2->height ? c1->height : c2->height);
+}
+
+// Rotates the taller child of a node up if the node is unbalanced, returning the node now at the top of the subtree
+static int32_t juAABBTreeBalance(JUAABBTree tree, int32_t a) {
+	JUAABBTreeNode *nodes = tree->nodes;
+	if (nodes[a].child1 == -1 || nodes[a].height < 2)
+		return a;
+	int32_t b = nodes[a].child1;
+	int32_t c = nodes[a].child2;
+	int balance = nodes[c].height - nodes[b].height;
+	if (balance >= -1 && balance <= 1)
+		return a;
+
+	// Whichever child is taller takes a's place and a takes the shorter of its children
+	int32_t up = balance > 1 ? c : b;
+	int32_t tall = nodes[nodes[up].child1].height > nodes[nodes[up].child2].height ? nodes[up].child1 : nodes[up].child2;
+	int32_t shortChild = tall == nodes[up].child1 ? nodes[up].child2 : nodes[up].child1;
+	nodes[up].child1 = a;
+	nodes[up].child2 = tall;
+	nodes[up].parent = nodes[a].parent;
+	nodes[a].parent = up;
+	juAABBTreeReplaceChild(tree, nodes[up].parent, a, up);
+	if (up == c)
+		nodes[a].child2 = shortChild;
+	else
+		nodes[a].child1 = shortChild;
+	nodes[shortChild].parent = a;
+	juAABBTreeRefit(tree, a);
+	juAABBTreeRefit(tree, up);
+	return up;
+}
+
+// Fixes boxes and heights from a node up to the root, rebalancing along the way
+static void juAABBTreeFixUp(JUAABBTree tree, int32_t node) {
+	while (node != -1) {
+		node = juAABBTreeBalance(tree, node);
+		juAABBTreeRefit(tree, node);
+		node = tree->nodes[node].parent;
+	}
+}
+
+// Puts a leaf into the tree next to whichever node makes the tree grow the least
+static void juAABBTreeInsertLeaf(JUAABBTree tree, int32_t leaf) {
+	if (tree->root == -1) {
+		tree->root = leaf;
+		tree->nodes[leaf].parent = -1;
+		return;
+	}
+
+	// Walk down while it's cheaper to push the leaf further in than to pair it with this node
+	int32_t sibling = tree->root;
+	while (tree->nodes[sibling].child1 != -1) {
+		const JUAABBTreeNode *l = &tree->nodes[leaf];
+		const JUAABBTreeNode *n = &tree->nodes[sibling];
+		double combined = juAABBTreeUnionPerimeter(n, l);
+		double cost = 2 * combined;
+		double inheritance = 2 * (combined - juAABBTreePerimeter(n));
+		double costs[2];
+		int32_t children[2] = {n->child1, n->child2};
+		for (int i = 0; i < 2; i++) {
+			const JUAABBTreeNode *child = &tree->nodes[children[i]];
+			costs[i] = juAABBTreeUnionPerimeter(child, l) + inheritance;
+			if (child->child1 != -1)
+				costs[i] -= juAABBTreePerimeter(child);
+		}
+		if (cost < costs[0] && cost < costs[1])
+			break;
+		sibling = costs[0] < costs[1] ? children[0] : children[1];
+	}
+
+	int32_t oldParent = tree->nodes[sibling].parent;
+	int32_t parent = juAABBTreeAllocate(tree);
+	tree->nodes[parent].parent = oldParent;
+	tree->nodes[parent].child1 = sibling;
+	tree->nodes[parent].child2 = leaf;
+	tree->nodes[sibling].parent = parent;
+	tree->nodes[leaf].parent = parent;
+	juAABBTreeReplaceChild(tree, oldParent, sibling, parent);
+	juAABBTreeFixUp(tree, parent);
+}
+
+// Takes a leaf out of the tree, its parent goes back to the pool and its sibling takes the parent's place
+static void juAABBTreeRemoveLeaf(JUAABBTree tree, int32_t leaf) {
+	if (leaf == tree->root) {
+		tree->root = -1;
+		return;
+	}
 
-	juClockStart(clock);
+	int32_t parent = tree->nodes[leaf].parent;
+	int32_t grandparent = tree->nodes[parent].parent;
+	int32_t sibling = tree->nodes[parent].child1 == leaf ? tree->nodes[parent].child2 : tree->nodes[parent].child1;
+	juAABBTreeReplaceChild(tree, grandparent, parent, sibling);
+	tree->nodes[sibling].parent = grandparent;
+	juAABBTreeRelease(tree, parent);
+	juAABBTreeFixUp(tree, grandparent);
 }
 
-double juClockGetAverage(JUClock *clock) {
-	return clock->totalTime / clock->totalIterations;
+// Sets a leaf's exact bounds and fattens its box
+static void juAABBTreeSetLeaf(JUAABBTree tree, int32_t leaf, const JURectangle *rect) {
+	JUAABBTreeNode *n = &tree->nodes[leaf];
+	n->bounds = *rect;
+	n->minX = rect->x - tree->margin;
+	n->minY = rect->y - tree->margin;
+	n->maxX = rect->x + rect->w + tree->margin;
+	n->maxY = rect->y + rect->h + tree->margin;
 }
 
-/********************** Font **********************/
+JUAABBTree juAABBTreeCreate(double margin) {
+	JUAABBTree tree = juMallocZero(sizeof(struct JUAABBTree));
+	tree->freeNodes = -1;
+	tree->root = -1;
+	tree->margin = margin;
+	return tree;
+}
 
-JUFont juFontLoad(const char *filename) {
-	JUFont font = juMalloc(sizeof(struct JUFont));
-	bool error;
-	JUBinaryFont binaryFont = juLoadBinaryFont(filename, &error);
+JUProxy juAABBTreeInsert(JUAABBTree tree, const JURectangle *rect) {
+	int32_t leaf = juAABBTreeAllocate(tree);
+	juAABBTreeSetLeaf(tree, leaf, rect);
+	juAABBTreeInsertLeaf(tree, leaf);
+	return leaf;
+}
 
-	if (!error) {
-		// Create an SDL surface for the png
-		int w, h, channels;
-		void *pixels = stbi_load_from_memory(binaryFont.png, binaryFont.size, &w, &h, &channels, 4);
+bool juAABBTreeUpdate(JUAABBTree tree, JUProxy proxy, const JURectangle *rect) {
+	JUAABBTreeNode *n = &tree->nodes[proxy];
+	if (rect->x >= n->minX && rect->y >= n->minY && rect->x + rect->w <= n->maxX && rect->y + rect->h <= n->maxY) {
+		n->bounds = *rect;
+		return false;
+	}
 
-		if (pixels != NULL) {
-			font->image = vk2dImageFromPixels(vk2dRendererGetDevice(), pixels, w, h);
-			free(pixels);
-			font->bitmap = vk2dTextureLoadFromImage(font->image);
+	juAABBTreeRemoveLeaf(tree, proxy);
+	juAABBTreeSetLeaf(tree, proxy, rect);
+	juAABBTreeInsertLeaf(tree, proxy);
+	return true;
+}
 
-			// Basic data
-			font->unicodeStart = 1;
-			font->unicodeEnd = binaryFont.characters + 1;
-			font->characters = juMalloc(sizeof(struct JUCharacter) * binaryFont.characters);
-			font->newLineHeight = 0;
+void juAABBTreeRemove(JUAABBTree tree, JUProxy proxy) {
+	if (proxy >= 0 && proxy < tree->nodeCount && tree->nodes[proxy].height == 0) {
+		juAABBTreeRemoveLeaf(tree, proxy);
+		juAABBTreeRelease(tree, proxy);
+	}
+}
 
-			// Load the characters
-			int x = 0;
-			for (int i = 0; i < binaryFont.characters; i++) {
-				font->characters[i].x = x;
-				font->characters[i].y = 0;
-				font->characters[i].w = binaryFont.characterDimensions[i].width;
-				font->characters[i].h = binaryFont.characterDimensions[i].height;
-				if (font->newLineHeight < font->characters[i].h)
-					font->newLineHeight = font->characters[i].h;
-				x += binaryFont.characterDimensions[i].width;
-				font->characters[i].drawn = i >= 32;
+int juAABBTreeQuery(JUAABBTree tree, const JURectangle *area, JUProxy *proxies, int size) {
+	if (tree->root == -1)
+		return 0;
+	JURectangle rect = *area;
+	int32_t stack[tree->nodes[tree->root].height + 2];
+	int stackSize = 1;
+	int count = 0;
+	stack[0] = tree->root;
+
+	while (stackSize > 0) {
+		const JUAABBTreeNode *n = &tree->nodes[stack[--stackSize]];
+		if (!juAABBTreeOverlaps(n, area->x, area->y, area->x + area->w, area->y + area->h))
+			continue;
+		if (n->child1 == -1) {
+			JURectangle bounds = n->bounds;
+			if (juRectangleCollision(&bounds, &rect)) {
+				if (count < size)
+					proxies[count] = n - tree->nodes;
+				count++;
 			}
 		} else {
-			juLog("Failed to load font's image");
+			stack[stackSize++] = n->child1;
+			stack[stackSize++] = n->child2;
 		}
-
-		free(binaryFont.png);
-		free(binaryFont.characterDimensions);
 	}
 
-	return font;
+	return count;
 }
 
-JUFont juFontLoadFromImage(const char *image, uint32_t unicodeStart, uint32_t unicodeEnd, float w, float h) {
-	// Setup font struct
-	JUFont font = juMalloc(sizeof(struct JUFont));
-	font->characters = juMalloc(sizeof(struct JUCharacter) * (unicodeEnd - unicodeStart));
-	font->bitmap = vk2dTextureLoad(image);
-	font->image = NULL;
-	font->newLineHeight = h;
-	font->unicodeStart = unicodeStart;
-	font->unicodeEnd = unicodeEnd;
+JUProxy juAABBTreeRaycast(JUAABBTree tree, double x1, double y1, double x2, double y2, double *fraction) {
+	if (tree->root == -1)
+		return JU_NO_PROXY;
+	int32_t stack[tree->nodes[tree->root].height + 2];
+	int stackSize = 1;
+	double closest = 1;
+	JUProxy hit = JU_NO_PROXY;
+	stack[0] = tree->root;
+
+	// Every hit shortens the ray so boxes further than the closest hit so far are skipped
+	while (stackSize > 0) {
+		const JUAABBTreeNode *n = &tree->nodes[stack[--stackSize]];
+		double t;
+		if (!juRaycastBox(n->minX, n->minY, n->maxX, n->maxY, x1, y1, x2 - x1, y2 - y1, closest, &t))
+			continue;
+		if (n->child1 == -1) {
+			if (juRaycastBox(n->bounds.x, n->bounds.y, n->bounds.x + n->bounds.w, n->bounds.y + n->bounds.h, x1, y1, x2 - x1, y2 - y1, closest, &t) && (hit == JU_NO_PROXY || t < closest)) {
+				closest = t;
+				hit = n - tree->nodes;
+			}
+		} else {
+			stack[stackSize++] = n->child1;
+			stack[stackSize++] = n->child2;
+		}
+	}
 
-	// Make sure the texture loaded and the texture has enough space to load the desired characters
-	if (font->bitmap != NULL && w * h * (unicodeEnd - unicodeStart) <= font->bitmap->img->width * font->bitmap->img->height) {
-		// Calculate positions of every character in the font
-		float x = 0;
-		float y = 0;
-		int i = unicodeStart;
-		while (i < unicodeEnd) {
-			font->characters[i - unicodeStart].x = x;
-			font->characters[i - unicodeStart].y = y;
-			font->characters[i - unicodeStart].w = w;
-			font->characters[i - unicodeStart].h = h;
-			font->characters[i - unicodeStart].drawn = true;
-			if (x + w >= font->bitmap->img->width) {
-				y += h;
-				x = 0;
+	if (fraction != NULL && hit != JU_NO_PROXY)
+		*fraction = closest;
+	return hit;
+}
+
+int juAABBTreePairs(JUAABBTree tree, void (*pair)(JUProxy proxy1, JUProxy proxy2, void *data), void *data) {
+	if (tree->root == -1)
+		return 0;
+	int32_t stack[tree->nodes[tree->root].height + 2];
+	int count = 0;
+
+	// Each leaf is queried against the tree and only reports leaves with bigger ids so pairs aren't doubled
+	for (int32_t leaf = 0; leaf < tree->nodeCount; leaf++) {
+		const JUAABBTreeNode *l = &tree->nodes[leaf];
+		if (l->height != 0)
+			continue;
+		JURectangle bounds = l->bounds;
+		int stackSize = 1;
+		stack[0] = tree->root;
+		while (stackSize > 0) {
+			const JUAABBTreeNode *n = &tree->nodes[stack[--stackSize]];
+			if (!juAABBTreeOverlaps(n, bounds.x, bounds.y, bounds.x + bounds.w, bounds.y + bounds.h))
+				continue;
+			if (n->child1 == -1) {
+				JURectangle other = n->bounds;
+				JUProxy proxy = n - tree->nodes;
+				if (proxy > leaf && juRectangleCollision(&bounds, &other)) {
+					if (pair != NULL)
+						pair(leaf, proxy, data);
+					count++;
+				}
 			} else {
-				x += w;
+				stack[stackSize++] = n->child1;
+				stack[stackSize++] = n->child2;
 			}
-			i++;
 		}
-	} else {
-		juLog("Failed to load texture \"%s\"", image);
-		vk2dTextureFree(font->bitmap);
-		free(font->characters);
-		free(font);
-		font = NULL;
 	}
 
-	return font;
+	return count;
 }
 
-void juFontFree(JUFont font) {
-	if (font != NULL) {
-		vk2dTextureFree(font->bitmap);
-		vk2dImageFree(font->image);
-		free(font->characters);
-		free(font);
+void juAABBTreeFree(JUAABBTree tree) {
+	if (tree != NULL) {
+		juFree(tree->nodes);
+		juFree(tree);
 	}
 }
 
-void juFontDraw(JUFont font, float x, float y, const char *fmt, ...) {
-	// Var args stuff
-	unsigned char buffer[JU_STRING_BUFFER];
-	va_list va;
-	va_start(va, fmt);
-	vsprintf((void*)buffer, fmt, va);
-	va_end(va);
+/********************** Sweep and Prune **********************/
 
-	// Information needed to draw the text
-	float startX = x;
-	int len = strlen((void*)buffer);
+// Key of a pair in the pair set, smaller proxy in the top half
+static inline uint64_t juSweepPairKey(JUProxy a, JUProxy b) {
+	return a < b ? ((uint64_t)a << 32) | (uint32_t)b : ((uint64_t)b << 32) | (uint32_t)a;
+}
 
-	// Loop through each character and render individually
-	for (int i = 0; i < len; i++) {
-		if (font->unicodeStart <= buffer[i] && font->unicodeEnd > buffer[i]) {
-			JUCharacter *c = &font->characters[buffer[i] - font->unicodeStart];
+// Slot a pair key starts probing from
+static inline int juSweepPairSlot(uint64_t key, int size) {
+	return (int)((key * 0x9E3779B97F4A7C15ull) >> 32) & (size - 1);
+}
 
-			// Move to the next line if we're about to go over
-			if (buffer[i] == '\n') {
-				x = startX;
-				y += font->newLineHeight;
-			}
+// Finds the slot a key is in, or the empty slot it would go in
+static int juSweepPairFind(const uint64_t *pairs, int size, uint64_t key) {
+	int slot = juSweepPairSlot(key, size);
+	while (pairs[slot] != JU_SWEEP_EMPTY_PAIR && pairs[slot] != key)
+		slot = (slot + 1) & (size - 1);
+	return slot;
+}
 
-			// Draw character (or not) and move the cursor forward
-			if (c->drawn)
-				vk2dRendererDrawTexture(font->bitmap, x, y, 1, 1, 0, 0, 0, c->x, c->y, c->w, c->h);
-			if (buffer[i] != '\n') x += c->w;
-		}
-	}
+// Makes an empty pair set
+static uint64_t *juSweepPairsCreate(int size) {
+	uint64_t *pairs = juMalloc(sizeof(uint64_t) * size);
+	memset(pairs, 0xff, sizeof(uint64_t) * size);
+	return pairs;
 }
 
-void juFontDrawWrapped(JUFont font, float x, float y, float w, const char *fmt, ...) {
-	// Var args stuff
-	unsigned char buffer[JU_STRING_BUFFER];
-	va_list va;
-	va_start(va, fmt);
-	vsprintf((void*)buffer, fmt, va);
-	va_end(va);
+// Adds a pair to the set, returning false if it was already there
+static bool juSweepPairAdd(JUSweepAndPrune sap, uint64_t key) {
+	if ((sap->pairCount + 1) * 2 > sap->pairListSize) {
+		uint64_t *old = sap->pairs;
+		int oldSize = sap->pairListSize;
+		sap->pairListSize *= 2;
+		sap->pairs = juSweepPairsCreate(sap->pairListSize);
+		for (int i = 0; i < oldSize; i++)
+			if (old[i] != JU_SWEEP_EMPTY_PAIR)
+				sap->pairs[juSweepPairFind(sap->pairs, sap->pairListSize, old[i])] = old[i];
+		juFree(old);
+	}
+	int slot = juSweepPairFind(sap->pairs, sap->pairListSize, key);
+	if (sap->pairs[slot] == key)
+		return false;
+	sap->pairs[slot] = key;
+	sap->pairCount++;
+	sap->proxies[key >> 32].pairs++;
+	sap->proxies[key & 0xffffffff].pairs++;
+	return true;
+}
 
-	// Information needed to draw the text
-	float startX = x;
-	int len = strlen((void*)buffer);
-	bool justMadeNewline = false;
+// Removes a pair from the set, returning false if it wasn't there
+static bool juSweepPairRemove(JUSweepAndPrune sap, uint64_t key) {
+	int mask = sap->pairListSize - 1;
+	int slot = juSweepPairFind(sap->pairs, sap->pairListSize, key);
+	if (sap->pairs[slot] != key)
+		return false;
+
+	// Shift back any later keys that probed past this slot so lookups never hit a gap
+	for (int next = (slot + 1) & mask; sap->pairs[next] != JU_SWEEP_EMPTY_PAIR; next = (next + 1) & mask) {
+		int home = juSweepPairSlot(sap->pairs[next], sap->pairListSize);
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			sap->pairs[slot] = sap->pairs[next];
+			slot = next;
+		}
+	}
+	sap->pairs[slot] = JU_SWEEP_EMPTY_PAIR;
+	sap->pairCount--;
+	sap->proxies[key >> 32].pairs--;
+	sap->proxies[key & 0xffffffff].pairs--;
+	return true;
+}
 
-	// Loop through each character and render individually
-	for (int i = 0; i < len; i++) {
-		if (font->unicodeStart <= buffer[i] && font->unicodeEnd > buffer[i]) {
-			JUCharacter *c = &font->characters[buffer[i] - font->unicodeStart];
+// Endpoint order, max edges go before min edges at the same position so touching proxies aren't overlapping
+static inline bool juSweepEndpointLess(const JUSweepEndpoint *a, const JUSweepEndpoint *b) {
+	return a->value < b->value || (a->value == b->value && (a->data & 1) > (b->data & 1));
+}
 
-			// Move to the next line if we're about to go over
-			if ((c->w + x) - startX > w || buffer[i] == '\n') {
-				x = startX;
-				y += font->newLineHeight;
-				justMadeNewline = true;
-			} else {
-				justMadeNewline = false;
-			}
+// qsort version of juSweepEndpointLess
+static int juSweepEndpointCompare(const void *a, const void *b) {
+	if (juSweepEndpointLess(a, b))
+		return -1;
+	return juSweepEndpointLess(b, a) ? 1 : 0;
+}
 
-			// Draw character (or not) and move the cursor forward
-			if (!(buffer[i] == ' ' && justMadeNewline)) {
-				if (c->drawn)
-					vk2dRendererDrawTexture(font->bitmap, x, y, 1, 1, 0, 0, 0, c->x, c->y, c->w, c->h);
-				if (buffer[i] != '\n') x += c->w;
+// Insertion sorts one axis, each min edge that passes a max edge may start a pair and each max edge that passes a min edge ends one
+static int juSweepAndPruneSort(JUSweepAndPrune sap, int axis, void (*event)(JUProxy proxy1, JUProxy proxy2, bool begin, void *data), void *data) {
+	JUSweepEndpoint *endpoints = sap->endpoints[axis];
+	int events = 0;
+	for (int i = 1; i < sap->endpointCount; i++) {
+		JUSweepEndpoint endpoint = endpoints[i];
+		JUProxy proxy = endpoint.data >> 1;
+		int j = i;
+		while (j > 0 && juSweepEndpointLess(&endpoint, &endpoints[j - 1])) {
+			JUSweepEndpoint *prev = &endpoints[j - 1];
+			JUProxy other = prev->data >> 1;
+			if (other != proxy && (endpoint.data & 1) != (prev->data & 1)) {
+				uint64_t key = juSweepPairKey(proxy, other);
+				if ((endpoint.data & 1) == 0) {
+					if (juRectangleCollision(&sap->proxies[proxy].rect, &sap->proxies[other].rect) && juSweepPairAdd(sap, key)) {
+						if (event != NULL)
+							event(key >> 32, key & 0xffffffff, true, data);
+						events++;
+					}
+				} else if (sap->proxies[proxy].pairs > 0 && sap->proxies[other].pairs > 0 && juSweepPairRemove(sap, key)) {
+					if (event != NULL)
+						event(key >> 32, key & 0xffffffff, false, data);
+					events++;
+				}
 			}
+			endpoints[j] = *prev;
+			j--;
 		}
+		endpoints[j] = endpoint;
 	}
+	return events;
 }
 
-/********************** Buffer **********************/
-
-JUBuffer juBufferLoad(const char *filename) {
-	JUBuffer buffer = juMalloc(sizeof(struct JUBuffer));
-	buffer->data = juGetFile(filename, &buffer->size);
-
-	if (buffer->data == NULL) {
-		free(buffer);
-		buffer = NULL;
+// Sorts everything from scratch, finds every pair with one sweep along x, and reports the difference from the old pair set
+static int juSweepAndPruneRebuild(JUSweepAndPrune sap, void (*event)(JUProxy proxy1, JUProxy proxy2, bool begin, void *data), void *data) {
+	qsort(sap->endpoints[0], sap->endpointCount, sizeof(JUSweepEndpoint), juSweepEndpointCompare);
+	qsort(sap->endpoints[1], sap->endpointCount, sizeof(JUSweepEndpoint), juSweepEndpointCompare);
+	uint64_t *oldPairs = sap->pairs;
+	int oldSize = sap->pairListSize;
+	sap->pairListSize = JU_SWEEP_PAIR_SLOTS;
+	sap->pairs = juSweepPairsCreate(sap->pairListSize);
+	sap->pairCount = 0;
+	for (int i = 0; i < sap->proxyCount; i++)
+		sap->proxies[i].pairs = 0;
+
+	// Proxies whose min edge has been passed but not their max edge, positions let them be swap-removed
+	JUProxy *active = juMalloc(sizeof(JUProxy) * (sap->endpointCount / 2 + 1));
+	int32_t *positions = juMalloc(sizeof(int32_t) * (sap->proxyCount + 1));
+	int activeCount = 0;
+	for (int i = 0; i < sap->endpointCount; i++) {
+		JUProxy proxy = sap->endpoints[0][i].data >> 1;
+		if (sap->endpoints[0][i].data & 1) {
+			JUProxy last = active[--activeCount];
+			active[positions[proxy]] = last;
+			positions[last] = positions[proxy];
+		} else {
+			for (int j = 0; j < activeCount; j++)
+				if (juRectangleCollision(&sap->proxies[proxy].rect, &sap->proxies[active[j]].rect))
+					juSweepPairAdd(sap, juSweepPairKey(proxy, active[j]));
+			positions[proxy] = activeCount;
+			active[activeCount++] = proxy;
+		}
 	}
-
-	return buffer;
+	juFree(positions);
+	juFree(active);
+
+	int events = 0;
+	for (int i = 0; i < oldSize; i++) {
+		uint64_t key = oldPairs[i];
+		if (key != JU_SWEEP_EMPTY_PAIR && sap->pairs[juSweepPairFind(sap->pairs, sap->pairListSize, key)] != key) {
+			if (event != NULL)
+				event(key >> 32, key & 0xffffffff, false, data);
+			events++;
+		}
+	}
+	for (int i = 0; i < sap->pairListSize; i++) {
+		uint64_t key = sap->pairs[i];
+		if (key != JU_SWEEP_EMPTY_PAIR && oldPairs[juSweepPairFind(oldPairs, oldSize, key)] != key) {
+			if (event != NULL)
+				event(key >> 32, key & 0xffffffff, true, data);
+			events++;
+		}
+	}
+	juFree(oldPairs);
+	return events;
 }
 
-JUBuffer juBufferCreate(void *data, uint32_t size) {
-	JUBuffer buffer = juMalloc(sizeof(struct JUBuffer));
-	buffer->data = juMalloc(size);
-	buffer->size = size;
-	memcpy(buffer->data, data, size);
-	return buffer;
+JUSweepAndPrune juSweepAndPruneCreate() {
+	JUSweepAndPrune sap = juMallocZero(sizeof(struct JUSweepAndPrune));
+	sap->freeProxies = -1;
+	sap->pairListSize = JU_SWEEP_PAIR_SLOTS;
+	sap->pairs = juSweepPairsCreate(sap->pairListSize);
+	return sap;
 }
 
-void juBufferSave(JUBuffer buffer, const char *filename) {
-	FILE *out = fopen(filename, "wb");
-
-	if (out != NULL) {
-		fwrite(buffer->data, buffer->size, 1, out);
-		fclose(out);
+JUProxy juSweepAndPruneInsert(JUSweepAndPrune sap, const JURectangle *rect) {
+	JUProxy proxy = sap->freeProxies;
+	if (proxy != -1) {
+		sap->freeProxies = sap->proxies[proxy].nextFree;
 	} else {
-		juLog("Failed to open file \"%s\"", filename);
+		if (sap->proxyCount == sap->proxyListSize) {
+			sap->proxyListSize += juListGrowth(sap->proxyListSize);
+			sap->proxies = juRealloc(sap->proxies, sizeof(struct JUSweepProxy) * sap->proxyListSize);
+		}
+		proxy = sap->proxyCount++;
 	}
-}
-
-void juBufferFree(JUBuffer buffer) {
-	if (buffer != NULL) {
-		free(buffer->data);
-		free(buffer);
+	sap->proxies[proxy].rect = *rect;
+	sap->proxies[proxy].pairs = 0;
+	sap->proxies[proxy].alive = true;
+
+	// New edges go on the end and get sorted into place by the next sweep
+	if (sap->endpointCount + 2 > sap->endpointListSize) {
+		sap->endpointListSize += juListGrowth(sap->endpointListSize) + 2;
+		sap->endpoints[0] = juRealloc(sap->endpoints[0], sizeof(struct JUSweepEndpoint) * sap->endpointListSize);
+		sap->endpoints[1] = juRealloc(sap->endpoints[1], sizeof(struct JUSweepEndpoint) * sap->endpointListSize);
+	}
+	for (int axis = 0; axis < 2; axis++) {
+		sap->endpoints[axis][sap->endpointCount].data = proxy << 1;
+		sap->endpoints[axis][sap->endpointCount + 1].data = (proxy << 1) | 1;
 	}
+	sap->endpointCount += 2;
+	sap->added++;
+	return proxy;
 }
 
-void juBufferSaveRaw(void *data, uint32_t size, const char *filename) {
-	FILE *out = fopen(filename, "wb");
+void juSweepAndPruneUpdate(JUSweepAndPrune sap, JUProxy proxy, const JURectangle *rect) {
+	sap->proxies[proxy].rect = *rect;
+}
 
-	if (out != NULL) {
-		fwrite(data, size, 1, out);
-		fclose(out);
-	} else {
-		juLog("Failed to open file \"%s\"", filename);
+void juSweepAndPruneRemove(JUSweepAndPrune sap, JUProxy proxy) {
+	if (sap->proxies[proxy].alive) {
+		sap->proxies[proxy].alive = false;
+		sap->removed++;
 	}
 }
 
-/********************** Jobs System **********************/
-
-void juJobQueue(JUJob job) {
-	gJobSystem.channels[job.channel] += 1;
+int juSweepAndPruneSweep(JUSweepAndPrune sap, void (*event)(JUProxy proxy1, JUProxy proxy2, bool begin, void *data), void *data) {
+	int events = 0;
+
+	// End every pair with a removed proxy before their edges go
+	if (sap->removed > 0) {
+		uint64_t *ended = juMalloc(sizeof(uint64_t) * (sap->pairCount + 1));
+		int endedCount = 0;
+		for (int i = 0; i < sap->pairListSize; i++) {
+			uint64_t key = sap->pairs[i];
+			if (key != JU_SWEEP_EMPTY_PAIR && (!sap->proxies[key >> 32].alive || !sap->proxies[key & 0xffffffff].alive))
+				ended[endedCount++] = key;
+		}
+		for (int i = 0; i < endedCount; i++) {
+			juSweepPairRemove(sap, ended[i]);
+			if (event != NULL)
+				event(ended[i] >> 32, ended[i] & 0xffffffff, false, data);
+		}
+		events += endedCount;
+		juFree(ended);
+	}
 
-	// Wait for the queue and queue it
-	pthread_mutex_lock(&gJobSystem.queueAccess);
+	// Drop removed proxies' edges and pick up everyone's new positions
+	for (int axis = 0; axis < 2; axis++) {
+		JUSweepEndpoint *endpoints = sap->endpoints[axis];
+		int count = 0;
+		for (int i = 0; i < sap->endpointCount; i++) {
+			JUProxy proxy = endpoints[i].data >> 1;
+			JUSweepProxy *p = &sap->proxies[proxy];
+			if (!p->alive) {
+				if (axis == 0 && (endpoints[i].data & 1) == 0) {
+					p->nextFree = sap->freeProxies;
+					sap->freeProxies = proxy;
+				}
+				continue;
+			}
+			endpoints[count].data = endpoints[i].data;
+			if (axis == 0)
+				endpoints[count].value = (endpoints[i].data & 1) ? p->rect.x + p->rect.w : p->rect.x;
+			else
+				endpoints[count].value = (endpoints[i].data & 1) ? p->rect.y + p->rect.h : p->rect.y;
+			count++;
+		}
+		if (axis == 1)
+			sap->endpointCount = count;
+	}
+	sap->removed = 0;
 
-	// Extend queue list
-	if (gJobSystem.queueListSize == gJobSystem.queueSize) {
-		gJobSystem.queue = juRealloc(gJobSystem.queue, (gJobSystem.queueListSize + JU_LIST_EXTENSION) * sizeof(JUJob));
-		gJobSystem.queueListSize += JU_LIST_EXTENSION;
+	if (sap->added > 0 && sap->added * JU_SWEEP_REBUILD_RATIO >= sap->endpointCount / 2) {
+		events += juSweepAndPruneRebuild(sap, event, data);
+	} else {
+		events += juSweepAndPruneSort(sap, 0, event, data);
+		events += juSweepAndPruneSort(sap, 1, event, data);
 	}
-	gJobSystem.queue[gJobSystem.queueSize] = job;
-	gJobSystem.queueSize++;
+	sap->added = 0;
+	return events;
+}
 
-	pthread_mutex_unlock(&gJobSystem.queueAccess);
+int juSweepAndPrunePairs(JUSweepAndPrune sap, void (*pair)(JUProxy proxy1, JUProxy proxy2, void *data), void *data) {
+	if (pair != NULL)
+		for (int i = 0; i < sap->pairListSize; i++)
+			if (sap->pairs[i] != JU_SWEEP_EMPTY_PAIR)
+				pair(sap->pairs[i] >> 32, sap->pairs[i] & 0xffffffff, data);
+	return sap->pairCount;
 }
 
-void juJobWaitChannel(int channel) {
-	bool done = false;
-	while (!done) {
-		done = gJobSystem.channels[channel] == 0;
+void juSweepAndPruneFree(JUSweepAndPrune sap) {
+	if (sap != NULL) {
+		juFree(sap->proxies);
+		juFree(sap->endpoints[0]);
+		juFree(sap->endpoints[1]);
+		juFree(sap->pairs);
+		juFree(sap);
 	}
 }
 
-/********************** Asset Loader **********************/
+/********************** Tile Map **********************/
 
-// Puts an asset into the loader (properly)
-static void juLoaderAdd(JULoader loader, JUAsset asset) {
-	uint32_t hash = juHash(asset->name);
+// Mask of bits from..to (inclusive) in a word
+static inline uint64_t juTileMapMask(int from, int to) {
+	uint64_t high = to == 63 ? UINT64_MAX : ((uint64_t)1 << (to + 1)) - 1;
+	return high & ~(((uint64_t)1 << from) - 1);
+}
 
-	// Either we drop the asset right into its slot or send it down a linked
-	// list chain if there is a hash collision
-	if (loader->assets[hash] == NULL) {
-		loader->assets[hash] = asset;
-	} else {
-		JUAsset current = loader->assets[hash];
-		bool placed = false;
-		while (!placed) {
-			if (current->next == NULL) {
-				placed = true;
-				current->next = asset;
-			} else {
-				current = current->next;
-			}
-		}
-	}
+// Tiles a world space range strictly overlaps along one axis, empty (last < first) if it is thinner than the epsilon
+static inline void juTileMapRange(double min, double max, double origin, double tileSize, int *first, int *last) {
+	*first = (int)floor(((min - origin) / tileSize) + JU_TILE_EPSILON);
+	*last = (int)ceil(((max - origin) / tileSize) - JU_TILE_EPSILON) - 1;
 }
 
-// Just gets the raw asset from the loader
-static JUAsset juLoaderGet(JULoader loader, const char *key, JUAssetType type) {
-	JUAsset current = loader->assets[juHash(key)];
-	bool found = false;
+JUTileMap juTileMapCreate(int width, int height, double tileWidth, double tileHeight) {
+	JUTileMap map = juMallocZero(sizeof(struct JUTileMap));
+	map->width = width;
+	map->height = height;
+	map->rowWords = (width + 63) / 64;
+	map->tileWidth = tileWidth;
+	map->tileHeight = tileHeight;
+	map->tiles = juMallocZero(sizeof(uint64_t) * map->rowWords * height);
+	return map;
+}
 
-	while (!found) {
-		if (current != NULL && strcmp(current->name, key) == 0 && current->type == type) // this is the right asset
-			found = true;
-		else if (current != NULL) // wrong one, next one down the chain
-			current = current->next;
-		else // it doesn't exist, current should be null at this point
-			found = true;
+void juTileMapSet(JUTileMap map, int x, int y, bool solid) {
+	if (x < 0 || y < 0 || x >= map->width || y >= map->height)
+		return;
+	uint64_t *word = &map->tiles[(y * map->rowWords) + (x / 64)];
+	if (solid)
+		*word |= (uint64_t)1 << (x % 64);
+	else
+		*word &= ~((uint64_t)1 << (x % 64));
+}
+
+void juTileMapFill(JUTileMap map, int x, int y, int w, int h, bool solid) {
+	int startX = x > 0 ? x : 0;
+	int endX = x + w < map->width ? x + w - 1 : map->width - 1;
+	int startY = y > 0 ? y : 0;
+	int endY = y + h < map->height ? y + h - 1 : map->height - 1;
+	for (int row = startY; row <= endY && startX <= endX; row++) {
+		uint64_t *words = &map->tiles[row * map->rowWords];
+		for (int word = startX / 64; word <= endX / 64; word++) {
+			uint64_t mask = juTileMapMask(word == startX / 64 ? startX % 64 : 0, word == endX / 64 ? endX % 64 : 63);
+			if (solid)
+				words[word] |= mask;
+			else
+				words[word] &= ~mask;
+		}
 	}
+}
 
-	return current;
+bool juTileMapGet(JUTileMap map, int x, int y) {
+	if (x < 0 || y < 0 || x >= map->width || y >= map->height)
+		return false;
+	return (map->tiles[(y * map->rowWords) + (x / 64)] >> (x % 64)) & 1;
 }
 
-// Frees a specific asset (not its next one in its chain though)
-static void juLoaderAssetFree(JUAsset asset) {
-	if (asset->type == JU_ASSET_TYPE_FONT) {
-		juFontFree(asset->Asset.font);
-	} else if (asset->type == JU_ASSET_TYPE_TEXTURE) {
-		vk2dTextureFree(asset->Asset.tex);
-	} else if (asset->type == JU_ASSET_TYPE_SOUND) {
-		juSoundFree(asset->Asset.sound);
-	} else if (asset->type == JU_ASSET_TYPE_BUFFER) {
-		juBufferFree(asset->Asset.buffer);
-	} else if (asset->type == JU_ASSET_TYPE_SPRITE) {
-		juSpriteFree(asset->Asset.sprite);
+int juTileMapFindSolid(JUTileMap map, int row, int from, int to) {
+	if (row < 0 || row >= map->height)
+		return -1;
+	const uint64_t *words = &map->tiles[row * map->rowWords];
+	if (from <= to) {
+		from = from > 0 ? from : 0;
+		to = to < map->width ? to : map->width - 1;
+		for (int word = from / 64; word <= to / 64 && from <= to; word++) {
+			uint64_t bits = words[word] & juTileMapMask(word == from / 64 ? from % 64 : 0, word == to / 64 ? to % 64 : 63);
+			if (bits != 0)
+				return (word * 64) + juLowestBit(bits);
+		}
+	} else {
+		from = from < map->width ? from : map->width - 1;
+		to = to > 0 ? to : 0;
+		for (int word = from / 64; word >= to / 64 && to <= from; word--) {
+			uint64_t bits = words[word] & juTileMapMask(word == to / 64 ? to % 64 : 0, word == from / 64 ? from % 64 : 63);
+			if (bits != 0)
+				return (word * 64) + juHighestBit(bits);
+		}
 	}
-	free((void*)asset->name);
-	free(asset);
+	return -1;
 }
 
-JULoader juLoaderCreate(JULoadedAsset *files, uint32_t fileCount) {
-	JULoader loader = juMalloc(sizeof(struct JULoader));
-	JUAsset *assets = juMallocZero(JU_BUCKET_SIZE * sizeof(struct JUAsset));
-	loader->assets = assets;
-
-	// Load all assets
-	for (int i = 0; i < fileCount; i++) {
-		const char *extension = files[i].path + juLastDot(files[i].path) + 1;
-		JUAsset asset = juMalloc(sizeof(struct JUAsset));
-		asset->name = juCopyString(files[i].path);
-		asset->next = NULL;
+bool juTileMapSpanSolid(JUTileMap map, int x, int y, int w, int h) {
+	if (w <= 0)
+		return false;
+	for (int row = y; row < y + h; row++)
+		if (juTileMapFindSolid(map, row, x, x + w - 1) != -1)
+			return true;
+	return false;
+}
 
-		// Load file based on asset
-		if (strcmp(extension, "jufnt") == 0) {
-			asset->type = JU_ASSET_TYPE_FONT;
-			asset->Asset.font = juFontLoad(files[i].path);
-		} else if (strcmp(extension, "png") == 0 || strcmp(extension, "jpg") == 0 || strcmp(extension, "jpeg") == 0 || strcmp(extension, "bmp") == 0) {
-			if (files[i].h + files[i].w + files[i].delay != 0) {
-				// Sprite
-				asset->type = JU_ASSET_TYPE_SPRITE; // TODO: Check for existing textures with the same name first
+bool juTileMapCollision(JUTileMap map, const JURectangle *rect) {
+	int firstX, lastX, firstY, lastY;
+	juTileMapRange(rect->x, rect->x + rect->w, map->x, map->tileWidth, &firstX, &lastX);
+	juTileMapRange(rect->y, rect->y + rect->h, map->y, map->tileHeight, &firstY, &lastY);
+	return juTileMapSpanSolid(map, firstX, firstY, lastX - firstX + 1, lastY - firstY + 1);
+}
 
-				// Check if we already loaded the texture
-				JUAsset tex = juLoaderGet(loader, asset->name, JU_ASSET_TYPE_TEXTURE);
-				if (tex != NULL)
-					asset->Asset.sprite = juSpriteFrom(tex->Asset.tex, files[i].x, files[i].y, files[i].w, files[i].h, files[i].delay, files[i].frames);
-				else
-					asset->Asset.sprite = juSpriteCreate(files[i].path, files[i].x, files[i].y, files[i].w, files[i].h, files[i].delay, files[i].frames);
-				if (asset->Asset.sprite != NULL) {
-					asset->Asset.sprite->originX = files[i].originX;
-					asset->Asset.sprite->originY = files[i].originY;
-				}
-			} else {
-				// Just a textures
-				asset->type = JU_ASSET_TYPE_TEXTURE;
-				asset->Asset.tex = vk2dTextureLoad(files[i].path);
+bool juTileMapMove(JUTileMap map, JURectangle *rect, double dx, double dy, bool *hitX, bool *hitY) {
+	int firstX, lastX, firstY, lastY;
+	bool blockedX = false;
+	bool blockedY = false;
+
+	// Horizontal, the columns the leading edge moves into are searched row by row for the nearest solid tile
+	if (dx != 0) {
+		juTileMapRange(rect->y, rect->y + rect->h, map->y, map->tileHeight, &firstY, &lastY);
+		double edge = dx > 0 ? rect->x + rect->w : rect->x;
+		int from, to;
+		if (dx > 0) {
+			from = (int)ceil(((edge - map->x) / map->tileWidth) - JU_TILE_EPSILON);
+			to = (int)ceil(((edge + dx - map->x) / map->tileWidth) - JU_TILE_EPSILON) - 1;
+		} else {
+			from = (int)floor(((edge - map->x) / map->tileWidth) + JU_TILE_EPSILON) - 1;
+			to = (int)floor(((edge + dx - map->x) / map->tileWidth) + JU_TILE_EPSILON);
+		}
+		int nearest = -1;
+		if ((dx > 0 && from <= to) || (dx < 0 && from >= to)) {
+			for (int row = firstY; row <= lastY; row++) {
+				int column = juTileMapFindSolid(map, row, from, to);
+				if (column != -1 && (nearest == -1 || (dx > 0 ? column < nearest : column > nearest)))
+					nearest = column;
 			}
-		} else if (strcmp(extension, "wav") == 0) {
-			asset->type = JU_ASSET_TYPE_SOUND;
-			asset->Asset.sound = juSoundLoad(files[i].path);
+		}
+		if (nearest == -1) {
+			rect->x += dx;
 		} else {
-			asset->type = JU_ASSET_TYPE_BUFFER;
-			asset->Asset.buffer = juBufferLoad(files[i].path);
+			blockedX = true;
+			rect->x = dx > 0 ? map->x + (nearest * map->tileWidth) - rect->w : map->x + ((nearest + 1) * map->tileWidth);
 		}
+	}
 
-		juLoaderAdd(loader, asset);
+	// Vertical, rows are whole words so each row the leading edge moves into is checked in one go
+	if (dy != 0) {
+		juTileMapRange(rect->x, rect->x + rect->w, map->x, map->tileWidth, &firstX, &lastX);
+		double edge = dy > 0 ? rect->y + rect->h : rect->y;
+		int step = dy > 0 ? 1 : -1;
+		int from, to;
+		if (dy > 0) {
+			from = (int)ceil(((edge - map->y) / map->tileHeight) - JU_TILE_EPSILON);
+			to = (int)ceil(((edge + dy - map->y) / map->tileHeight) - JU_TILE_EPSILON) - 1;
+		} else {
+			from = (int)floor(((edge - map->y) / map->tileHeight) + JU_TILE_EPSILON) - 1;
+			to = (int)floor(((edge + dy - map->y) / map->tileHeight) + JU_TILE_EPSILON);
+		}
+		for (int row = from; (to - row) * step >= 0 && firstX <= lastX; row += step) {
+			if (juTileMapFindSolid(map, row, firstX, lastX) != -1) {
+				blockedY = true;
+				rect->y = dy > 0 ? map->y + (row * map->tileHeight) - rect->h : map->y + ((row + 1) * map->tileHeight);
+				break;
+			}
+		}
+		if (!blockedY)
+			rect->y += dy;
 	}
 
-	return loader;
+	if (hitX != NULL)
+		*hitX = blockedX;
+	if (hitY != NULL)
+		*hitY = blockedY;
+	return blockedX || blockedY;
 }
 
-VK2DTexture juLoaderGetTexture(JULoader loader, const char *filename) {
-	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_TEXTURE);
-	VK2DTexture out = NULL;
+bool juTileMapRaycast(JUTileMap map, double x1, double y1, double x2, double y2, JUSweptHit *hit) {
+	// Everything is done in tile space, clipped to the map first so the walk starts on a tile in the map
+	double ox = (x1 - map->x) / map->tileWidth;
+	double oy = (y1 - map->y) / map->tileHeight;
+	double dx = (x2 - x1) / map->tileWidth;
+	double dy = (y2 - y1) / map->tileHeight;
+	double tMin = 0;
+	double tMax = 1;
+	if (!juRaycastSlab(ox, dx, 0, map->width, &tMin, &tMax) || !juRaycastSlab(oy, dy, 0, map->height, &tMin, &tMax))
+		return false;
+	double normalX = 0;
+	double normalY = 0;
+	if (tMin > 0) {
+		double enterX = dx != 0 ? ((dx > 0 ? 0 : map->width) - ox) / dx : -INFINITY;
+		double enterY = dy != 0 ? ((dy > 0 ? 0 : map->height) - oy) / dy : -INFINITY;
+		if (enterX > enterY)
+			normalX = dx > 0 ? -1 : 1;
+		else
+			normalY = dy > 0 ? -1 : 1;
+	}
 
-	if (asset != NULL) {
-		out = asset->Asset.tex;
-	} else {
-		juLog("Asset \"%s\" was never loaded", filename);
+	// A ray moving left from exactly on a tile edge starts in the tile to the left, so edges are never counted as hits
+	double px = ox + (dx * tMin);
+	double py = oy + (dy * tMin);
+	int tileX = dx < 0 ? (int)ceil(px) - 1 : (int)floor(px);
+	int tileY = dy < 0 ? (int)ceil(py) - 1 : (int)floor(py);
+	tileX = tileX < 0 ? 0 : (tileX >= map->width ? map->width - 1 : tileX);
+	tileY = tileY < 0 ? 0 : (tileY >= map->height ? map->height - 1 : tileY);
+	int stepX = dx > 0 ? 1 : -1;
+	int stepY = dy > 0 ? 1 : -1;
+	double deltaX = dx != 0 ? fabs(1 / dx) : INFINITY;
+	double deltaY = dy != 0 ? fabs(1 / dy) : INFINITY;
+	double nextX = dx != 0 ? ((tileX + (dx > 0 ? 1 : 0)) - ox) / dx : INFINITY;
+	double nextY = dy != 0 ? ((tileY + (dy > 0 ? 1 : 0)) - oy) / dy : INFINITY;
+	double t = tMin;
+
+	while (t < tMax) {
+		if ((map->tiles[(tileY * map->rowWords) + (tileX / 64)] >> (tileX % 64)) & 1) {
+			if (hit != NULL) {
+				hit->time = t;
+				hit->normalX = normalX;
+				hit->normalY = normalY;
+				hit->target = (tileY * map->width) + tileX;
+			}
+			return true;
+		}
+		if (nextX < nextY) {
+			t = nextX;
+			nextX += deltaX;
+			tileX += stepX;
+			normalX = -stepX;
+			normalY = 0;
+			if (tileX < 0 || tileX >= map->width)
+				break;
+		} else {
+			t = nextY;
+			nextY += deltaY;
+			tileY += stepY;
+			normalX = 0;
+			normalY = -stepY;
+			if (tileY < 0 || tileY >= map->height)
+				break;
+		}
 	}
+	return false;
+}
 
-	return out;
+void juTileMapFree(JUTileMap map) {
+	if (map != NULL) {
+		juFree(map->tiles);
+		juFree(map);
+	}
 }
 
-JUFont juLoaderGetFont(JULoader loader, const char *filename) {
-	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_FONT);
-	JUFont out = NULL;
+/********************** Pathfinding **********************/
 
-	if (asset != NULL) {
-		out = asset->Asset.font;
-	} else {
-		juLog("Asset \"%s\" doesn't exist", filename);
-	}
+// Whether or not a path can go through a tile, anything outside the map is blocked
+static inline bool juPathOpen(JUTileMap map, int x, int y) {
+	return x >= 0 && y >= 0 && x < map->width && y < map->height && ((map->tiles[(y * map->rowWords) + (x / 64)] >> (x % 64)) & 1) == 0;
+}
 
-	return out;
+// Octile distance, exact between tiles in a straight or diagonal line and never more than the real cost otherwise
+static inline float juPathDistance(int x1, int y1, int x2, int y2) {
+	int dx = abs(x2 - x1);
+	int dy = abs(y2 - y1);
+	return (float)(dx + dy) + ((JU_PATH_DIAGONAL_COST - 2) * (float)(dx < dy ? dx : dy));
 }
 
-JUSound juLoaderGetSound(JULoader loader, const char *filename) {
-	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_SOUND);
-	JUSound out = NULL;
+// Adds a tile to an open heap, shared by pathfinders and flow fields
+static void juPathHeapPush(JUPathNode **heap, int *heapSize, int *heapListSize, int32_t tile, float priority) {
+	if (*heapSize == *heapListSize) {
+		*heapListSize += juListGrowth(*heapListSize);
+		*heap = juRealloc(*heap, sizeof(struct JUPathNode) * (*heapListSize));
+	}
+	JUPathNode *nodes = *heap;
+	int i = (*heapSize)++;
+	while (i > 0 && nodes[(i - 1) / 2].priority > priority) {
+		nodes[i] = nodes[(i - 1) / 2];
+		i = (i - 1) / 2;
+	}
+	nodes[i].priority = priority;
+	nodes[i].tile = tile;
+}
 
-	if (asset != NULL) {
-		out = asset->Asset.sound;
-	} else {
-		juLog("Asset \"%s\" doesn't exist", filename);
+// Takes the tile with the lowest priority off an open heap
+static JUPathNode juPathHeapPop(JUPathNode *heap, int *heapSize) {
+	JUPathNode top = heap[0];
+	JUPathNode last = heap[--(*heapSize)];
+	int i = 0;
+	while ((i * 2) + 1 < *heapSize) {
+		int child = (i * 2) + 1;
+		if (child + 1 < *heapSize && heap[child + 1].priority < heap[child].priority)
+			child++;
+		if (heap[child].priority >= last.priority)
+			break;
+		heap[i] = heap[child];
+		i = child;
 	}
+	heap[i] = last;
+	return top;
+}
 
-	return out;
+// Records a better way to a tile and opens it, tiles are opened again if a cheaper way turns up
+static void juPathOpenTile(JUPathfinder pathfinder, int x, int y, int32_t parent, float cost, int goalX, int goalY) {
+	int32_t tile = (y * pathfinder->map->width) + x;
+	if (pathfinder->stamps[tile] == pathfinder->search + 1 || (pathfinder->stamps[tile] == pathfinder->search && pathfinder->costs[tile] <= cost))
+		return;
+	pathfinder->stamps[tile] = pathfinder->search;
+	pathfinder->costs[tile] = cost;
+	pathfinder->parents[tile] = parent;
+	juPathHeapPush(&pathfinder->heap, &pathfinder->heapSize, &pathfinder->heapListSize, tile, cost + juPathDistance(x, y, goalX, goalY));
 }
 
-JUBuffer juLoaderGetBuffer(JULoader loader, const char *filename) {
-	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_BUFFER);
-	JUBuffer out = NULL;
+// Walks in a straight line until it hits something (-1) or finds the goal or a tile with a forced neighbour (a jump point)
+static int32_t juPathJumpStraight(JUTileMap map, int x, int y, int dx, int dy, int32_t goal) {
+	while (juPathOpen(map, x, y)) {
+		int32_t tile = (y * map->width) + x;
+		if (tile == goal)
+			return tile;
+
+		// A wall beside the last tile that opens up beside this one means the path might need to turn here
+		if (dx != 0) {
+			if ((juPathOpen(map, x, y - 1) && !juPathOpen(map, x - dx, y - 1)) || (juPathOpen(map, x, y + 1) && !juPathOpen(map, x - dx, y + 1)))
+				return tile;
+		} else {
+			if ((juPathOpen(map, x - 1, y) && !juPathOpen(map, x - 1, y - dy)) || (juPathOpen(map, x + 1, y) && !juPathOpen(map, x + 1, y - dy)))
+				return tile;
+		}
+		x += dx;
+		y += dy;
+	}
+	return -1;
+}
 
-	if (asset != NULL) {
-		out = asset->Asset.buffer;
-	} else {
-		juLog("Asset \"%s\" doesn't exist", filename);
+// Walks diagonally, stopping anywhere a straight jump from the tile would find something
+static int32_t juPathJump(JUTileMap map, int x, int y, int dx, int dy, int32_t goal) {
+	if (dx == 0 || dy == 0)
+		return juPathJumpStraight(map, x, y, dx, dy, goal);
+	while (juPathOpen(map, x, y)) {
+		int32_t tile = (y * map->width) + x;
+		if (tile == goal || juPathJumpStraight(map, x + dx, y, dx, 0, goal) != -1 || juPathJumpStraight(map, x, y + dy, 0, dy, goal) != -1)
+			return tile;
+		if (!juPathOpen(map, x + dx, y) || !juPathOpen(map, x, y + dy))
+			return -1;
+		x += dx;
+		y += dy;
 	}
+	return -1;
+}
 
-	return out;
+// Directions worth searching from a tile, A* and the first tile of a jump point search try every direction
+static int juPathDirections(JUTileMap map, int x, int y, int dx, int dy, int directions[8][2]) {
+	int count = 0;
+	if (dx == 0 && dy == 0) {
+		// Diagonals only when both of the straight tiles beside them are open so paths don't cut corners
+		for (int ny = -1; ny <= 1; ny++) {
+			for (int nx = -1; nx <= 1; nx++) {
+				if ((nx != 0 || ny != 0) && juPathOpen(map, x + nx, y + ny) && (nx == 0 || ny == 0 || (juPathOpen(map, x + nx, y) && juPathOpen(map, x, y + ny)))) {
+					directions[count][0] = nx;
+					directions[count++][1] = ny;
+				}
+			}
+		}
+	} else if (dx != 0 && dy != 0) {
+		bool horizontal = juPathOpen(map, x + dx, y);
+		bool vertical = juPathOpen(map, x, y + dy);
+		if (vertical) {
+			directions[count][0] = 0;
+			directions[count++][1] = dy;
+		}
+		if (horizontal) {
+			directions[count][0] = dx;
+			directions[count++][1] = 0;
+		}
+		if (horizontal && vertical) {
+			directions[count][0] = dx;
+			directions[count++][1] = dy;
+		}
+	} else {
+		// Straight, carry on plus turn towards either side that is open
+		int sideX = dy != 0;
+		int sideY = dx != 0;
+		bool ahead = juPathOpen(map, x + dx, y + dy);
+		bool side1 = juPathOpen(map, x + sideX, y + sideY);
+		bool side2 = juPathOpen(map, x - sideX, y - sideY);
+		if (ahead) {
+			directions[count][0] = dx;
+			directions[count++][1] = dy;
+			if (side1) {
+				directions[count][0] = dx + sideX;
+				directions[count++][1] = dy + sideY;
+			}
+			if (side2) {
+				directions[count][0] = dx - sideX;
+				directions[count++][1] = dy - sideY;
+			}
+		}
+		if (side1) {
+			directions[count][0] = sideX;
+			directions[count++][1] = sideY;
+		}
+		if (side2) {
+			directions[count][0] = -sideX;
+			directions[count++][1] = -sideY;
+		}
+	}
+	return count;
 }
 
-JUSprite juLoaderGetSprite(JULoader loader, const char *filename) {
-	JUAsset asset = juLoaderGet(loader, filename, JU_ASSET_TYPE_SPRITE);
-	JUSprite out = NULL;
+// Writes the path that ends at goal, filling in the straight runs between jump points, and returns its length
+static int juPathBuild(JUPathfinder pathfinder, int32_t goal, int32_t *path, int size) {
+	int width = pathfinder->map->width;
+	int length = 1;
+	for (int32_t tile = goal; pathfinder->parents[tile] != -1; tile = pathfinder->parents[tile]) {
+		int32_t parent = pathfinder->parents[tile];
+		int dx = abs((tile % width) - (parent % width));
+		int dy = abs((tile / width) - (parent / width));
+		length += dx > dy ? dx : dy;
+	}
 
-	if (asset != NULL) {
-		out = asset->Asset.sprite;
-	} else {
-		juLog("Asset \"%s\" doesn't exist", filename);
+	int i = length - 1;
+	for (int32_t tile = goal; i >= 0; tile = pathfinder->parents[tile]) {
+		int32_t parent = pathfinder->parents[tile];
+		int x = tile % width;
+		int y = tile / width;
+		int stepX = parent == -1 ? 0 : juSign((parent % width) - x);
+		int stepY = parent == -1 ? 0 : juSign((parent / width) - y);
+		do {
+			if (i < size)
+				path[i] = (y * width) + x;
+			i--;
+			x += stepX;
+			y += stepY;
+		} while (parent != -1 && (y * width) + x != parent);
 	}
+	return length;
+}
 
-	return out;
+JUPathfinder juPathfinderCreate(JUTileMap map) {
+	JUPathfinder pathfinder = juMallocZero(sizeof(struct JUPathfinder));
+	int tiles = map->width * map->height;
+	pathfinder->map = map;
+	pathfinder->costs = juMalloc(sizeof(float) * tiles);
+	pathfinder->parents = juMalloc(sizeof(int32_t) * tiles);
+	pathfinder->stamps = juMallocZero(sizeof(uint32_t) * tiles);
+	return pathfinder;
 }
 
-void juLoaderFree(JULoader loader) {
-	if (loader != NULL) {
-		for (int i = 0; i < JU_BUCKET_SIZE; i++) {
-			JUAsset current = loader->assets[i];
-			while (current != NULL) {
-				JUAsset next = current->next;
-				juLoaderAssetFree(current);
-				current = next;
+int juPathfinderFind(JUPathfinder pathfinder, JUPathMode mode, int startX, int startY, int goalX, int goalY, int32_t *path, int size) {
+	JUTileMap map = pathfinder->map;
+	if (!juPathOpen(map, startX, startY) || !juPathOpen(map, goalX, goalY))
+		return -1;
+
+	// New stamp, only when they run out does the stamp array need to be cleared
+	if (pathfinder->search >= UINT32_MAX - 2) {
+		memset(pathfinder->stamps, 0, sizeof(uint32_t) * map->width * map->height);
+		pathfinder->search = 0;
+	}
+	pathfinder->search += 2;
+	pathfinder->heapSize = 0;
+
+	int32_t goal = (goalY * map->width) + goalX;
+	juPathOpenTile(pathfinder, startX, startY, -1, 0, goalX, goalY);
+	while (pathfinder->heapSize > 0) {
+		int32_t tile = juPathHeapPop(pathfinder->heap, &pathfinder->heapSize).tile;
+		if (pathfinder->stamps[tile] != pathfinder->search)
+			continue;
+		if (tile == goal)
+			return juPathBuild(pathfinder, goal, path, size);
+		pathfinder->stamps[tile] = pathfinder->search + 1;
+
+		// Directions come from the way this tile was reached when jumping
+		int x = tile % map->width;
+		int y = tile / map->width;
+		int dx = 0;
+		int dy = 0;
+		int32_t parent = pathfinder->parents[tile];
+		if (mode == JU_PATH_JPS && parent != -1) {
+			dx = juSign(x - (parent % map->width));
+			dy = juSign(y - (parent / map->width));
+		}
+		int directions[8][2];
+		int count = juPathDirections(map, x, y, dx, dy, directions);
+		for (int i = 0; i < count; i++) {
+			int nextX = x + directions[i][0];
+			int nextY = y + directions[i][1];
+			if (mode == JU_PATH_JPS) {
+				int32_t next = juPathJump(map, nextX, nextY, directions[i][0], directions[i][1], goal);
+				if (next == -1)
+					continue;
+				nextX = next % map->width;
+				nextY = next / map->width;
 			}
+			juPathOpenTile(pathfinder, nextX, nextY, tile, pathfinder->costs[tile] + juPathDistance(x, y, nextX, nextY), goalX, goalY);
 		}
-		free(loader->assets);
 	}
+	return -1;
 }
 
-/********************** Sound **********************/
-
-JUSound juSoundLoad(const char *filename) {
-	JUSound sound = juMallocZero(sizeof(struct JUSound));
-	sound->sound = cs_load_wav(filename);
-	return sound;
+// Works through every request a queued pathfinder was given
+static void juPathfinderJob(void *data) {
+	JUPathfinder pathfinder = data;
+	for (int i = pathfinder->requestStart; i < pathfinder->requestCount; i += pathfinder->requestStride) {
+		JUPathRequest *request = &pathfinder->requests[i];
+		request->length = juPathfinderFind(pathfinder, request->mode, request->startX, request->startY, request->goalX, request->goalY, request->path, request->size);
+	}
 }
 
-JUPlayingSound juSoundPlay(JUSound sound, bool loop, float volumeLeft, float volumeRight) {
-	sound->soundInfo = cs_make_def(&sound->sound);
-	sound->soundInfo.looped = loop;
-	sound->soundInfo.volume_left = 0.5;
-	sound->soundInfo.volume_right = 0.5;
-	JUPlayingSound new = {cs_play_sound(gSoundContext, sound->soundInfo)};
-	return new;
+void juPathfinderQueue(JUPathfinder *pathfinders, int pathfinderCount, JUPathRequest *requests, int count, int channel) {
+	// Requests are dealt out in turn so long and short searches even out between the jobs
+	for (int i = 0; i < pathfinderCount && i < count; i++) {
+		pathfinders[i]->requests = requests;
+		pathfinders[i]->requestCount = count;
+		pathfinders[i]->requestStart = i;
+		pathfinders[i]->requestStride = pathfinderCount < count ? pathfinderCount : count;
+		JUJob job = {channel, juPathfinderJob, pathfinders[i]};
+		juJobQueue(job);
+	}
 }
 
-void juSoundUpdate(JUPlayingSound sound, bool loop, float volumeLeft, float volumeRight) {
-	if (sound.playingSound != NULL && cs_is_active(sound.playingSound)) {
-		cs_loop_sound(sound.playingSound, loop);
-		cs_set_volume(sound.playingSound, volumeLeft, volumeRight);
+void juPathfinderFree(JUPathfinder pathfinder) {
+	if (pathfinder != NULL) {
+		juFree(pathfinder->costs);
+		juFree(pathfinder->parents);
+		juFree(pathfinder->stamps);
+		juFree(pathfinder->heap);
+		juFree(pathfinder);
 	}
 }
 
-void juSoundStop(JUPlayingSound sound) {
-	if (sound.playingSound != NULL && cs_is_active(sound.playingSound))
-		cs_stop_sound(sound.playingSound);
-}
+/********************** Flow Fields **********************/
 
-void juSoundFree(JUSound sound) {
-	cs_free_sound(&sound->sound);
-	free(sound);
+// Whether or not a step from one tile to a neighbour is allowed, which is the same both ways
+static inline bool juFlowStepOpen(JUTileMap map, int x, int y, int dx, int dy) {
+	return juPathOpen(map, x + dx, y + dy) && (dx == 0 || dy == 0 || (juPathOpen(map, x + dx, y) && juPathOpen(map, x, y + dy)));
 }
 
-void juSoundStopAll() {
-	cs_stop_all_sounds(gSoundContext);
+// Every step allowed from a tile as a bit per flow field direction, so the 3x3 block is only read once
+static inline uint32_t juFlowSteps(JUTileMap map, int x, int y) {
+	uint32_t open = 0;
+	for (int i = 0; i < 9; i++)
+		open |= (uint32_t)juPathOpen(map, x + (i % 3) - 1, y + (i / 3) - 1) << i;
+
+	// Diagonals need both of the straight steps beside them
+	uint32_t steps = open & 0xAA; // 1, 3, 5 and 7 are the straight steps
+	steps |= open & (open >> 1) & (open >> 3) & 1;                    // 0 needs 1 and 3
+	steps |= open & (open << 1) & (open >> 3) & (1 << 2);             // 2 needs 1 and 5
+	steps |= open & (open >> 1) & (open << 3) & (1 << 6);             // 6 needs 7 and 3
+	steps |= open & (open << 1) & (open << 3) & (1 << 8);             // 8 needs 7 and 5
+	return steps;
 }
 
-/********************** Collisions **********************/
+// Picks the neighbour that is the shortest way to a goal, which is also the tile the distance was worked out from
+static uint8_t juFlowFieldBestDirection(JUFlowField field, int x, int y) {
+	JUTileMap map = field->map;
+	int32_t tile = (y * map->width) + x;
+	uint8_t best = JU_FLOW_NONE;
+	if (field->costs[tile] == 0 || field->costs[tile] == INFINITY)
+		return best;
+	float bestCost = INFINITY;
+	for (uint32_t steps = juFlowSteps(map, x, y); steps != 0; steps &= steps - 1) {
+		int i = juLowestBit(steps);
+		int dx = (i % 3) - 1;
+		int dy = (i / 3) - 1;
+		float cost = field->costs[tile + (dy * map->width) + dx] + (dx != 0 && dy != 0 ? JU_PATH_DIAGONAL_COST : 1);
+		if (cost < bestCost) {
+			bestCost = cost;
+			best = i;
+		}
+	}
+	return best;
+}
 
-double juPointAngle(double x1, double y1, double x2, double y2) {
-	return atan2f(x2 - x1, y2 - y1) - (VK2D_PI / 2);
+// Works out the directions of a band of rows
+static void juFlowFieldDirections(JUFlowField field, int start, int end) {
+	for (int y = start; y < end; y++)
+		for (int x = 0; x < field->map->width; x++)
+			field->directions[(y * field->map->width) + x] = juFlowFieldBestDirection(field, x, y);
 }
 
-double juPointDistance(double x1, double y1, double x2, double y2) {
-	return sqrtf(powf(y2 - y1, 2) + powf(x2 - x1, 2));
+// Job version of juFlowFieldDirections
+static void juFlowFieldJobDirections(void *data) {
+	JUFlowFieldJob *job = data;
+	juFlowFieldDirections(job->field, job->start, job->end);
 }
 
-JUPoint2D juRotatePoint(double x, double y, double originX, double originY, double rotation) {
-	// Applies a 2D rotation matrix
-	JUPoint2D point = {x - originX, y - originY};
-	JUPoint2D final;
-	final.x = (point.x * cos(-rotation)) - (point.y * sin(-rotation));
-	final.y = (point.x * sin(-rotation)) + (point.y * cos(-rotation));
-	final.x += originX;
-	final.y += originY;
-	return final;
+// Lowers a tile's distance if the new one is shorter, returning whether or not it did
+static inline bool juFlowFieldLower(JUFlowField field, int32_t tile, float cost) {
+	if (cost >= field->costs[tile])
+		return false;
+	field->costs[tile] = cost;
+	juPathHeapPush(&field->heap, &field->heapSize, &field->heapListSize, tile, cost);
+	return true;
 }
 
-bool juRectangleCollision(JURectangle *r1, JURectangle *r2) {
-	return (r1->y + r1->h > r2->y && r1->y < r2->y + r2->h && r1->x + r1->w > r2->x && r1->x < r2->x + r2->w);
+// Adds a tile to the list of changed tiles
+static void juFlowFieldChanged(JUFlowField field, int32_t tile) {
+	if (field->changedCount == field->changedListSize) {
+		field->changedListSize += juListGrowth(field->changedListSize);
+		field->changed = juRealloc(field->changed, sizeof(int32_t) * field->changedListSize);
+	}
+	field->changed[field->changedCount++] = tile;
 }
 
-bool juRotatedRectangleCollision(JURectangle *r1, double rot1, double originX1, double originY1, JURectangle *r2, double rot2, double originX2, double originY2) {
-	// Check if one of the vertices of either rectangle is in the other rectangle
-	return false; // TODO: This
+// Spreads distances out from everything in the heap until it is empty (Dijkstra), optionally recording what changed
+static void juFlowFieldSpread(JUFlowField field, bool record) {
+	JUTileMap map = field->map;
+	while (field->heapSize > 0) {
+		JUPathNode node = juPathHeapPop(field->heap, &field->heapSize);
+		if (node.priority > field->costs[node.tile])
+			continue;
+		for (uint32_t steps = juFlowSteps(map, node.tile % map->width, node.tile / map->width); steps != 0; steps &= steps - 1) {
+			int i = juLowestBit(steps);
+			int dx = (i % 3) - 1;
+			int dy = (i / 3) - 1;
+			int32_t next = node.tile + (dy * map->width) + dx;
+			if (juFlowFieldLower(field, next, node.priority + (dx != 0 && dy != 0 ? JU_PATH_DIAGONAL_COST : 1)) && record)
+				juFlowFieldChanged(field, next);
+		}
+	}
 }
 
-bool juCircleCollision(JUCircle *c1, JUCircle *c2) {
-	return juPointDistance(c1->x, c1->y, c2->x, c2->y) < c1->r + c2->r;
+// Works out the integration field from scratch on this thread
+static void juFlowFieldIntegrate(JUFlowField field) {
+	int tiles = field->map->width * field->map->height;
+	for (int i = 0; i < tiles; i++)
+		field->costs[i] = INFINITY;
+	field->heapSize = 0;
+	for (int i = 0; i < field->goalCount; i++)
+		if (juPathOpen(field->map, field->goals[i] % field->map->width, field->goals[i] / field->map->width))
+			juFlowFieldLower(field, field->goals[i], 0);
+	juFlowFieldSpread(field, false);
 }
 
-bool juPointInRectangle(JURectangle *rect, double x, double y) {
-	return (x >= rect->x && x <= rect->x + rect->w && y >= rect->y && y <= rect->y + rect->h);
+// Builds a whole field in one job
+static void juFlowFieldJobBuild(void *data) {
+	JUFlowField field = data;
+	juFlowFieldIntegrate(field);
+	juFlowFieldDirections(field, 0, field->map->height);
 }
 
-bool juPointInRotatedRectangle(JURectangle *rect, double rot, double originX, double originY, double x, double y) {
-	// Here we work in reverse so instead of rotating the rectangle we rotate the point we are checking in reverse about the origin
-	double distance = juPointDistance(originX + rect->x, originY + rect->y, x, y);
-	double angle = juPointAngle(originX + rect->x, originY + rect->y, x, y);
-	double newX = rect->x + juCastX(distance, angle + rot);
-	double newY = rect->y + juCastY(distance, angle + rot);
-	return juPointInRectangle(rect, newX, newY);
+JUFlowField juFlowFieldCreate(JUTileMap map) {
+	JUFlowField field = juMallocZero(sizeof(struct JUFlowField));
+	int tiles = map->width * map->height;
+	field->map = map;
+	field->costs = juMalloc(sizeof(float) * tiles);
+	field->directions = juMalloc(tiles);
+	for (int i = 0; i < tiles; i++)
+		field->costs[i] = INFINITY;
+	memset(field->directions, JU_FLOW_NONE, tiles);
+	return field;
 }
 
-bool juPointInCircle(JUCircle *circle, double x, double y) {
-	return juPointDistance(circle->x, circle->y, x, y) <= circle->r;
+void juFlowFieldSetGoal(JUFlowField field, int x, int y) {
+	field->goalCount = 0;
+	juFlowFieldAddGoal(field, x, y);
 }
 
-double juLerp(double percent, double start, double stop) {
-	return start + ((stop - start) * percent);
+void juFlowFieldAddGoal(JUFlowField field, int x, int y) {
+	if (x < 0 || y < 0 || x >= field->map->width || y >= field->map->height)
+		return;
+	if (field->goalCount == field->goalListSize) {
+		field->goalListSize += juListGrowth(field->goalListSize);
+		field->goals = juRealloc(field->goals, sizeof(int32_t) * field->goalListSize);
+	}
+	field->goals[field->goalCount++] = (y * field->map->width) + x;
 }
 
-double juSerp(double percent, double start, double stop) {
-	return start + ((stop - start) * ((sin((percent * VK2D_PI) - (VK2D_PI / 2)) / 2) + 0.5));
+void juFlowFieldBuild(JUFlowField field, int channel) {
+	juFlowFieldIntegrate(field);
+
+	// Every tile's direction only reads distances so the rows can be split up freely
+	int height = field->map->height;
+	if (field->map->width * height >= JU_FLOW_JOB_SIZE && gJobSystem.threadCount > 1) {
+		int jobs = gJobSystem.threadCount;
+		int size = (height + jobs - 1) / jobs;
+		if (jobs > field->jobListSize) {
+			field->jobs = juRealloc(field->jobs, sizeof(struct JUFlowFieldJob) * jobs);
+			field->jobListSize = jobs;
+		}
+		for (int i = 0; i < jobs; i++) {
+			field->jobs[i].field = field;
+			field->jobs[i].start = size * i < height ? size * i : height;
+			field->jobs[i].end = size * (i + 1) < height ? size * (i + 1) : height;
+			JUJob job = {channel, juFlowFieldJobDirections, &field->jobs[i]};
+			juJobQueue(job);
+		}
+		juJobWaitChannel(channel);
+	} else {
+		juFlowFieldDirections(field, 0, height);
+	}
 }
 
-double juCastX(double length, double angle) {
-	return length * cos(-angle);
+void juFlowFieldQueue(JUFlowField *fields, int count, int channel) {
+	for (int i = 0; i < count; i++) {
+		JUJob job = {channel, juFlowFieldJobBuild, fields[i]};
+		juJobQueue(job);
+	}
 }
 
-double juCastY(double length, double angle) {
-	return length * sin(-angle);
+void juFlowFieldUpdate(JUFlowField field, int x, int y, int w, int h) {
+	// Steps can only have opened or closed if they touch the changed tiles, so one tile around them is looked at
+	JUTileMap map = field->map;
+	int left = x - 1 > 0 ? x - 1 : 0;
+	int top = y - 1 > 0 ? y - 1 : 0;
+	int right = x + w + 1 < map->width ? x + w + 1 : map->width;
+	int bottom = y + h + 1 < map->height ? y + h + 1 : map->height;
+	field->changedCount = 0;
+	field->heapSize = 0;
+
+	// Tiles that are now walls or whose step is now blocked lose their route
+	for (int ty = top; ty < bottom; ty++) {
+		for (int tx = left; tx < right; tx++) {
+			int32_t tile = (ty * map->width) + tx;
+			uint8_t direction = field->directions[tile];
+			if (field->costs[tile] != INFINITY && (!juPathOpen(map, tx, ty) || (direction != JU_FLOW_NONE && !juFlowStepOpen(map, tx, ty, (direction % 3) - 1, (direction / 3) - 1)))) {
+				field->costs[tile] = INFINITY;
+				juFlowFieldChanged(field, tile);
+			}
+		}
+	}
+
+	// So does everything that was stepping towards them
+	for (int i = 0; i < field->changedCount; i++) {
+		int32_t lost = field->changed[i];
+		int lostX = lost % map->width;
+		int lostY = lost / map->width;
+		field->directions[lost] = JU_FLOW_NONE;
+		for (int j = 0; j < 9; j++) {
+			int dx = (j % 3) - 1;
+			int dy = (j / 3) - 1;
+			int32_t neighbour = lost + (dy * map->width) + dx;
+			if (j != JU_FLOW_NONE && juPathOpen(map, lostX + dx, lostY + dy) && field->costs[neighbour] != INFINITY && field->directions[neighbour] == 8 - j) {
+				field->costs[neighbour] = INFINITY;
+				juFlowFieldChanged(field, neighbour);
+			}
+		}
+	}
+
+	// Each of those starts again from its best neighbour that kept its route
+	for (int i = 0; i < field->changedCount; i++) {
+		int32_t lost = field->changed[i];
+		if (!juPathOpen(map, lost % map->width, lost / map->width))
+			continue;
+		for (uint32_t steps = juFlowSteps(map, lost % map->width, lost / map->width); steps != 0; steps &= steps - 1) {
+			int j = juLowestBit(steps);
+			int dx = (j % 3) - 1;
+			int dy = (j / 3) - 1;
+			juFlowFieldLower(field, lost, field->costs[lost + (dy * map->width) + dx] + (dx != 0 && dy != 0 ? JU_PATH_DIAGONAL_COST : 1));
+		}
+	}
+
+	// Opened tiles and steps can only make routes shorter, so the tiles around them spread their distances again
+	for (int i = 0; i < field->goalCount; i++) {
+		int goalX = field->goals[i] % map->width;
+		int goalY = field->goals[i] / map->width;
+		if (goalX >= left && goalY >= top && goalX < right && goalY < bottom && juPathOpen(map, goalX, goalY) && juFlowFieldLower(field, field->goals[i], 0))
+			juFlowFieldChanged(field, field->goals[i]);
+	}
+	for (int ty = top; ty < bottom; ty++)
+		for (int tx = left; tx < right; tx++)
+			if (field->costs[(ty * map->width) + tx] != INFINITY)
+				juPathHeapPush(&field->heap, &field->heapSize, &field->heapListSize, (ty * map->width) + tx, field->costs[(ty * map->width) + tx]);
+	juFlowFieldSpread(field, true);
+
+	// Directions only change around tiles whose distance or steps did
+	for (int ty = top; ty < bottom; ty++)
+		for (int tx = left; tx < right; tx++)
+			field->directions[(ty * map->width) + tx] = juFlowFieldBestDirection(field, tx, ty);
+	for (int i = 0; i < field->changedCount; i++) {
+		int changedX = field->changed[i] % map->width;
+		int changedY = field->changed[i] / map->width;
+		for (int ny = changedY - 1; ny <= changedY + 1; ny++)
+			for (int nx = changedX - 1; nx <= changedX + 1; nx++)
+				if (nx >= 0 && ny >= 0 && nx < map->width && ny < map->height)
+					field->directions[(ny * map->width) + nx] = juFlowFieldBestDirection(field, nx, ny);
+	}
 }
 
-double juSign(double x) {
-	return x < 0 ? -1 : (x > 0 ? 1 : 0);
+bool juFlowFieldSample(JUFlowField field, double x, double y, double *directionX, double *directionY) {
+	JUTileMap map = field->map;
+	double tileX = floor((x - map->x) / map->tileWidth);
+	double tileY = floor((y - map->y) / map->tileHeight);
+	uint8_t direction = JU_FLOW_NONE;
+	if (tileX >= 0 && tileY >= 0 && tileX < map->width && tileY < map->height)
+		direction = field->directions[((int)tileY * map->width) + (int)tileX];
+	*directionX = JU_FLOW_DIRECTIONS[direction][0];
+	*directionY = JU_FLOW_DIRECTIONS[direction][1];
+	return direction != JU_FLOW_NONE;
 }
 
-double juSubToZero(double x, double y) {
-	if (x < 0) {
-		return x + y > 0 ? 0 : x + y;
-	} else if (x > 0) {
-		return x - y < 0 ? 0 : x - y;
-	}
-	return x;
+double juFlowFieldDistance(JUFlowField field, int x, int y) {
+	if (x < 0 || y < 0 || x >= field->map->width || y >= field->map->height || field->costs[(y * field->map->width) + x] == INFINITY)
+		return -1;
+	return field->costs[(y * field->map->width) + x];
 }
 
-double juClamp(double x, double min, double max) {
-	return x < min ? min : (x > max ? max : x);
+void juFlowFieldFree(JUFlowField field) {
+	if (field != NULL) {
+		juFree(field->costs);
+		juFree(field->directions);
+		juFree(field->goals);
+		juFree(field->heap);
+		juFree(field->changed);
+		juFree(field->jobs);
+		juFree(field);
+	}
 }
 
 /********************** File I/O **********************/
@@ -1566,6 +6150,7 @@ bool juKeyboardGetKeyReleased(SDL_Scancode key) {
 	return !gKeyboardState[key] && gKeyboardPreviousState[key];
 }
 
+#ifndef JU_HEADLESS
 /********************** Animations **********************/
 JUSprite juSpriteCreate(const char *filename, float x, float y, float w, float h, float delay, int frames) {
 	JUSprite spr = juMalloc(sizeof(struct JUSprite));
@@ -1680,4 +6265,5 @@ void juSpriteFree(JUSprite spr) {
 			vk2dTextureFree(spr->Internal.tex);
 		free(spr);
 	}
-}
\ No newline at end of file
+}
+#endif // JU_HEADLESS
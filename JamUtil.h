@@ -3,8 +3,17 @@
 /// \brief A small collection of tools for quick game-dev with Vulkan2D
 #pragma once
 #include <stdbool.h>
+#ifdef JU_HEADLESS
+// Headless builds (benchmarks, servers) only need SDL and leave out everything that touches VK2D or audio
+#include <math.h>
+#include <SDL2/SDL.h>
+#ifndef VK2D_PI
+#define VK2D_PI 3.14159265358979323846
+#endif
+#else
 #include <VK2D/VK2D.h>
 #include "cute_sound.h"
+#endif // JU_HEADLESS
 
 /********************** Typedefs **********************/
 typedef struct JUCharacter JUCharacter;
@@ -16,6 +25,14 @@ typedef struct JUPlayingSound JUPlayingSound;
 typedef struct JURectangle JURectangle;
 typedef struct JUPoint2D JUPoint2D;
 typedef struct JUCircle JUCircle;
+typedef struct JUVec2f JUVec2f;
+typedef struct JURectanglef JURectanglef;
+typedef struct JUCirclef JUCirclef;
+typedef struct JURectangleBatch JURectangleBatch;
+typedef struct JUCircleBatch JUCircleBatch;
+typedef struct JUPointBatch JUPointBatch;
+typedef struct JUOrientedRectangle JUOrientedRectangle;
+typedef struct JUSweptHit JUSweptHit;
 typedef struct JUData JUData;
 typedef struct JUSave *JUSave;
 typedef struct JUBuffer *JUBuffer;
@@ -26,11 +43,28 @@ typedef struct JUEntity JUEntity;
 typedef int32_t JUEntityID;
 typedef int32_t JUComponentID;   ///< Points to a specific component for a given entity
 typedef int32_t JUComponent;     ///< Points to a component array that contains all of that type of component
+typedef int32_t JUResource;      ///< Points to a single global piece of ECS data (camera, input, etc)
+typedef int32_t JURegion;        ///< A group of entities that can be streamed to and from disk
 typedef void *JUComponentVector; ///< Vector of all of a given component
 typedef struct JUSystem JUSystem;
+typedef struct JUSystemStats JUSystemStats;
+typedef struct JUPrefab *JUPrefab;
+typedef struct JUTransform JUTransform;
+typedef struct JUECSQuery *JUECSQuery;
+typedef struct JUPrefabOverride JUPrefabOverride;
+typedef struct JUECSStats JUECSStats;
 typedef uint64_t JUEntityType; ///< Type generated by the ECS, only works when there are less than 65 components
 typedef _Atomic int32_t JUECSLock; ///< For locking states when multiple systems need the current
 typedef struct JUClock JUClock;
+typedef struct JUSpatialGrid *JUSpatialGrid;
+typedef int32_t JUProxy; ///< A shape stored in a spatial grid or AABB tree
+typedef struct JUAABBTree *JUAABBTree;
+typedef struct JUSweepAndPrune *JUSweepAndPrune;
+typedef struct JUTileMap *JUTileMap;
+typedef struct JUPathfinder *JUPathfinder;
+typedef struct JUPathRequest JUPathRequest;
+typedef struct JUFlowField *JUFlowField;
+typedef uint64_t JUFrame; ///< ECS frame number, incremented every time state is copied
 
 /********************** Enums **********************/
 
@@ -57,6 +91,14 @@ typedef enum {
 	JU_DATA_TYPE_MAX = 7,
 } JUDataType;
 
+/// \brief Where a streaming region's entities currently are
+typedef enum {
+	JU_REGION_LOADED = 0,    ///< Entities are in the ECS
+	JU_REGION_UNLOADING = 1, ///< Entities are being despawned and written to disk
+	JU_REGION_UNLOADED = 2,  ///< Entities are only on disk
+	JU_REGION_LOADING = 3,   ///< Entities are being read from disk and spawned
+} JURegionState;
+
 /********************** Constants **********************/
 
 ///< Entity that doesn't exist
@@ -77,6 +119,12 @@ extern const int32_t JU_DISABLED_LOCK;
 ///< Invalid entity type
 extern const JUEntityType JU_INVALID_TYPE;
 
+///< Entity isn't in any streaming region
+extern const JURegion JU_NO_REGION;
+
+///< No proxy, returned by raycasts that don't hit anything
+extern const JUProxy JU_NO_PROXY;
+
 /********************** Top-Level **********************/
 
 /// \brief Initializes everything, make sure to call this before anything else
@@ -105,18 +153,44 @@ double juTime();
 
 /// \brief An entity in the ECS system (the user only keeps track of an entity id)
 struct JUEntity {
-	JUComponentID *components;  ///< A list specifying where this entity's component is or if it has this component for each component
+	JUComponentID *components;  ///< A list specifying where this entity's component is or if it has this component for each non-sparse component (in order, skipping sparse components)
 	JUEntityType type;          ///< Type of entity this is, automatically generated by the ECS
+	JUEntityID parent;          ///< Parent entity in the transform hierarchy (see `juECSSetParent`), `JU_INVALID_ENTITY` if it has none
+	JURegion region;            ///< Streaming region the entity belongs to (see `juECSRegionAdd`), `JU_NO_REGION` if it has none
 	_Atomic bool exists;        ///< Whether or not this entity was destroyed
 	_Atomic bool queueDeletion; ///< If true, this entity will be wiped during the copy operation
 };
 
+/// \brief How much the ECS lets simulation overlap with the main thread, see `juECSSetPipeline`
+typedef enum {
+	JU_PIPELINE_SERIAL = 0,     ///< `juECSCopyState` waits for every system before queueing the copy (default)
+	JU_PIPELINE_OVERLAPPED = 1, ///< `juECSCopyState` only waits for render systems, the copy runs once simulation is done
+} JUPipelineMode;
+
 /// \brief Information needed to operate a system
 struct JUSystem {
 	JUComponent *requiredComponents;   ///< List of all required components for this system to run
 	int requiredComponentCount;        ///< How many components are required
 	void (*system)(JUEntityID entity); ///< System function
 	int id;                            ///< For internal use, will be overwritten
+	bool render;                       ///< True for systems that only draw (they must only read previous frame components)
+};
+
+/// \brief Timing information for a single system over a single frame
+struct JUSystemStats {
+	double time;         ///< Wall time in seconds the system took to process every entity (including lock waits)
+	double lockWaitTime; ///< Time in seconds the system spent spinning in `juECSLockWait`
+	int entities;        ///< Number of entities the system was run on
+};
+
+/// \brief Statistics for the last complete ECS frame, see `juECSGetStats`
+struct JUECSStats {
+	JUFrame frame;          ///< Frame these stats were recorded on
+	int systemCount;        ///< Number of systems in `systems`
+	JUSystemStats *systems; ///< Stats for each system, in the same order the systems were added
+	double copyTime;        ///< Time in seconds the copy job took
+	double waitTime;        ///< Time in seconds spent (across all threads) in `juJobWaitChannel` since the last copy
+	int entities;           ///< Number of entities that existed after the copy
 };
 
 /// \brief Adds all components to the ECS (you may only call this once)
@@ -124,6 +198,28 @@ struct JUSystem {
 /// \param componentCount Number of components in the array
 void juECSAddComponents(const size_t *componentSizes, int componentCount);
 
+/// \brief Marks components as sparse, call this right after `juECSAddComponents` before any entities are added
+/// \param components Components that should be sparse
+/// \param componentCount Number of components in the array
+///
+/// Normally every entity has a slot for every component, which is wasteful for components that
+/// only a handful of entities have (tags, rare status effects, etc). Sparse components are packed
+/// tightly into their own list and looked up through pages that are only allocated as needed, so
+/// their memory scales with how many entities actually have them. Systems that require a sparse
+/// component only visit the entities in the smallest sparse list they require instead of every entity.
+/// Sparse components do not appear in `JUEntity::components`.
+void juECSSetSparseComponents(const JUComponent *components, int componentCount);
+
+/// \brief Adds singleton resources to the ECS, call this once before enabling the history (if you use it)
+/// \param resourceSizes Array of each resource's size in bytes
+/// \param resourceCount Number of resources in the array
+///
+/// Resources are global pieces of data (the camera, an input snapshot, physics settings, etc) that
+/// would otherwise be a dummy entity. Like components they have a current and a previous frame copy,
+/// are copied during `juECSCopyState` and are part of the history, but they never move and need no
+/// entity lookup. Resources start zeroed.
+void juECSAddResources(const size_t *resourceSizes, int resourceCount);
+
 /// \brief Adds all systems to the ECS (only call once)
 /// \param systems Array of systems (must persist throughout program, use constants)
 /// \param systemCount Number of systems
@@ -138,6 +234,47 @@ void juECSAddSystems(JUSystem *systems, int systemCount);
 /// \param componentCount Number of components this entity has
 JUEntityID juECSAddEntity(const JUComponent *components, JUComponentVector *defaultStates, int componentCount);
 
+/// \brief A precomputed entity template for quickly spawning many identical entities
+struct JUPrefab {
+	JUComponent *components; ///< Components every instance has
+	int componentCount;      ///< Number of components
+	JUEntityType type;       ///< Type every instance will have
+	size_t *offsets;         ///< Where each component is in the defaults blob
+	void *defaults;          ///< Every component's default state laid out exactly as they are stored in the ECS
+	size_t size;             ///< Size of the defaults blob in bytes
+};
+
+/// \brief Overrides one field in a component for each entity instantiated from a prefab
+struct JUPrefabOverride {
+	JUComponent component; ///< Component the field is in (the prefab must have this component)
+	size_t offset;         ///< Offset of the field in the component (use `offsetof`)
+	size_t size;           ///< Size of the field in bytes
+	const void *values;    ///< Values for the field, one per entity instantiated
+	size_t stride;         ///< Bytes between each value in `values`, 0 means the values are tightly packed
+};
+
+/// \brief Creates a prefab that `juECSInstantiate` can stamp entities out of
+/// \param components List of components instances will have
+/// \param defaultStates Default state of each component (copied into the prefab, may be NULL for all zero)
+/// \param componentCount Number of components
+///
+/// Prefabs are built after `juECSAddComponents` and must be freed with `juECSFreePrefab`.
+JUPrefab juECSCreatePrefab(const JUComponent *components, JUComponentVector *defaultStates, int componentCount);
+
+/// \brief Creates `count` entities from a prefab, optionally storing their ids in `entities`
+///
+/// This only locks entity creation once and each component is set up with a single copy per
+/// component list, so it is much faster than calling `juECSAddEntity` in a loop.
+void juECSInstantiate(JUPrefab prefab, int count, JUEntityID *entities);
+
+/// \brief Same as `juECSInstantiate` but overrides some fields per instance (positions for example)
+/// \param overrides List of fields to override, each override's `values` must have `count` values
+/// \param overrideCount Number of overrides
+void juECSInstantiateWith(JUPrefab prefab, int count, const JUPrefabOverride *overrides, int overrideCount, JUEntityID *entities);
+
+/// \brief Frees a prefab (entities created from it are unaffected)
+void juECSFreePrefab(JUPrefab prefab);
+
 /// \brief Returns true if a system has finished processing this frame, false otherwise
 /// \warning This function only has meaning between the functions `juECSRunSystems` and `juECSCopyState`
 bool juECSIsSystemFinished(int systemIndex);
@@ -146,7 +283,21 @@ bool juECSIsSystemFinished(int systemIndex);
 /// \warning This function only has meaning between the functions `juECSRunSystems` and `juECSCopyState`
 void juECSWaitSystemFinished(int systemIndex);
 
+/// \brief Gets this frame's copy of a resource, the pointer never changes
+/// \warning Like current components, only one system should write to a resource at a time
+void *juECSGetResource(JUResource resource);
+
+/// \brief Gets the read-only previous frame copy of a resource, the pointer never changes
+const void *juECSGetPreviousResource(JUResource resource);
+
 /// \brief Grabs a component given a component type and id
+///
+/// Components are stored in fixed-size chunks that never move, so the pointer stays valid for
+/// the rest of the frame even if other systems add entities. Don't hold onto it across
+/// `juECSCopyState` calls though, compaction may move the component during the copy.
+///
+/// This counts as writing to the component for change detection (see `juECSGetChanged`), so use
+/// `juECSGetPreviousComponent` for components you only read.
 void *juECSGetComponent(JUComponent component, JUEntityID entity);
 
 /// \brief Grabs a component from the read-only previous frame components given a component type and id
@@ -156,8 +307,28 @@ const void *juECSGetPreviousComponent(JUComponent component, JUEntityID entity);
 void juECSRunSystems();
 
 /// \brief Copies all current frame data into the previous frame's data for next frame (as a job, waits until all the system jobs are finished first)
+///
+/// With `JU_PIPELINE_OVERLAPPED` this only waits for render systems, the copy is queued by whichever system finishes last.
 void juECSCopyState();
 
+/// \brief Sets up pipelined frames, where simulation systems for frame N+1 run while the main thread submits frame N
+/// \param mode Latency knob, `JU_PIPELINE_OVERLAPPED` lets the main thread end the frame (present, poll events,
+/// start the next frame) while simulation systems are still running instead of waiting for them in `juECSCopyState`
+/// \param renderFirst Throughput knob, if true render systems are queued before simulation systems so the
+/// main thread gets its draw calls as soon as possible; if false simulation gets the workers first
+///
+/// Render systems (`JUSystem::render`) already only read the previous frame, so they can draw frame N while the
+/// simulation systems write frame N+1. The next `juECSRunSystems` still waits for the copy, so at most one frame
+/// of simulation is ever in flight. Render systems are skipped while resimulating the history.
+/// \warning With `JU_PIPELINE_OVERLAPPED` simulation systems can still be running while the main thread calls
+/// `juUpdate` and polls events, so they must not read the keyboard (or anything else the main thread updates).
+/// Snapshot input into a resource after `juJobWaitChannel(JU_JOB_CHANNEL_COPY)` (which waits for the last frame's
+/// systems and copy) and have systems read that instead.
+void juECSSetPipeline(JUPipelineMode mode, bool renderFirst);
+
+/// \brief Waits until every render system is done this frame, after which the main thread may use VK2D again
+void juECSWaitRenderFinished();
+
 /// \brief Increments an ECS lock to signal to the next system it may proceed
 void juECSLockNext(JUECSLock *lock);
 
@@ -189,6 +360,47 @@ JUEntity *juECSEntityIterNext();
 /// \brief Call this when you're done iterating through entities
 void juECSEntityIterEnd();
 
+/// \brief Iterates over every entity that has a set of components, a chunk of entities at a time
+struct JUECSQuery {
+	JUComponent *components;    ///< Components an entity must have to be in the query
+	int componentCount;         ///< Number of components
+	JUEntityType mask;          ///< Type every entity in the query shares (only used with less than 64 components)
+	JUComponent sparse;         ///< Smallest required sparse component (only its entities are walked), -1 if there are none
+	int position;               ///< Next batch to collect
+	int batchCount;             ///< Number of batches in the current walk
+	JUEntityID *batch;          ///< Entities in the batch last returned by `juECSQueryNext`
+	void (*job)(const JUEntityID *entities, int count, void *data); ///< Function `juECSQueryParallel` hands batches to
+	void *data;                 ///< Data passed to `job`
+	struct JUECSQueryJob *jobs; ///< Job data for each batch of a parallel walk
+	int jobListSize;            ///< Actual size of the job list
+};
+
+/// \brief Creates a query for every entity that has all the given components
+///
+/// Queries are meant to be created once (in setup) and walked as many times as you like.
+JUECSQuery juECSQueryCreate(const JUComponent *components, int componentCount);
+
+/// \brief Starts walking a query, call `juECSQueryNext` until it returns 0 to get each batch
+///
+/// Unlike `juECSEntityIterStart` this doesn't lock entity creation, so the walk can be used from
+/// systems while others add entities. Entities added after the walk started may or may not be visited.
+void juECSQueryStart(JUECSQuery query);
+
+/// \brief Gets the next batch of entities in a query
+/// \param entities Will be pointed to the batch's entities, only valid until the next call
+/// \return Returns the number of entities in the batch, or 0 once every entity has been visited
+int juECSQueryNext(JUECSQuery query, const JUEntityID **entities);
+
+/// \brief Walks a query in parallel, handing each batch to a job on a given channel
+/// \param channel Job channel the batches are queued on, wait on it with `juJobWaitChannel` before using the query again
+/// \param job Function called with each batch of entities, from any worker thread
+/// \param data Data passed to each call of `job`
+/// \warning Don't use the ECS job channels here, and don't wait on the channel from a job on the same channel
+void juECSQueryParallel(JUECSQuery query, int channel, void (*job)(const JUEntityID *entities, int count, void *data), void *data);
+
+/// \brief Frees a query
+void juECSQueryFree(JUECSQuery query);
+
 /// \brief Gets an entity type (only works if less than 65 components in the ECS) - if the entity doesn't exist, it will return `JU_INVALID_TYPE`
 JUEntityType juECSGetEntityType(JUEntityID entity);
 
@@ -207,6 +419,167 @@ void juECSDestroyAll();
 /// \brief Returns true if the entity has at least those components
 bool juECSEntityHasComponents(JUEntityID entity, JUComponent *components, int componentCount);
 
+/// \brief Sets how many components may be moved to fill holes during each `juECSCopyState`, 0 (the default) disables it
+///
+/// Destroying entities leaves inactive holes in component lists that systems and copies still
+/// walk over. With a budget, every copy moves up to that many live components from the end of
+/// each list into the holes near the front and frees chunks at the end once they are empty, so
+/// the cost of compacting after heavy churn is spread out over a few frames.
+void juECSSetCompactionBudget(int moves);
+
+/// \brief Compacts and shrinks every component list right away (call it between frames, after a level change for example)
+void juECSCompactNow();
+
+/// \brief Makes the ECS record which entities had any of the given components added, removed or changed
+///
+/// Events are recorded over a frame and published during `juECSCopyState`, so systems see
+/// what happened during the previous frame. Untracked components never have any events.
+void juECSTrackComponents(const JUComponent *components, int componentCount);
+
+/// \brief Gets every entity that was given a component last frame
+/// \param entities Will be pointed to the list of entities, valid until the next `juECSCopyState`
+/// \return Returns the number of entities in the list
+int juECSGetAdded(JUComponent component, const JUEntityID **entities);
+
+/// \brief Gets every entity that was destroyed with a component last frame (the ids may already be reused)
+int juECSGetRemoved(JUComponent component, const JUEntityID **entities);
+
+/// \brief Gets every entity that had a component written to through `juECSGetComponent` last frame
+int juECSGetChanged(JUComponent component, const JUEntityID **entities);
+
+/// \brief A 2D transform that the ECS can propagate down a hierarchy of entities (see `juECSTransformEnable`)
+struct JUTransform {
+	double x;             ///< x position relative to the parent (or the world for entities without a parent)
+	double y;             ///< y position relative to the parent
+	double rotation;      ///< Rotation in radians relative to the parent
+	double worldX;        ///< World x position, calculated by the ECS during `juECSCopyState`
+	double worldY;        ///< World y position, calculated by the ECS during `juECSCopyState`
+	double worldRotation; ///< World rotation, calculated by the ECS during `juECSCopyState`
+};
+
+/// \brief Makes the ECS calculate world transforms for every entity with a given component
+/// \param component Component that starts with a `JUTransform`
+///
+/// During `juECSCopyState` (before the current frame is copied to the previous frame) world
+/// transforms are calculated one level of the hierarchy at a time, roots first. Each level is
+/// stored as a flat list sorted by depth so it is a single linear sweep, and wide levels are
+/// split between the worker threads.
+void juECSTransformEnable(JUComponent component);
+
+/// \brief Makes an entity a child of another, its transform becomes relative to the parent's
+/// \param child Entity to parent
+/// \param parent New parent, or `JU_INVALID_ENTITY` to make the child a root
+/// \return Returns false if either entity doesn't exist or the parent is a descendant of the child
+///
+/// When a parent is destroyed its children become roots and keep their last world transform.
+bool juECSSetParent(JUEntityID child, JUEntityID parent);
+
+/// \brief Gets an entity's parent, `JU_INVALID_ENTITY` if it has none
+JUEntityID juECSGetParent(JUEntityID entity);
+
+/// \brief Makes the ECS keep a spatial hash of every entity with a given component
+/// \param component Component with each entity's position/extent
+/// \param cellSize Size of each cell in the hash, something around the size of a typical entity works well
+/// \param bounds Function that gets bounds from an instance of the component, if NULL the component must start with a `JURectangle`
+///
+/// The hash is updated during `juECSCopyState` so it always matches the previous frame's components.
+/// Only components added or fetched through `juECSGetComponent` that frame are looked at, and
+/// entities only move buckets when the cells they cover change.
+void juECSSpatialEnable(JUComponent component, double cellSize, void (*bounds)(const void *component, JURectangle *bounds));
+
+/// \brief Finds every entity whose bounds on the previous frame overlap an area
+/// \param area Area to check
+/// \param entities Output list that gets up to `size` entities
+/// \param size Size of the output list
+/// \return Returns the number of entities in the area, which may be more than `size`
+///
+/// This reads the hash without any locks, so it's safe to call from any number of systems at once
+/// (but not during `juECSCopyState`). Use `juRectangleCollision` or similar for exact checks.
+int juECSSpatialQuery(const JURectangle *area, JUEntityID *entities, int size);
+
+/// \brief Sets up streaming regions, groups of entities that are saved to disk and despawned (or loaded and spawned) in the background
+/// \param channel Job channel file I/O is done on, it shouldn't be used for anything else
+/// \param spawnBudget Maximum number of entities spawned from loaded regions each `juECSCopyState`, 0 for no limit
+/// \param despawnBudget Maximum number of entities written out and despawned from unloading regions each `juECSCopyState`, 0 for no limit
+///
+/// Entities are gathered and spawned during the copy, spread over as many frames as the budgets
+/// need, while reading and writing the files happens in jobs. Each region file is a small header
+/// followed by every entity's components stored exactly as they are in the component lists (without
+/// the active byte), in native byte order. Parents and sparse/dense settings aren't saved, and a file
+/// only loads if the component count and sizes are the same as when it was saved.
+void juECSStreamingEnable(int channel, int spawnBudget, int despawnBudget);
+
+/// \brief Creates a streaming region
+/// \param filename File the region is saved to and loaded from
+/// \param onDisk If true the region starts unloaded (its entities are in the file), otherwise it starts loaded and empty
+JURegion juECSRegionCreate(const char *filename, bool onDisk);
+
+/// \brief Puts an entity into a loaded region so it gets saved and despawned with it, false if the region isn't loaded
+bool juECSRegionAdd(JURegion region, JUEntityID entity);
+
+/// \brief Starts saving and despawning a loaded region's entities, false if the region isn't loaded
+///
+/// If the file can't be written the entities are spawned back and the region becomes loaded again.
+bool juECSRegionUnload(JURegion region);
+
+/// \brief Starts reading and spawning an unloaded region's entities, false if the region isn't unloaded
+///
+/// If the file can't be read or doesn't match the current components the region stays unloaded.
+bool juECSRegionLoad(JURegion region);
+
+/// \brief Gets where a region's entities currently are
+JURegionState juECSRegionGetState(JURegion region);
+
+/// \brief Returns timing statistics for the last frame that finished copying
+/// \warning The pointer is only valid until the next `juECSCopyState` call finishes
+const JUECSStats *juECSGetStats();
+
+#ifndef JU_HEADLESS
+/// \brief Draws the stats from `juECSGetStats` with a font, one line per system
+///
+/// Like `juFontDraw` this uses whatever colour the VK2D renderer currently has, and like
+/// any other VK2D call it must be synchronized with whatever systems draw.
+void juECSDrawStats(JUFont font, float x, float y);
+#endif // JU_HEADLESS
+
+/// \brief Returns the frame the ECS is currently on (the number of times state has been copied)
+JUFrame juECSGetFrame();
+
+/// \brief Enables the history ring, which keeps the last `frames` copied states of every component
+/// \param frames Number of frames to keep, 0 disables the history and frees it
+///
+/// Every time state is copied the difference between the new state and the last one is XOR'd
+/// and run-length encoded, so components that don't change between frames cost next to nothing
+/// to keep. The newest frame is always `juECSGetFrame()` and the oldest available frame is
+/// returned by `juECSHistoryOldestFrame`. Call this outside of `juECSRunSystems`/`juECSCopyState`.
+void juECSHistoryEnable(int frames);
+
+/// \brief Returns the oldest frame still stored in the history, or the current frame if the history is empty
+JUFrame juECSHistoryOldestFrame();
+
+/// \brief Copies an entity's component as it was on a given frame into `dst` (for render interpolation and the like)
+/// \return Returns false if the frame is not in the history or the entity did not have that component then
+bool juECSHistoryGetComponent(JUComponent component, JUEntityID entity, JUFrame frame, void *dst);
+
+/// \brief Restores the entire world (entities and both current/previous components) to how it was on a frame
+/// \return Returns false if the frame is not in the history
+///
+/// Every frame newer than `frame` is discarded from the history and `juECSGetFrame` will return
+/// `frame` afterwards. This must not be called while systems or the copy are running.
+bool juECSHistoryRestore(JUFrame frame);
+
+/// \brief Runs systems and copies state until the ECS is on frame `frame` (rollback resimulation)
+/// \param frame Frame to simulate up to
+/// \param prepareFrame Optional function called before each frame is simulated with the frame being simulated,
+/// this is where you would feed the ECS the input for that frame
+///
+/// Typical rollback looks like `juECSHistoryRestore(confirmedFrame)` followed by
+/// `juECSHistoryResimulate(currentFrame, applyInputs)`.
+void juECSHistoryResimulate(JUFrame frame, void (*prepareFrame)(JUFrame frame));
+
+/// \brief Returns true while `juECSHistoryResimulate` is running frames (systems that draw or play sounds should skip their work)
+bool juECSIsResimulating();
+
 /********************** Clock **********************/
 
 /// \brief Data needed to calculate timing things
@@ -234,6 +607,7 @@ void juClockFramerate(JUClock *clock, double framerate);
 /// \brief Gets the average clock time in seconds
 double juClockGetAverage(JUClock *clock);
 
+#ifndef JU_HEADLESS
 /********************** Font **********************/
 
 /// \brief Data as it relates to storing a bitmap character for VK2D
@@ -291,6 +665,7 @@ void juFontDraw(JUFont font, float x, float y, const char *fmt, ...);
 /// vsprintf is used internally, so any and all printf % operators work
 /// in this. Newlines (\n) are also allowed.
 void juFontDrawWrapped(JUFont font, float x, float y, float w, const char *fmt, ...);
+#endif // JU_HEADLESS
 
 /********************** Buffer **********************/
 
@@ -315,6 +690,7 @@ void juBufferFree(JUBuffer buffer);
 /// \brief Saves some data to a file without the need for a buffer
 void juBufferSaveRaw(void *data, uint32_t size, const char *filename);
 
+#ifndef JU_HEADLESS
 /********************** Audio **********************/
 
 /// \brief A sound to be soundInfo
@@ -347,6 +723,7 @@ void juSoundFree(JUSound sound);
 
 /// \brief Stops all currently playing sounds
 void juSoundStopAll();
+#endif // JU_HEADLESS
 
 /********************** File I/O **********************/
 
@@ -464,6 +841,9 @@ double juPointAngle(double x1, double y1, double x2, double y2);
 /// \brief Gets the distance between two points
 double juPointDistance(double x1, double y1, double x2, double y2);
 
+/// \brief Gets the squared distance between two points, cheaper than `juPointDistance` when you only need to compare distances
+double juPointDistanceSquared(double x1, double y1, double x2, double y2);
+
 /// \brief Rotates a point in 2D space about an (absolute) origin
 JUPoint2D juRotatePoint(double x, double y, double originX, double originY, double rotation);
 
@@ -471,6 +851,10 @@ JUPoint2D juRotatePoint(double x, double y, double originX, double originY, doub
 bool juRectangleCollision(JURectangle *r1, JURectangle *r2);
 
 /// \brief Checks for a collision between two rotated rectangles
+///
+/// Each rectangle is rotated about (x + originX, y + originY) the same way `juPointInRotatedRectangle`
+/// does it. This builds a `JUOrientedRectangle` for each rectangle, so if you check the same rectangles
+/// against each other many times a frame it is cheaper to build those once and use `juOrientedRectangleCollision`.
 bool juRotatedRectangleCollision(JURectangle *r1, double rot1, double originX1, double originY1, JURectangle *r2, double rot2, double originX2, double originY2);
 
 /// \brief Checks for a collision between two circles
@@ -485,6 +869,10 @@ bool juPointInRotatedRectangle(JURectangle *rect, double rot, double originX, do
 /// \brief Checks if a point exists within a given circle
 bool juPointInCircle(JUCircle *circle, double x, double y);
 
+/// \brief Checks if the line segment from (x1, y1) to (x2, y2) hits a rectangle
+/// \param fraction If not NULL and the segment hits, this gets how far along the segment it enters the rectangle (0 to 1, 0 if it starts inside)
+bool juRaycast(JURectangle *rect, double x1, double y1, double x2, double y2, double *fraction);
+
 /// \brief Linear interpolation (given a start, stop, and percent it returns the point x% along that distance)
 double juLerp(double percent, double start, double stop);
 
@@ -506,6 +894,580 @@ double juSubToZero(double x, double y);
 /// \brief If x is between min and max, x is returned, if x is above max, max is returned and vice versa
 double juClamp(double x, double min, double max);
 
+/// \brief A single precision 2D vector
+struct JUVec2f {
+	float x; ///< x component
+	float y; ///< y component
+};
+
+/// \brief Single precision version of `JURectangle`
+struct JURectanglef {
+	float x; ///< x position of the top left of the rectangle
+	float y; ///< y position of the top left of the rectangle
+	float w; ///< Width of the rectangle
+	float h; ///< Height of the rectangle
+};
+
+/// \brief Single precision version of `JUCircle`
+struct JUCirclef {
+	float x; ///< x position of the center of the circle
+	float y; ///< y position of the center of the circle
+	float r; ///< Radius in pixels
+};
+
+/// \brief Single precision version of `juPointAngle`
+float juPointAnglef(JUVec2f p1, JUVec2f p2);
+
+/// \brief Single precision version of `juPointDistance`
+float juPointDistancef(JUVec2f p1, JUVec2f p2);
+
+/// \brief Single precision version of `juPointDistanceSquared`
+float juPointDistanceSquaredf(JUVec2f p1, JUVec2f p2);
+
+/// \brief Single precision version of `juRotatePoint`
+JUVec2f juRotatePointf(JUVec2f point, JUVec2f origin, float rotation);
+
+/// \brief Single precision version of `juRectangleCollision`
+bool juRectangleCollisionf(const JURectanglef *r1, const JURectanglef *r2);
+
+/// \brief Single precision version of `juRotatedRectangleCollision`, the origins are relative to each rectangle's top left
+bool juRotatedRectangleCollisionf(const JURectanglef *r1, float rot1, JUVec2f origin1, const JURectanglef *r2, float rot2, JUVec2f origin2);
+
+/// \brief Single precision version of `juCircleCollision`
+bool juCircleCollisionf(const JUCirclef *c1, const JUCirclef *c2);
+
+/// \brief Single precision version of `juPointInRectangle`
+bool juPointInRectanglef(const JURectanglef *rect, JUVec2f point);
+
+/// \brief Single precision version of `juPointInRotatedRectangle`, the origin is relative to the rectangle's top left
+bool juPointInRotatedRectanglef(const JURectanglef *rect, float rot, JUVec2f origin, JUVec2f point);
+
+/// \brief Single precision version of `juPointInCircle`
+bool juPointInCirclef(const JUCirclef *circle, JUVec2f point);
+
+/// \brief Many rectangles stored as one array per field, for the batch collision functions
+struct JURectangleBatch {
+	const double *x; ///< x position of each rectangle
+	const double *y; ///< y position of each rectangle
+	const double *w; ///< Width of each rectangle
+	const double *h; ///< Height of each rectangle
+	int count;       ///< Number of rectangles
+};
+
+/// \brief Many circles stored as one array per field
+struct JUCircleBatch {
+	const double *x; ///< x position of each circle's center
+	const double *y; ///< y position of each circle's center
+	const double *r; ///< Radius of each circle
+	int count;       ///< Number of circles
+};
+
+/// \brief Many points stored as one array per coordinate
+struct JUPointBatch {
+	const double *x; ///< x of each point
+	const double *y; ///< y of each point
+	int count;       ///< Number of points
+};
+
+/// \brief Checks a rectangle against every rectangle in a batch, same as calling `juRectangleCollision` on each
+/// \param mask If not NULL, bit i % 64 of mask[i / 64] is set if rectangle i hits (needs (count + 63) / 64 words)
+/// \param indices If not NULL, gets the index of every rectangle that hits (needs room for count indices)
+/// \return Returns the number of rectangles that hit
+///
+/// The batch functions use AVX or SSE2 when the CPU has them (checked once at runtime) and plain C
+/// otherwise, every version gives the same results.
+int juRectangleCollisionBatch(const JURectangle *rect, const JURectangleBatch *batch, uint64_t *mask, int32_t *indices);
+
+/// \brief Checks every rectangle in one batch against every rectangle in another
+/// \param pairs Gets up to `size` hits as [index in a, index in b] pairs (so it needs room for 2 * size indices)
+/// \return Returns the number of hits, which may be more than `size`
+int juRectangleCollisionBatchAll(const JURectangleBatch *a, const JURectangleBatch *b, int32_t *pairs, int size);
+
+/// \brief Checks a circle against every circle in a batch, same as calling `juCircleCollision` on each
+int juCircleCollisionBatch(const JUCircle *circle, const JUCircleBatch *batch, uint64_t *mask, int32_t *indices);
+
+/// \brief Checks which points in a batch are in a rectangle, same as calling `juPointInRectangle` on each
+int juPointInRectangleBatch(const JURectangle *rect, const JUPointBatch *batch, uint64_t *mask, int32_t *indices);
+
+/// \brief Rotates every point in a batch about an (absolute) origin, same as calling `juRotatePoint` on each
+/// \param outX Gets the x of each rotated point, may be the same array as points->x
+/// \param outY Gets the y of each rotated point, may be the same array as points->y
+///
+/// The sin and cos of the rotation are only worked out once for the whole batch.
+void juRotatePointBatch(const JUPointBatch *points, double originX, double originY, double rotation, double *outX, double *outY);
+
+/// \brief Casts rays of many lengths out at one angle, same as calling `juCastX` and `juCastY` on each
+void juCastBatch(const double *lengths, int count, double angle, double *outX, double *outY);
+
+/// \brief Polynomial approximation of sin
+///
+/// Within 2e-9 of libm's sin for any angle between -1e6 and 1e6, with the error growing slowly past that
+/// as more of the angle is lost reducing it. Meant for hot loops where that is plenty, like particles
+/// or casting lots of rays.
+double juFastSin(double angle);
+
+/// \brief Polynomial approximation of cos, with the same accuracy as `juFastSin`
+double juFastCos(double angle);
+
+/// \brief Gets both `juFastSin` and `juFastCos` of an angle for about the price of one
+void juFastSinCos(double angle, double *sine, double *cosine);
+
+/// \brief Polynomial approximation of atan2 (the standard atan2(y, x), not the angle `juPointAngle` returns)
+///
+/// Within 5e-8 radians of libm's atan2 for every input. Returns 0 for (0, 0).
+double juFastAtan2(double y, double x);
+
+/// \brief Works out `juFastSinCos` for every angle in a list
+/// \param sines Gets the sin of each angle
+/// \param cosines Gets the cos of each angle
+///
+/// Like the batch collision functions this uses AVX or SSE2 when the CPU has them, every version gives
+/// the same results.
+void juFastSinCosBatch(const double *angles, int count, double *sines, double *cosines);
+
+/// \brief A rotated rectangle with its corners and axes worked out, for checking it against many others
+///
+/// Build these with `juOrientedRectangleCreate` once a frame (after things have moved) and they can
+/// be checked against each other any number of times without doing any more trig.
+struct JUOrientedRectangle {
+	JUPoint2D corners[4]; ///< Corners in world space, clockwise starting at the rectangle's top left
+	JUPoint2D axes[2];    ///< Unit vectors along the rectangle's width and height
+	JUPoint2D center;     ///< Center of the rectangle in world space
+	double halfWidth;     ///< Half of the rectangle's width
+	double halfHeight;    ///< Half of the rectangle's height
+	JURectangle bounds;   ///< Axis-aligned box around the corners
+};
+
+/// \brief Rotates a rectangle about (x + originX, y + originY) and caches everything the oriented collision functions need
+void juOrientedRectangleCreate(JUOrientedRectangle *obb, const JURectangle *rect, double rot, double originX, double originY);
+
+/// \brief Checks for a collision between two oriented rectangles with the separating axis test
+bool juOrientedRectangleCollision(const JUOrientedRectangle *o1, const JUOrientedRectangle *o2);
+
+/// \brief Checks an oriented rectangle against every oriented rectangle in an array, see `juRectangleCollisionBatch`
+/// \param others Rectangles to check against, usually built once a frame and reused for every query
+/// \param count Number of rectangles in others
+/// \return Returns the number of rectangles that hit
+///
+/// The bounding boxes are checked first so most of the rectangles that are nowhere near never get
+/// to the separating axis test.
+int juOrientedRectangleCollisionBatch(const JUOrientedRectangle *obb, const JUOrientedRectangle *others, int count, uint64_t *mask, int32_t *indices);
+
+/// \brief Where a moving shape first touches another
+struct JUSweptHit {
+	double time;    ///< How far along the movement the shapes first touch (0 to 1)
+	double normalX; ///< x of the normal of the surface hit, 0 if the shapes were already overlapping
+	double normalY; ///< y of the normal of the surface hit, 0 if the shapes were already overlapping
+	int32_t target; ///< Index of the target that was hit, only filled in by the batch functions (-1 if nothing was hit)
+};
+
+/// \brief Gets the box around a rectangle for its whole movement, for finding what it might hit in a broadphase
+JURectangle juSweptBounds(const JURectangle *rect, double dx, double dy);
+
+/// \brief Checks if a rectangle moving by (dx, dy) hits another rectangle on the way
+/// \param hit If not NULL and the rectangles touch, this gets where they first touch
+/// \return Returns true if the rectangles overlap at any point during the movement
+///
+/// Unlike checking `juRectangleCollision` at the end of the movement, fast shapes can't skip over thin
+/// ones with this. Like `juRectangleCollision` just touching doesn't count, so sliding along a wall
+/// isn't a hit. If both shapes are moving, pass the difference between their movements. The circle
+/// versions below work the same way.
+bool juSweptRectangleCollision(const JURectangle *rect, double dx, double dy, const JURectangle *target, JUSweptHit *hit);
+
+/// \brief Checks if a circle moving by (dx, dy) hits a rectangle on the way, see `juSweptRectangleCollision`
+bool juSweptCircleRectangleCollision(const JUCircle *circle, double dx, double dy, const JURectangle *target, JUSweptHit *hit);
+
+/// \brief Checks if a circle moving by (dx, dy) hits another circle on the way, see `juSweptRectangleCollision`
+bool juSweptCircleCollision(const JUCircle *circle, double dx, double dy, const JUCircle *target, JUSweptHit *hit);
+
+/// \brief Finds the earliest hit for every rectangle in a batch against its candidates from a broadphase query
+/// \param movers Rectangles that are moving
+/// \param movement How far each mover is moving, the x/y arrays are the dx/dy of each mover
+/// \param targets Rectangles the movers can hit
+/// \param candidates Indices into targets each mover should be checked against, or NULL to check every mover against every target
+/// \param candidateStarts Mover i's candidates are from candidateStarts[i] up to candidateStarts[i + 1] (so it needs movers->count + 1 entries)
+/// \param hits Gets the earliest hit of each mover, movers that hit nothing get a time of 1 and a target of -1
+/// \return Returns the number of movers that hit something
+///
+/// Candidates would usually come from querying `juSweptBounds` in a `JUSpatialGrid`, `JUAABBTree` or
+/// the like. Nothing here knows which target is which mover, so if the movers are in the targets
+/// too leave each mover out of its own candidates.
+int juSweptRectangleBatch(const JURectangleBatch *movers, const JUPointBatch *movement, const JURectangleBatch *targets, const int32_t *candidates, const int32_t *candidateStarts, JUSweptHit *hits);
+
+/// \brief Finds the earliest hit for every circle in a batch against rectangles, see `juSweptRectangleBatch`
+int juSweptCircleBatch(const JUCircleBatch *movers, const JUPointBatch *movement, const JURectangleBatch *targets, const int32_t *candidates, const int32_t *candidateStarts, JUSweptHit *hits);
+
+/********************** Spatial Grid **********************/
+
+/// \brief Uniform grid broadphase for rectangles and circles, only cells that have something in them use memory
+///
+/// Each proxy is stored in every cell its bounds cover, and cells are found through a hash so the
+/// world doesn't need a size. Entries are pooled, so moving proxies around doesn't allocate once
+/// the grid has warmed up. The cell size should be around the size of a typical proxy.
+struct JUSpatialGrid {
+	double cellSize;                     ///< Width/height of each cell
+	int32_t *buckets;                    ///< First entry in each bucket, -1 for empty buckets
+	int bucketCount;                     ///< Number of buckets (always a power of 2)
+	struct JUSpatialGridEntry *entries;  ///< Pool of entries, one for each cell a proxy covers
+	int entryCount;                      ///< Number of entries in the pool that have ever been used
+	int entryListSize;                   ///< Actual size of the entry pool
+	int32_t freeEntries;                 ///< First entry in the free list, -1 if there are none
+	int liveEntries;                     ///< Number of entries in buckets
+	struct JUSpatialGridProxy *proxies;  ///< Proxies by id
+	int proxyCount;                      ///< Number of proxy ids that have ever been used
+	int proxyListSize;                   ///< Actual size of the proxy list
+	JUProxy freeProxies;                 ///< First removed proxy whose id can be reused, -1 if there are none
+};
+
+/// \brief Creates an empty spatial grid
+/// \param cellSize Width/height of each cell
+JUSpatialGrid juSpatialGridCreate(double cellSize);
+
+/// \brief Adds a rectangle to a grid, returning the proxy it is stored as (removed proxy ids are reused)
+JUProxy juSpatialGridInsert(JUSpatialGrid grid, const JURectangle *rect);
+
+/// \brief Adds a circle to a grid, returning the proxy it is stored as
+JUProxy juSpatialGridInsertCircle(JUSpatialGrid grid, const JUCircle *circle);
+
+/// \brief Moves a proxy, it is only re-bucketed if the cells it covers change
+void juSpatialGridUpdate(JUSpatialGrid grid, JUProxy proxy, const JURectangle *rect);
+
+/// \brief Moves a proxy and makes it a circle
+void juSpatialGridUpdateCircle(JUSpatialGrid grid, JUProxy proxy, const JUCircle *circle);
+
+/// \brief Removes a proxy from a grid, its id may be handed out again by the next insert
+void juSpatialGridRemove(JUSpatialGrid grid, JUProxy proxy);
+
+/// \brief Finds every proxy whose shape overlaps a rectangle
+/// \param proxies Output list that gets up to `size` proxies
+/// \param size Size of the output list
+/// \return Returns the number of proxies in the area, which may be more than `size`
+///
+/// Queries don't modify the grid so any number of threads can query at once (as long as nothing is updating it).
+int juSpatialGridQuery(JUSpatialGrid grid, const JURectangle *area, JUProxy *proxies, int size);
+
+/// \brief Finds every proxy whose shape overlaps a circle, same as `juSpatialGridQuery` otherwise
+int juSpatialGridQueryCircle(JUSpatialGrid grid, const JUCircle *area, JUProxy *proxies, int size);
+
+/// \brief Calls a function once for every pair of proxies whose shapes overlap
+/// \param pair Function called for each pair, `proxy1` is always the smaller id
+/// \param data Passed to `pair`
+/// \return Returns the number of pairs found
+///
+/// Each pair is reported from the first cell both proxies cover, so there are no duplicates
+/// and no scratch memory is needed.
+int juSpatialGridPairs(JUSpatialGrid grid, void (*pair)(JUProxy proxy1, JUProxy proxy2, void *data), void *data);
+
+/// \brief Frees a grid and every proxy in it
+void juSpatialGridFree(JUSpatialGrid grid);
+
+/********************** AABB Tree **********************/
+
+/// \brief Dynamic bounding volume tree, a broadphase that handles very uneven object sizes better than a grid
+///
+/// Each proxy is a leaf whose box is fattened by a margin, so objects that move a little don't touch
+/// the tree at all. Leaves are inserted next to whichever sibling grows the tree's perimeter the least
+/// and the tree is rebalanced with rotations on the way back up, so it stays about log(n) deep no
+/// matter what order things are added in. Nodes are pooled and proxy ids are leaf nodes.
+struct JUAABBTree {
+	struct JUAABBTreeNode *nodes; ///< Pool of nodes
+	int nodeCount;                ///< Number of nodes in the pool that have ever been used
+	int nodeListSize;             ///< Actual size of the node pool
+	int32_t freeNodes;            ///< First node in the free list, -1 if there are none
+	int32_t root;                 ///< Root node, -1 if the tree is empty
+	double margin;                ///< How much leaves are fattened on each side
+};
+
+/// \brief Creates an empty tree
+/// \param margin How much each proxy's box is fattened on each side, proxies that move less than this aren't re-inserted
+JUAABBTree juAABBTreeCreate(double margin);
+
+/// \brief Adds a rectangle to a tree, returning the proxy it is stored as
+JUProxy juAABBTreeInsert(JUAABBTree tree, const JURectangle *rect);
+
+/// \brief Moves a proxy, returning true if it left its fat box and had to be re-inserted
+bool juAABBTreeUpdate(JUAABBTree tree, JUProxy proxy, const JURectangle *rect);
+
+/// \brief Removes a proxy from a tree, its id may be handed out again
+void juAABBTreeRemove(JUAABBTree tree, JUProxy proxy);
+
+/// \brief Finds every proxy that overlaps a rectangle
+/// \param proxies Output list that gets up to `size` proxies
+/// \param size Size of the output list
+/// \return Returns the number of proxies in the area, which may be more than `size`
+///
+/// Like the other queries this doesn't modify the tree so it can be called from several threads at once.
+int juAABBTreeQuery(JUAABBTree tree, const JURectangle *area, JUProxy *proxies, int size);
+
+/// \brief Finds the first proxy hit by the line segment from (x1, y1) to (x2, y2)
+/// \param fraction If not NULL and something is hit, this gets how far along the segment the hit is (0 to 1)
+/// \return Returns the proxy that was hit or `JU_NO_PROXY`
+JUProxy juAABBTreeRaycast(JUAABBTree tree, double x1, double y1, double x2, double y2, double *fraction);
+
+/// \brief Calls a function once for every pair of proxies that overlap
+/// \param pair Function called for each pair, `proxy1` is always the smaller id
+/// \param data Passed to `pair`
+/// \return Returns the number of pairs found
+int juAABBTreePairs(JUAABBTree tree, void (*pair)(JUProxy proxy1, JUProxy proxy2, void *data), void *data);
+
+/// \brief Frees a tree and every proxy in it
+void juAABBTreeFree(JUAABBTree tree);
+
+/********************** Sweep and Prune **********************/
+
+/// \brief Broadphase that keeps its proxies sorted along both axes from one frame to the next
+///
+/// Each proxy's edges are kept in a sorted list per axis. Most things only move a little each
+/// frame, so re-sorting with an insertion sort only swaps a few neighbours. Each swap is where a
+/// pair of proxies starts or stops overlapping, so the sweep reports begin/end events rather than
+/// every overlapping pair. Overlaps are the same as `juRectangleCollision`, so touching edges don't count.
+struct JUSweepAndPrune {
+	struct JUSweepProxy *proxies;        ///< Proxies by id
+	int proxyCount;                      ///< Number of proxy ids that have ever been used
+	int proxyListSize;                   ///< Actual size of the proxy list
+	JUProxy freeProxies;                 ///< First proxy whose id can be reused, -1 if there are none
+	struct JUSweepEndpoint *endpoints[2]; ///< Sorted edges of every proxy along x and y
+	int endpointCount;                   ///< Number of edges along each axis
+	int endpointListSize;                ///< Actual size of each edge list
+	uint64_t *pairs;                     ///< Hash set of overlapping pairs
+	int pairCount;                       ///< Number of overlapping pairs
+	int pairListSize;                    ///< Number of slots in the pair set (always a power of 2)
+	int added;                           ///< Proxies inserted since the last sweep
+	int removed;                         ///< Proxies removed since the last sweep
+};
+
+/// \brief Creates an empty sweep and prune
+JUSweepAndPrune juSweepAndPruneCreate();
+
+/// \brief Adds a rectangle, returning the proxy it is stored as (its pairs are found by the next sweep)
+JUProxy juSweepAndPruneInsert(JUSweepAndPrune sap, const JURectangle *rect);
+
+/// \brief Moves a proxy, it is re-sorted by the next sweep
+void juSweepAndPruneUpdate(JUSweepAndPrune sap, JUProxy proxy, const JURectangle *rect);
+
+/// \brief Removes a proxy, the next sweep reports the end of all its pairs and then its id may be handed out again
+void juSweepAndPruneRemove(JUSweepAndPrune sap, JUProxy proxy);
+
+/// \brief Re-sorts every proxy and reports the pairs that started or stopped overlapping since the last sweep
+/// \param event Function called for each change, `proxy1` is always the smaller id and `begin` is false when a pair stops overlapping
+/// \param data Passed to `event`
+/// \return Returns the number of events
+///
+/// If a lot of proxies were inserted since the last sweep (like on the first one) everything is sorted
+/// from scratch instead, since insertion sorting them in one at a time would be quadratic.
+int juSweepAndPruneSweep(JUSweepAndPrune sap, void (*event)(JUProxy proxy1, JUProxy proxy2, bool begin, void *data), void *data);
+
+/// \brief Calls a function once for every pair that was overlapping as of the last sweep
+/// \param pair Function called for each pair, `proxy1` is always the smaller id
+/// \param data Passed to `pair`
+/// \return Returns the number of pairs
+int juSweepAndPrunePairs(JUSweepAndPrune sap, void (*pair)(JUProxy proxy1, JUProxy proxy2, void *data), void *data);
+
+/// \brief Frees a sweep and prune and every proxy in it
+void juSweepAndPruneFree(JUSweepAndPrune sap);
+
+/********************** Tile Map **********************/
+
+/// \brief Grid of solid/empty tiles for level collisions, stored as one bit per tile
+///
+/// Rows are packed into 64 bit words so a whole run of tiles can be checked with a couple of
+/// instructions, and raycasts step through tiles one at a time rather than testing rectangles.
+/// Tiles outside the map are always empty.
+struct JUTileMap {
+	uint64_t *tiles;   ///< Solidity of each tile, row by row, bit x % 64 of word x / 64 in a row is tile x
+	int rowWords;      ///< Number of words in each row
+	int width;         ///< Width of the map in tiles
+	int height;        ///< Height of the map in tiles
+	double tileWidth;  ///< Width of each tile in pixels
+	double tileHeight; ///< Height of each tile in pixels
+	double x;          ///< x position of the map's top left in the world, 0 unless you change it
+	double y;          ///< y position of the map's top left in the world, 0 unless you change it
+};
+
+/// \brief Creates a tile map where every tile is empty
+/// \param width Width of the map in tiles
+/// \param height Height of the map in tiles
+/// \param tileWidth Width of each tile in pixels
+/// \param tileHeight Height of each tile in pixels
+JUTileMap juTileMapCreate(int width, int height, double tileWidth, double tileHeight);
+
+/// \brief Makes a tile solid or empty, tiles outside the map are ignored
+void juTileMapSet(JUTileMap map, int x, int y, bool solid);
+
+/// \brief Makes a span of w by h tiles starting at tile (x, y) solid or empty
+void juTileMapFill(JUTileMap map, int x, int y, int w, int h, bool solid);
+
+/// \brief Checks if a tile is solid
+bool juTileMapGet(JUTileMap map, int x, int y);
+
+/// \brief Checks if any tile in a span of w by h tiles starting at tile (x, y) is solid
+bool juTileMapSpanSolid(JUTileMap map, int x, int y, int w, int h);
+
+/// \brief Finds the first solid tile in a row between two columns
+/// \param row Row to look in
+/// \param from Column to start at
+/// \param to Column to stop at (inclusive), if this is less than from the row is searched right to left
+/// \return Returns the column of the first solid tile found or -1 if there are none
+int juTileMapFindSolid(JUTileMap map, int row, int from, int to);
+
+/// \brief Checks if a rectangle (in world space) overlaps any solid tile, touching a tile doesn't count
+bool juTileMapCollision(JUTileMap map, const JURectangle *rect);
+
+/// \brief Moves a rectangle by (dx, dy), stopping it flush against any solid tiles in the way
+/// \param rect Rectangle to move, it is moved in place
+/// \param hitX If not NULL, this is set to whether or not the horizontal movement was stopped
+/// \param hitY If not NULL, this is set to whether or not the vertical movement was stopped
+/// \return Returns true if the movement was stopped on either axis
+///
+/// The rectangle moves horizontally and then vertically, so it slides along walls and floors and can
+/// never skip over a tile no matter how fast it moves. A rectangle that is already stuck inside
+/// solid tiles can still move out of them.
+bool juTileMapMove(JUTileMap map, JURectangle *rect, double dx, double dy, bool *hitX, bool *hitY);
+
+/// \brief Finds the first solid tile hit by the line segment from (x1, y1) to (x2, y2)
+/// \param hit If not NULL and a tile is hit, this gets how far along the segment the hit is, the face
+///        of the tile that was hit, and the tile as its index (tileY * width + tileX) in `target`
+/// \return Returns true if a solid tile was hit
+///
+/// This steps through only the tiles the segment crosses (Amanatides and Woo's algorithm), so
+/// it costs about one bit test per tile crossed.
+bool juTileMapRaycast(JUTileMap map, double x1, double y1, double x2, double y2, JUSweptHit *hit);
+
+/// \brief Frees a tile map
+void juTileMapFree(JUTileMap map);
+
+/********************** Pathfinding **********************/
+
+/// \brief How a pathfinder searches, both find the same length of path
+typedef enum {
+	JU_PATH_ASTAR = 0, ///< Plain A*, looks at every tile it passes
+	JU_PATH_JPS = 1,   ///< Jump point search, skips along straight runs of open tiles so it is usually much faster on open maps
+} JUPathMode;
+
+/// \brief Search state for finding paths through a tile map, reused between searches so they don't allocate
+///
+/// Paths move in 8 directions (diagonal steps cost sqrt(2)) through tiles that aren't solid, and never
+/// cut the corner of a solid tile. Each pathfinder can only run one search at a time, so give each
+/// thread its own.
+struct JUPathfinder {
+	JUTileMap map;                ///< Map paths are found through
+	float *costs;                 ///< Cost of the best way found to each tile this search
+	int32_t *parents;             ///< Tile each tile is reached from
+	uint32_t *stamps;             ///< Search each tile was last touched by so the arrays never need clearing
+	uint32_t search;              ///< Stamp of the current search, tiles with this stamp are open and this + 1 closed
+	struct JUPathNode *heap;      ///< Binary heap of open tiles
+	int heapSize;                 ///< Number of tiles in the heap
+	int heapListSize;             ///< Actual size of the heap
+	JUPathRequest *requests;      ///< Requests this pathfinder works through when queued with `juPathfinderQueue`
+	int requestCount;             ///< Number of requests in the queued list
+	int requestStart;             ///< First request in the list this pathfinder handles
+	int requestStride;            ///< Distance between the requests this pathfinder handles
+};
+
+/// \brief A path to find with `juPathfinderQueue`
+struct JUPathRequest {
+	int startX;     ///< Tile to start at
+	int startY;     ///< Tile to start at
+	int goalX;      ///< Tile to get to
+	int goalY;      ///< Tile to get to
+	JUPathMode mode; ///< How to search
+	int32_t *path;  ///< Gets the tiles along the path, see `juPathfinderFind`
+	int size;       ///< Room in path
+	int length;     ///< Gets the length of the path once the job is done, -1 if there is none
+};
+
+/// \brief Creates a pathfinder for a map, its memory is sized for the map once and reused by every search
+JUPathfinder juPathfinderCreate(JUTileMap map);
+
+/// \brief Finds the shortest path between two tiles
+/// \param path Gets up to `size` tiles along the path as indices (tileY * width + tileX), starting with the start tile and ending with the goal tile
+/// \param size Room in path
+/// \return Returns the number of tiles in the path (which may be more than `size`), or -1 if there is no path
+int juPathfinderFind(JUPathfinder pathfinder, JUPathMode mode, int startX, int startY, int goalX, int goalY, int32_t *path, int size);
+
+/// \brief Finds a lot of paths at once on the job system
+/// \param pathfinders Pathfinders to use, each one becomes a job (one per worker thread is plenty)
+/// \param pathfinderCount Number of pathfinders
+/// \param requests Paths to find, their `length` is filled in as they finish
+/// \param count Number of requests
+/// \param channel Job channel to run the searches on, wait for it with `juJobWaitChannel` before reading the results
+/// \warning Don't change the map, free the pathfinders or touch the requests until the channel is done
+void juPathfinderQueue(JUPathfinder *pathfinders, int pathfinderCount, JUPathRequest *requests, int count, int channel);
+
+/// \brief Frees a pathfinder
+void juPathfinderFree(JUPathfinder pathfinder);
+
+/********************** Flow Fields **********************/
+
+/// \brief Directions from every tile of a tile map towards the nearest of some goals, for lots of agents chasing the same thing
+///
+/// Rather than each agent finding its own path, a flow field works out the distance from every tile to
+/// the goals once (the integration field) and from that which neighbour each tile should step to (the
+/// direction field). Agents then just look up the direction under them. Movement follows the same rules
+/// as `JUPathfinder`.
+struct JUFlowField {
+	JUTileMap map;                 ///< Map the field covers
+	float *costs;                  ///< Distance in tiles from each tile to the nearest goal, INFINITY if it can't get to one
+	uint8_t *directions;           ///< Neighbour each tile steps to, 0-8 going across then down a 3x3 block so 4 means stay put
+	int32_t *goals;                ///< Goal tiles
+	int goalCount;                 ///< Number of goals
+	int goalListSize;              ///< Actual size of the goal list
+	struct JUPathNode *heap;       ///< Binary heap of tiles whose distance changed
+	int heapSize;                  ///< Number of tiles in the heap
+	int heapListSize;              ///< Actual size of the heap
+	int32_t *changed;              ///< Tiles whose distance changed in an update, their directions are redone
+	int changedCount;              ///< Number of changed tiles
+	int changedListSize;           ///< Actual size of the changed list
+	struct JUFlowFieldJob *jobs;   ///< Bands of rows the directions are split into
+	int jobListSize;               ///< Actual size of the job list
+};
+
+/// \brief Creates a flow field for a map with no goals
+JUFlowField juFlowFieldCreate(JUTileMap map);
+
+/// \brief Makes a tile the only goal, takes effect the next time the field is built
+void juFlowFieldSetGoal(JUFlowField field, int x, int y);
+
+/// \brief Adds another goal, agents head to whichever is closest, takes effect the next time the field is built
+void juFlowFieldAddGoal(JUFlowField field, int x, int y);
+
+/// \brief Works out the whole field from scratch
+/// \param channel Job channel the direction field is split into jobs on, this waits for it before returning
+///
+/// The integration field is done on this thread and the direction field on all worker threads (if it is big enough).
+/// To build a lot of flow fields at once use `juFlowFieldQueue` instead.
+void juFlowFieldBuild(JUFlowField field, int channel);
+
+/// \brief Builds several flow fields at once, each as its own job
+/// \param channel Job channel to build them on, wait for it with `juJobWaitChannel` before using the fields
+/// \warning Don't change the map or the fields until the channel is done
+void juFlowFieldQueue(JUFlowField *fields, int count, int channel);
+
+/// \brief Repairs a built field after some tiles in its map were changed, far cheaper than building it again
+/// \param x Left tile of the area that changed (the same area given to `juTileMapFill`, or 1x1 for `juTileMapSet`)
+/// \param y Top tile of the area that changed
+/// \param w Width in tiles of the area that changed
+/// \param h Height in tiles of the area that changed
+///
+/// Only the tiles whose route to a goal went through the area (or that can now get somewhere quicker
+/// through it) are worked out again. Every change to the map since the field was last built or updated
+/// has to be inside the area.
+void juFlowFieldUpdate(JUFlowField field, int x, int y, int w, int h);
+
+/// \brief Gets the direction to head in from a position in the world, this is just a lookup
+/// \param x World position (the map's x, y and tile size are taken into account)
+/// \param y World position
+/// \param directionX Gets the x of the unit vector to move along
+/// \param directionY Gets the y of the unit vector to move along
+/// \return Returns false if there is nowhere to go (already at a goal, in a wall or boxed in) and the direction is 0, 0
+bool juFlowFieldSample(JUFlowField field, double x, double y, double *directionX, double *directionY);
+
+/// \brief Gets the distance in tiles from a tile to the nearest goal, or -1 if it can't get to one
+double juFlowFieldDistance(JUFlowField field, int x, int y);
+
+/// \brief Frees a flow field
+void juFlowFieldFree(JUFlowField field);
+
 /********************** Keyboard **********************/
 
 /// \brief Checks if a key is currently pressed
@@ -517,6 +1479,7 @@ bool juKeyboardGetKeyPressed(SDL_Scancode key);
 /// \brief Checks if a key is currently pressed
 bool juKeyboardGetKeyReleased(SDL_Scancode key);
 
+#ifndef JU_HEADLESS
 /********************** Animations **********************/
 
 /// \brief Information for sprites
@@ -572,6 +1535,7 @@ void juSpriteDrawFrame(JUSprite spr, uint32_t index, float x, float y);
 
 /// \brief Frees an animation from memory
 void juSpriteFree(JUSprite spr);
+#endif // JU_HEADLESS
 
 /********************** Jobs System **********************/
 
@@ -588,6 +1552,7 @@ void juJobQueue(JUJob job);
 /// \brief Waits for all jobs on a channel to be completed
 void juJobWaitChannel(int channel);
 
+#ifndef JU_HEADLESS
 /********************** Asset Manager **********************/
 
 /// \brief Data used to tell the loader what to load
@@ -659,4 +1624,5 @@ JUBuffer juLoaderGetBuffer(JULoader loader, const char *filename);
 JUSprite juLoaderGetSprite(JULoader loader, const char *filename);
 
 /// \brief Frees a JULoader and all the assets it loaded
-void juLoaderFree(JULoader loader);
\ No newline at end of file
+void juLoaderFree(JULoader loader);
+#endif // JU_HEADLESS
@@ -0,0 +1,677 @@
+/// \file bench.c
+/// \author Paolo Mazzon
+/// \brief Headless benchmarks for JamUtil, needs no window, VK2D or GPU
+///
+/// Every result is printed to stdout as a single line of JSON so runs can be
+/// piped into a file and compared against each other to catch regressions.
+/// Pass entity counts as arguments to override the default 1k/100k/1M runs.
+#define SDL_MAIN_HANDLED
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "JamUtil.h"
+
+/***************************** Constants *****************************/
+
+const int BENCH_JOB_CHANNELS = 3;
+const int BENCH_JOB_CHANNEL = 2;
+const int BENCH_JOB_THREADS = 2;
+const int BENCH_FRAMES = 10;
+const int DEFAULT_ENTITY_COUNTS[] = {1000, 100000, 1000000};
+const int DEFAULT_ENTITY_COUNT_COUNT = 3;
+const int DEFAULT_GRID_COUNTS[] = {10000, 50000, 100000};
+const int DEFAULT_GRID_COUNT_COUNT = 3;
+const int DEFAULT_PATH_COUNTS[] = {100, 1000, 10000};
+const int DEFAULT_PATH_COUNT_COUNT = 3;
+const double GRID_OBJECT_SIZE = 16;   // Largest width/height of each object in the grid benchmarks
+const double GRID_WORLD_DENSITY = 32; // World is sized so there is one object per this many pixels squared
+const int TILE_MAP_SIZE = 1024;        // Width/height in tiles of the tile map benchmark's map
+const double TILE_SIZE = 16;           // Width/height of each tile in the tile map benchmark
+const int PATH_MAP_SIZE = 256;         // Width/height in tiles of the pathfinding benchmark's map
+const int PATH_LENGTH = 1024;          // Room for each path in the pathfinding benchmark
+
+/***************************** ECS stuff *****************************/
+
+typedef struct CompPosition {
+	float x;
+	float y;
+} CompPosition;
+
+typedef struct CompVelocity {
+	float x;
+	float y;
+} CompVelocity;
+
+typedef struct CompHealth {
+	int32_t health;
+	int32_t regen;
+} CompHealth;
+
+size_t COMPONENT_SIZES[] = {
+		sizeof(struct CompPosition),
+		sizeof(struct CompVelocity),
+		sizeof(struct CompHealth),
+};
+
+typedef enum {
+	COMPONENT_POSITION = 0,
+	COMPONENT_VELOCITY = 1,
+	COMPONENT_HEALTH = 2,
+	COMPONENT_COUNT = 3,
+} Components;
+
+void systemMovement(JUEntityID entity) {
+	const CompVelocity *vel = juECSGetPreviousComponent(COMPONENT_VELOCITY, entity);
+	CompPosition *pos = juECSGetComponent(COMPONENT_POSITION, entity);
+	pos->x += vel->x;
+	pos->y += vel->y;
+}
+
+void systemHealth(JUEntityID entity) {
+	CompHealth *health = juECSGetComponent(COMPONENT_HEALTH, entity);
+	health->health += health->regen;
+}
+
+JUComponent MOVEMENT_COMPONENTS[] = {COMPONENT_POSITION, COMPONENT_VELOCITY};
+JUComponent HEALTH_COMPONENTS[] = {COMPONENT_HEALTH};
+JUSystem SYSTEMS[] = {
+		{MOVEMENT_COMPONENTS, 2, systemMovement},
+		{HEALTH_COMPONENTS, 1, systemHealth},
+};
+const int SYSTEM_COUNT = 2;
+
+const JUComponent ENT_COMPS[] = {COMPONENT_POSITION, COMPONENT_VELOCITY, COMPONENT_HEALTH};
+const int ENT_COMPS_SIZE = 3;
+
+/***************************** Helpers *****************************/
+
+// Prints a single result as a line of JSON
+static void benchReport(const char *suite, const char *benchmark, int count, double seconds, double operations, double bytes) {
+	printf("{\"suite\": \"%s\", \"benchmark\": \"%s\", \"count\": %i, \"seconds\": %.9f, \"per_second\": %.1f", suite, benchmark, count, seconds, seconds > 0 ? operations / seconds : 0);
+	if (bytes > 0)
+		printf(", \"bytes_per_second\": %.1f", seconds > 0 ? bytes / seconds : 0);
+	printf("}\n");
+	fflush(stdout);
+}
+
+static void benchEmptyJob(void *data) {
+	// Nothing, this just measures job overhead
+}
+
+// Random number in [0, max)
+static double benchRandom(double max) {
+	return ((double)rand() / ((double)RAND_MAX + 1)) * max;
+}
+
+// Hits from the scalar loops go here so they aren't optimized out
+static volatile int gBenchSink;
+
+// Makes a random rectangle in a world of a given size
+static JURectangle benchRandomRectangle(double worldSize) {
+	JURectangle rect = {benchRandom(worldSize), benchRandom(worldSize), 1 + benchRandom(GRID_OBJECT_SIZE - 1), 1 + benchRandom(GRID_OBJECT_SIZE - 1)};
+	return rect;
+}
+
+/***************************** Benchmarks *****************************/
+
+static void benchECS(int count) {
+	JUClock clock;
+	CompPosition pos = {0, 0};
+	CompVelocity vel = {1, 0.5f};
+	CompHealth health = {100, 1};
+	JUComponentVector defaults[] = {&pos, &vel, &health};
+	double bytesPerEntity = 0;
+	for (int i = 0; i < COMPONENT_COUNT; i++)
+		bytesPerEntity += COMPONENT_SIZES[i] + 1;
+
+	// Spawning
+	juClockReset(&clock);
+	for (int i = 0; i < count; i++)
+		juECSAddEntity(ENT_COMPS, defaults, ENT_COMPS_SIZE);
+	benchReport("ecs", "spawn", count, juClockTime(&clock), count, 0);
+
+	// System iteration (the copy isn't counted)
+	double systemTime = 0;
+	double copyTime = 0;
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		juClockStart(&clock);
+		juECSRunSystems();
+		juJobWaitChannel(JU_JOB_CHANNEL_SYSTEMS);
+		systemTime += juClockTime(&clock);
+
+		juClockStart(&clock);
+		juECSCopyState();
+		juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+		copyTime += juClockTime(&clock);
+	}
+	benchReport("ecs", "systems", count, systemTime / BENCH_FRAMES, (double)count * SYSTEM_COUNT, 0);
+	benchReport("ecs", "copy", count, copyTime / BENCH_FRAMES, count, bytesPerEntity * count);
+
+	// Destroying (entities are only removed during the copy so that is included)
+	juClockStart(&clock);
+	juECSDestroyAll();
+	juECSCopyState();
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	benchReport("ecs", "destroy", count, juClockTime(&clock), count, 0);
+
+	// Spawning from a prefab with a unique position per entity
+	JUPrefab prefab = juECSCreatePrefab(ENT_COMPS, defaults, ENT_COMPS_SIZE);
+	CompPosition *positions = malloc(sizeof(CompPosition) * count);
+	for (int i = 0; i < count; i++) {
+		positions[i].x = i;
+		positions[i].y = i;
+	}
+	JUPrefabOverride override = {COMPONENT_POSITION, 0, sizeof(CompPosition), positions, 0};
+	juClockStart(&clock);
+	juECSInstantiateWith(prefab, count, &override, 1, NULL);
+	benchReport("ecs", "instantiate", count, juClockTime(&clock), count, 0);
+	juECSDestroyAll();
+	juECSCopyState();
+	juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+	juECSFreePrefab(prefab);
+	free(positions);
+}
+
+static void benchSpatialGrid(int count) {
+	JUClock clock;
+	double worldSize = sqrt((double)count) * GRID_WORLD_DENSITY;
+	JURectangle *rects = malloc(sizeof(JURectangle) * count);
+	JUProxy *proxies = malloc(sizeof(JUProxy) * count);
+	JUSpatialGrid grid = juSpatialGridCreate(GRID_OBJECT_SIZE);
+	srand(count);
+	for (int i = 0; i < count; i++)
+		rects[i] = benchRandomRectangle(worldSize);
+
+	juClockReset(&clock);
+	for (int i = 0; i < count; i++)
+		proxies[i] = juSpatialGridInsert(grid, &rects[i]);
+	benchReport("grid", "insert", count, juClockTime(&clock), count, 0);
+
+	// Every object moves a little like it would in a game
+	double updateTime = 0;
+	double pairTime = 0;
+	double pairs = 0;
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		for (int j = 0; j < count; j++) {
+			rects[j].x += benchRandom(4) - 2;
+			rects[j].y += benchRandom(4) - 2;
+		}
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			juSpatialGridUpdate(grid, proxies[j], &rects[j]);
+		updateTime += juClockTime(&clock);
+
+		juClockStart(&clock);
+		pairs += juSpatialGridPairs(grid, NULL, NULL);
+		pairTime += juClockTime(&clock);
+	}
+	benchReport("grid", "update", count, updateTime / BENCH_FRAMES, count, 0);
+	benchReport("grid", "pairs", count, pairTime / BENCH_FRAMES, pairs / BENCH_FRAMES, 0);
+
+	juSpatialGridFree(grid);
+	free(proxies);
+	free(rects);
+}
+
+static void benchSweepAndPrune(int count) {
+	JUClock clock;
+	double worldSize = sqrt((double)count) * GRID_WORLD_DENSITY;
+	JURectangle *rects = malloc(sizeof(JURectangle) * count);
+	JUProxy *proxies = malloc(sizeof(JUProxy) * count);
+	JUSweepAndPrune sap = juSweepAndPruneCreate();
+	srand(count);
+	for (int i = 0; i < count; i++) {
+		rects[i] = benchRandomRectangle(worldSize);
+		proxies[i] = juSweepAndPruneInsert(sap, &rects[i]);
+	}
+	juSweepAndPruneSweep(sap, NULL, NULL);
+
+	// Same movement as the grid benchmark, sweeping the persistent lists against sorting a fresh one every frame
+	double sweepTime = 0;
+	double rebuildTime = 0;
+	double events = 0;
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		for (int j = 0; j < count; j++) {
+			rects[j].x += benchRandom(4) - 2;
+			rects[j].y += benchRandom(4) - 2;
+		}
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			juSweepAndPruneUpdate(sap, proxies[j], &rects[j]);
+		events += juSweepAndPruneSweep(sap, NULL, NULL);
+		sweepTime += juClockTime(&clock);
+
+		juClockStart(&clock);
+		JUSweepAndPrune rebuild = juSweepAndPruneCreate();
+		for (int j = 0; j < count; j++)
+			juSweepAndPruneInsert(rebuild, &rects[j]);
+		gBenchSink = juSweepAndPruneSweep(rebuild, NULL, NULL);
+		juSweepAndPruneFree(rebuild);
+		rebuildTime += juClockTime(&clock);
+	}
+	benchReport("sap", "sweep", count, sweepTime / BENCH_FRAMES, count, 0);
+	benchReport("sap", "rebuild", count, rebuildTime / BENCH_FRAMES, count, 0);
+	benchReport("sap", "events", count, sweepTime / BENCH_FRAMES, events / BENCH_FRAMES, 0);
+
+	juSweepAndPruneFree(sap);
+	free(proxies);
+	free(rects);
+}
+
+static void benchTileMap(int count) {
+	JUClock clock;
+	JUTileMap map = juTileMapCreate(TILE_MAP_SIZE, TILE_MAP_SIZE, TILE_SIZE, TILE_SIZE);
+	double worldSize = TILE_MAP_SIZE * TILE_SIZE;
+	srand(count);
+
+	// Scattered short walls, sparse enough that most rays cross hundreds of tiles before hitting one
+	for (int i = 0; i < (TILE_MAP_SIZE * TILE_MAP_SIZE) / 512; i++)
+		juTileMapFill(map, rand() % TILE_MAP_SIZE, rand() % TILE_MAP_SIZE, 1 + (rand() % 4), 1 + (rand() % 4), true);
+
+	double tiles = 0;
+	int hits = 0;
+	juClockStart(&clock);
+	for (int i = 0; i < count; i++) {
+		double x1 = benchRandom(worldSize);
+		double y1 = benchRandom(worldSize);
+		double x2 = benchRandom(worldSize);
+		double y2 = benchRandom(worldSize);
+		JUSweptHit hit;
+		bool result = juTileMapRaycast(map, x1, y1, x2, y2, &hit);
+		hits += result;
+		tiles += ((fabs(x2 - x1) + fabs(y2 - y1)) / TILE_SIZE) * (result ? hit.time : 1);
+	}
+	double rayTime = juClockTime(&clock);
+	benchReport("tilemap", "raycast", count, rayTime, count, 0);
+	benchReport("tilemap", "raycast_tiles", count, rayTime, tiles, 0);
+
+	juClockStart(&clock);
+	for (int i = 0; i < count; i++) {
+		JURectangle rect = {benchRandom(worldSize), benchRandom(worldSize), TILE_SIZE * 0.75, TILE_SIZE * 1.5};
+		hits += juTileMapMove(map, &rect, benchRandom(TILE_SIZE * 8) - (TILE_SIZE * 4), benchRandom(TILE_SIZE * 8) - (TILE_SIZE * 4), NULL, NULL);
+	}
+	benchReport("tilemap", "move", count, juClockTime(&clock), count, 0);
+	gBenchSink = hits;
+
+	juTileMapFree(map);
+}
+
+static void benchPathfinding(int count) {
+	JUClock clock;
+	JUTileMap map = juTileMapCreate(PATH_MAP_SIZE, PATH_MAP_SIZE, TILE_SIZE, TILE_SIZE);
+	JUPathRequest *requests = malloc(sizeof(struct JUPathRequest) * count);
+	int32_t *paths = malloc(sizeof(int32_t) * PATH_LENGTH * BENCH_JOB_THREADS);
+	JUPathfinder *pathfinders = malloc(sizeof(JUPathfinder) * BENCH_JOB_THREADS);
+	for (int i = 0; i < BENCH_JOB_THREADS; i++)
+		pathfinders[i] = juPathfinderCreate(map);
+	srand(count);
+
+	// Scattered walls a few tiles long so paths have to weave around things but rarely get boxed in
+	for (int i = 0; i < (PATH_MAP_SIZE * PATH_MAP_SIZE) / 32; i++) {
+		if (rand() % 2 == 0)
+			juTileMapFill(map, rand() % PATH_MAP_SIZE, rand() % PATH_MAP_SIZE, 1 + (rand() % 8), 1, true);
+		else
+			juTileMapFill(map, rand() % PATH_MAP_SIZE, rand() % PATH_MAP_SIZE, 1, 1 + (rand() % 8), true);
+	}
+
+	// Agents start and end on open tiles and write into one of a few path buffers, the paths themselves aren't looked at
+	for (int i = 0; i < count; i++) {
+		do {
+			requests[i].startX = rand() % PATH_MAP_SIZE;
+			requests[i].startY = rand() % PATH_MAP_SIZE;
+			requests[i].goalX = rand() % PATH_MAP_SIZE;
+			requests[i].goalY = rand() % PATH_MAP_SIZE;
+		} while (juTileMapGet(map, requests[i].startX, requests[i].startY) || juTileMapGet(map, requests[i].goalX, requests[i].goalY));
+		requests[i].mode = JU_PATH_JPS;
+		requests[i].path = &paths[(i % BENCH_JOB_THREADS) * PATH_LENGTH];
+		requests[i].size = PATH_LENGTH;
+	}
+
+	int found = 0;
+	juClockStart(&clock);
+	for (int i = 0; i < count; i++)
+		found += juPathfinderFind(pathfinders[0], JU_PATH_ASTAR, requests[i].startX, requests[i].startY, requests[i].goalX, requests[i].goalY, paths, PATH_LENGTH) != -1;
+	benchReport("pathfinding", "astar", count, juClockTime(&clock), count, 0);
+
+	juClockStart(&clock);
+	for (int i = 0; i < count; i++)
+		found += juPathfinderFind(pathfinders[0], JU_PATH_JPS, requests[i].startX, requests[i].startY, requests[i].goalX, requests[i].goalY, paths, PATH_LENGTH) != -1;
+	benchReport("pathfinding", "jps", count, juClockTime(&clock), count, 0);
+
+	juClockStart(&clock);
+	juPathfinderQueue(pathfinders, BENCH_JOB_THREADS, requests, count, BENCH_JOB_CHANNEL);
+	juJobWaitChannel(BENCH_JOB_CHANNEL);
+	benchReport("pathfinding", "jps_jobs", count, juClockTime(&clock), count, 0);
+	for (int i = 0; i < count; i++)
+		found += requests[i].length != -1;
+	gBenchSink = found;
+
+	for (int i = 0; i < BENCH_JOB_THREADS; i++)
+		juPathfinderFree(pathfinders[i]);
+	juTileMapFree(map);
+	free(pathfinders);
+	free(paths);
+	free(requests);
+}
+
+static void benchFlowField(int count) {
+	JUClock clock;
+	JUTileMap map = juTileMapCreate(PATH_MAP_SIZE, PATH_MAP_SIZE, TILE_SIZE, TILE_SIZE);
+	JUFlowField *fields = malloc(sizeof(JUFlowField) * BENCH_JOB_THREADS);
+	double worldSize = PATH_MAP_SIZE * TILE_SIZE;
+	srand(count);
+
+	// Same walls as the pathfinding benchmark, every field chases the middle of the map
+	for (int i = 0; i < (PATH_MAP_SIZE * PATH_MAP_SIZE) / 32; i++) {
+		if (rand() % 2 == 0)
+			juTileMapFill(map, rand() % PATH_MAP_SIZE, rand() % PATH_MAP_SIZE, 1 + (rand() % 8), 1, true);
+		else
+			juTileMapFill(map, rand() % PATH_MAP_SIZE, rand() % PATH_MAP_SIZE, 1, 1 + (rand() % 8), true);
+	}
+	juTileMapSet(map, PATH_MAP_SIZE / 2, PATH_MAP_SIZE / 2, false);
+	for (int i = 0; i < BENCH_JOB_THREADS; i++) {
+		fields[i] = juFlowFieldCreate(map);
+		juFlowFieldSetGoal(fields[i], PATH_MAP_SIZE / 2, PATH_MAP_SIZE / 2);
+	}
+
+	juClockStart(&clock);
+	for (int frame = 0; frame < BENCH_FRAMES; frame++)
+		juFlowFieldBuild(fields[0], BENCH_JOB_CHANNEL);
+	benchReport("flowfield", "build", count, juClockTime(&clock) / BENCH_FRAMES, 1, 0);
+
+	juClockStart(&clock);
+	juFlowFieldQueue(fields, BENCH_JOB_THREADS, BENCH_JOB_CHANNEL);
+	juJobWaitChannel(BENCH_JOB_CHANNEL);
+	benchReport("flowfield", "build_jobs", count, juClockTime(&clock), BENCH_JOB_THREADS, 0);
+
+	// Walls going up and coming back down around the map
+	juClockStart(&clock);
+	for (int i = 0; i < count; i++) {
+		int x = rand() % (PATH_MAP_SIZE - 2);
+		int y = rand() % (PATH_MAP_SIZE - 2);
+		bool solid = (i % 2) == 0 && (x < (PATH_MAP_SIZE / 2) - 2 || x > (PATH_MAP_SIZE / 2) || y < (PATH_MAP_SIZE / 2) - 2 || y > (PATH_MAP_SIZE / 2));
+		juTileMapFill(map, x, y, 2, 2, solid);
+		juFlowFieldUpdate(fields[0], x, y, 2, 2);
+	}
+	benchReport("flowfield", "update", count, juClockTime(&clock), count, 0);
+
+	int moving = 0;
+	juClockStart(&clock);
+	for (int i = 0; i < count; i++) {
+		double directionX, directionY;
+		moving += juFlowFieldSample(fields[0], benchRandom(worldSize), benchRandom(worldSize), &directionX, &directionY);
+	}
+	benchReport("flowfield", "sample", count, juClockTime(&clock), count, 0);
+	gBenchSink = moving;
+
+	for (int i = 0; i < BENCH_JOB_THREADS; i++)
+		juFlowFieldFree(fields[i]);
+	juTileMapFree(map);
+	free(fields);
+}
+
+static void benchBatchCollisions(int count) {
+	JUClock clock;
+	double worldSize = sqrt((double)count) * GRID_WORLD_DENSITY;
+	double *fields = malloc(sizeof(double) * count * 4);
+	int32_t *indices = malloc(sizeof(int32_t) * count);
+	JURectangleBatch rects = {fields, fields + count, fields + (count * 2), fields + (count * 3), count};
+	JUCircleBatch circles = {rects.x, rects.y, rects.w, count};
+	JUPointBatch points = {rects.x, rects.y, count};
+	srand(count);
+	for (int i = 0; i < count; i++) {
+		JURectangle rect = benchRandomRectangle(worldSize);
+		fields[i] = rect.x;
+		fields[count + i] = rect.y;
+		fields[(count * 2) + i] = rect.w;
+		fields[(count * 3) + i] = rect.h;
+	}
+
+	// Each frame tests one shape against everything, first one at a time and then as a batch
+	double times[6] = {0};
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		JURectangle area = benchRandomRectangle(worldSize);
+		area.w *= 64;
+		area.h *= 64;
+		JUCircle circle = {area.x, area.y, area.w};
+		int hits = 0;
+
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++) {
+			JURectangle rect = {rects.x[j], rects.y[j], rects.w[j], rects.h[j]};
+			hits += juRectangleCollision(&area, &rect);
+		}
+		times[0] += juClockTime(&clock);
+		juClockStart(&clock);
+		hits += juRectangleCollisionBatch(&area, &rects, NULL, indices);
+		times[1] += juClockTime(&clock);
+
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++) {
+			JUCircle other = {circles.x[j], circles.y[j], circles.r[j]};
+			hits += juCircleCollision(&circle, &other);
+		}
+		times[2] += juClockTime(&clock);
+		juClockStart(&clock);
+		hits += juCircleCollisionBatch(&circle, &circles, NULL, indices);
+		times[3] += juClockTime(&clock);
+
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			hits += juPointInRectangle(&area, points.x[j], points.y[j]);
+		times[4] += juClockTime(&clock);
+		juClockStart(&clock);
+		hits += juPointInRectangleBatch(&area, &points, NULL, indices);
+		times[5] += juClockTime(&clock);
+		gBenchSink = hits;
+	}
+	benchReport("collision", "rectangle_scalar", count, times[0] / BENCH_FRAMES, count, 0);
+	benchReport("collision", "rectangle_batch", count, times[1] / BENCH_FRAMES, count, 0);
+	benchReport("collision", "circle_scalar", count, times[2] / BENCH_FRAMES, count, 0);
+	benchReport("collision", "circle_batch", count, times[3] / BENCH_FRAMES, count, 0);
+	benchReport("collision", "point_scalar", count, times[4] / BENCH_FRAMES, count, 0);
+	benchReport("collision", "point_batch", count, times[5] / BENCH_FRAMES, count, 0);
+
+	free(indices);
+	free(fields);
+}
+
+// The distance juPointDistance used to calculate, kept as a baseline for the math benchmarks
+static double benchPowfDistance(double x1, double y1, double x2, double y2) {
+	return sqrtf(powf(y2 - y1, 2) + powf(x2 - x1, 2));
+}
+
+static void benchMath(int count) {
+	JUClock clock;
+	double worldSize = sqrt((double)count) * GRID_WORLD_DENSITY;
+	JUCircle *circles = malloc(sizeof(JUCircle) * count);
+	JUCirclef *circlesf = malloc(sizeof(JUCirclef) * count);
+	srand(count);
+	for (int i = 0; i < count; i++) {
+		JURectangle rect = benchRandomRectangle(worldSize);
+		JUCircle circle = {rect.x, rect.y, rect.w};
+		JUCirclef circlef = {rect.x, rect.y, rect.w};
+		circles[i] = circle;
+		circlesf[i] = circlef;
+	}
+
+	// Each frame tests one circle against every circle with the old powf distance, squared doubles and squared floats
+	double times[6] = {0};
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		JURectangle area = benchRandomRectangle(worldSize);
+		JUCircle circle = {area.x, area.y, area.w * 64};
+		JUCirclef circlef = {area.x, area.y, area.w * 64};
+		int hits = 0;
+
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			hits += benchPowfDistance(circle.x, circle.y, circles[j].x, circles[j].y) < circle.r + circles[j].r;
+		times[0] += juClockTime(&clock);
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			hits += juCircleCollision(&circle, &circles[j]);
+		times[1] += juClockTime(&clock);
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			hits += juCircleCollisionf(&circlef, &circlesf[j]);
+		times[2] += juClockTime(&clock);
+
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			hits += benchPowfDistance(circle.x, circle.y, circles[j].x, circles[j].y) <= circle.r;
+		times[3] += juClockTime(&clock);
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			hits += juPointInCircle(&circle, circles[j].x, circles[j].y);
+		times[4] += juClockTime(&clock);
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++) {
+			JUVec2f point = {circlesf[j].x, circlesf[j].y};
+			hits += juPointInCirclef(&circlef, point);
+		}
+		times[5] += juClockTime(&clock);
+		gBenchSink = hits;
+	}
+	benchReport("math", "circle_powf", count, times[0] / BENCH_FRAMES, count, 0);
+	benchReport("math", "circle_squared", count, times[1] / BENCH_FRAMES, count, 0);
+	benchReport("math", "circle_float", count, times[2] / BENCH_FRAMES, count, 0);
+	benchReport("math", "point_in_circle_powf", count, times[3] / BENCH_FRAMES, count, 0);
+	benchReport("math", "point_in_circle_squared", count, times[4] / BENCH_FRAMES, count, 0);
+	benchReport("math", "point_in_circle_float", count, times[5] / BENCH_FRAMES, count, 0);
+
+	free(circlesf);
+	free(circles);
+}
+
+static void benchTrig(int count) {
+	JUClock clock;
+	double *x = malloc(sizeof(double) * count * 6);
+	double *y = x + count;
+	double *angles = x + (count * 2);
+	double *lengths = x + (count * 3);
+	double *outX = x + (count * 4);
+	double *outY = x + (count * 5);
+	JUPointBatch points = {x, y, count};
+	srand(count);
+	for (int i = 0; i < count; i++) {
+		x[i] = benchRandom(1000);
+		y[i] = benchRandom(1000);
+		angles[i] = benchRandom(VK2D_PI * 8) - (VK2D_PI * 4);
+		lengths[i] = benchRandom(100);
+	}
+
+	// Every loop writes its results somewhere so none of them can be optimized out
+	double times[9] = {0};
+	for (int i = 0; i < BENCH_FRAMES; i++) {
+		double rotation = angles[i % count];
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++) {
+			JUPoint2D point = juRotatePoint(x[j], y[j], 500, 500, rotation);
+			outX[j] = point.x;
+			outY[j] = point.y;
+		}
+		times[0] += juClockTime(&clock);
+		juClockStart(&clock);
+		juRotatePointBatch(&points, 500, 500, rotation, outX, outY);
+		times[1] += juClockTime(&clock);
+
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++) {
+			outX[j] = juCastX(lengths[j], rotation);
+			outY[j] = juCastY(lengths[j], rotation);
+		}
+		times[2] += juClockTime(&clock);
+		juClockStart(&clock);
+		juCastBatch(lengths, count, rotation, outX, outY);
+		times[3] += juClockTime(&clock);
+
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++) {
+			outX[j] = sin(angles[j]);
+			outY[j] = cos(angles[j]);
+		}
+		times[4] += juClockTime(&clock);
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			juFastSinCos(angles[j], &outX[j], &outY[j]);
+		times[5] += juClockTime(&clock);
+		juClockStart(&clock);
+		juFastSinCosBatch(angles, count, outX, outY);
+		times[6] += juClockTime(&clock);
+
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			outX[j] = atan2(y[j] - 500, x[j] - 500);
+		times[7] += juClockTime(&clock);
+		juClockStart(&clock);
+		for (int j = 0; j < count; j++)
+			outX[j] = juFastAtan2(y[j] - 500, x[j] - 500);
+		times[8] += juClockTime(&clock);
+		gBenchSink = (int)(outX[count / 2] + outY[count / 2]);
+	}
+	benchReport("trig", "rotate_scalar", count, times[0] / BENCH_FRAMES, count, 0);
+	benchReport("trig", "rotate_batch", count, times[1] / BENCH_FRAMES, count, 0);
+	benchReport("trig", "cast_scalar", count, times[2] / BENCH_FRAMES, count, 0);
+	benchReport("trig", "cast_batch", count, times[3] / BENCH_FRAMES, count, 0);
+	benchReport("trig", "sincos_libm", count, times[4] / BENCH_FRAMES, count, 0);
+	benchReport("trig", "sincos_fast", count, times[5] / BENCH_FRAMES, count, 0);
+	benchReport("trig", "sincos_batch", count, times[6] / BENCH_FRAMES, count, 0);
+	benchReport("trig", "atan2_libm", count, times[7] / BENCH_FRAMES, count, 0);
+	benchReport("trig", "atan2_fast", count, times[8] / BENCH_FRAMES, count, 0);
+
+	free(x);
+}
+
+static void benchJobs(int count) {
+	JUClock clock;
+	JUJob job = {BENCH_JOB_CHANNEL, benchEmptyJob, NULL};
+
+	juClockReset(&clock);
+	for (int i = 0; i < count; i++)
+		juJobQueue(job);
+	juJobWaitChannel(BENCH_JOB_CHANNEL);
+	benchReport("jobs", "throughput", count, juClockTime(&clock), count, 0);
+}
+
+/***************************** Main *****************************/
+
+int main(int argc, char **argv) {
+	juInit(NULL, BENCH_JOB_CHANNELS, BENCH_JOB_THREADS);
+	juECSAddComponents(COMPONENT_SIZES, COMPONENT_COUNT);
+	juECSAddSystems(SYSTEMS, SYSTEM_COUNT);
+
+	if (argc > 1) {
+		for (int i = 1; i < argc; i++) {
+			benchECS(atoi(argv[i]));
+			benchJobs(atoi(argv[i]));
+			benchSpatialGrid(atoi(argv[i]));
+			benchSweepAndPrune(atoi(argv[i]));
+			benchTileMap(atoi(argv[i]));
+			benchPathfinding(atoi(argv[i]));
+			benchFlowField(atoi(argv[i]));
+			benchBatchCollisions(atoi(argv[i]));
+			benchMath(atoi(argv[i]));
+			benchTrig(atoi(argv[i]));
+		}
+	} else {
+		for (int i = 0; i < DEFAULT_ENTITY_COUNT_COUNT; i++) {
+			benchECS(DEFAULT_ENTITY_COUNTS[i]);
+			benchJobs(DEFAULT_ENTITY_COUNTS[i]);
+			benchBatchCollisions(DEFAULT_ENTITY_COUNTS[i]);
+			benchMath(DEFAULT_ENTITY_COUNTS[i]);
+			benchTrig(DEFAULT_ENTITY_COUNTS[i]);
+		}
+		for (int i = 0; i < DEFAULT_GRID_COUNT_COUNT; i++) {
+			benchSpatialGrid(DEFAULT_GRID_COUNTS[i]);
+			benchSweepAndPrune(DEFAULT_GRID_COUNTS[i]);
+			benchTileMap(DEFAULT_GRID_COUNTS[i]);
+		}
+		for (int i = 0; i < DEFAULT_PATH_COUNT_COUNT; i++) {
+			benchPathfinding(DEFAULT_PATH_COUNTS[i]);
+			benchFlowField(DEFAULT_PATH_COUNTS[i]);
+		}
+	}
+
+	juQuit();
+	return 0;
+}
@@ -78,6 +78,21 @@ typedef enum {
 	COMPONENT_COUNT = 6,
 } Components;
 
+// Simulation can still be running while the main thread polls the keyboard, so systems read this snapshot instead
+typedef struct ResInput {
+	float moveX;
+	float moveY;
+} ResInput;
+
+size_t RESOURCE_SIZES[] = {
+		sizeof(struct ResInput),
+};
+
+typedef enum {
+	RESOURCE_INPUT = 0,
+	RESOURCE_COUNT = 1,
+} Resources;
+
 /************************ System functions ************************/
 
 void systemDraw(JUEntityID entity) {
@@ -119,8 +134,9 @@ void systemPlayerInput(JUEntityID entity) {
 	CompKinematics *kinematics = juECSGetComponent(COMPONENT_KINEMATICS, entity);
 	juECSLockWait(&kinematics->inputLock, 0);
 
-	kinematics->acceleration[0] = (-juKeyboardGetKey(SDL_SCANCODE_A) + juKeyboardGetKey(SDL_SCANCODE_D)) * ACCELERATION;
-	kinematics->acceleration[1] = (-juKeyboardGetKey(SDL_SCANCODE_W) + juKeyboardGetKey(SDL_SCANCODE_S)) * ACCELERATION;
+	const ResInput *input = juECSGetResource(RESOURCE_INPUT);
+	kinematics->acceleration[0] = input->moveX * ACCELERATION;
+	kinematics->acceleration[1] = input->moveY * ACCELERATION;
 
 	juECSLockNext(&kinematics->inputLock);
 }
@@ -151,7 +167,7 @@ JUComponent PHYSICS_COMPONENTS[] = {COMPONENT_POSITION, COMPONENT_KINEMATICS, CO
 JUComponent PLAYER_INPUT_COMPONENTS[] = {COMPONENT_KINEMATICS, COMPONENT_PLAYER_INPUT};
 JUComponent NPC_AI_COMPONENTS[] = {COMPONENT_KINEMATICS, COMPONENT_NPC_AI, COMPONENT_POSITION};
 JUSystem SYSTEMS[] = {
-		{DRAW_COMPONENTS, 2, systemDraw},
+		{DRAW_COMPONENTS, 2, systemDraw, 0, true},
 		{PHYSICS_COMPONENTS, 3, systemPhysics},
 		{PLAYER_INPUT_COMPONENTS, 2, systemPlayerInput},
 		{NPC_AI_COMPONENTS, 3, systemNPCAI},
@@ -185,13 +201,16 @@ int main() {
 	double totalTime = 0;
 	double iters = 0;
 	double average = 1;
+	bool showStats = false;
 	JUClock framerateTimer;
 	juClockReset(&framerateTimer);
 
 	// Load resources
 	JULoader loader = juLoaderCreate(FILES, FILE_COUNT);
 	juECSAddComponents(COMPONENT_SIZES, COMPONENT_COUNT);
+	juECSAddResources(RESOURCE_SIZES, RESOURCE_COUNT);
 	juECSAddSystems(SYSTEMS, SYSTEM_COUNT);
+	juECSSetPipeline(JU_PIPELINE_OVERLAPPED, true);
 
 	// Add player
 	CompPosition pos = {30, 30};
@@ -219,12 +238,22 @@ int main() {
 			}
 		}
 
+		// Input is only handed to systems once last frame's simulation is done with it
+		juJobWaitChannel(JU_JOB_CHANNEL_COPY);
+		ResInput *input = juECSGetResource(RESOURCE_INPUT);
+		input->moveX = -juKeyboardGetKey(SDL_SCANCODE_A) + juKeyboardGetKey(SDL_SCANCODE_D);
+		input->moveY = -juKeyboardGetKey(SDL_SCANCODE_W) + juKeyboardGetKey(SDL_SCANCODE_S);
+
 		vk2dRendererStartFrame(clearColour);
 		juECSRunSystems();
 
 		// Draw UI
-		juECSWaitSystemFinished(SYSTEM_DRAW);
+		juECSWaitRenderFinished();
 		juFontDraw(juLoaderGetFont(loader, "assets/comic.jufnt"), 0, 0, "FPS: %0.2f", 1.0 / average);
+		if (juKeyboardGetKeyPressed(SDL_SCANCODE_F3))
+			showStats = !showStats;
+		if (showStats)
+			juECSDrawStats(juLoaderGetFont(loader, "assets/comic.jufnt"), 0, 20);
 
 		juECSCopyState();
 